@@ -0,0 +1,39 @@
+//
+// cache_aligned.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BE_CACHE_ALIGNED_H
+#define BE_CACHE_ALIGNED_H
+
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+namespace BarelyEngine {
+/**
+ * @brief Allocates memory aligned to a cache line
+ *
+ * Plain `new` only guarantees the alignment of the fundamental types before
+ * C++17, ignoring `alignas(64)`, so classes which are written to by different
+ * threads (or hold an SpscRingBuffer by value) use this for their own
+ * `operator new` to keep off each other's cache lines.
+ *
+ * @param size the number of bytes to allocate
+ *
+ * @return the memory (free it with `std::free()`)
+ */
+inline void* cache_aligned_new(const size_t size)
+{
+  void* pointer = nullptr;
+
+  if (posix_memalign(&pointer, 64, size) != 0)
+  {
+    throw std::bad_alloc();
+  }
+
+  return pointer;
+}
+} // end of namespace BarelyEngine
+
+#endif // defined(BE_CACHE_ALIGNED_H)
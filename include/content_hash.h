@@ -0,0 +1,58 @@
+//
+// content_hash.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BE_CONTENT_HASH_H
+#define BE_CONTENT_HASH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace BarelyEngine {
+/**
+ * @brief Hashes the contents of resources, so identical ones can be spotted
+ *
+ * This is XXH64, which hashes several GB a second, so hashing a file costs
+ * far less than decoding it. It isn't a cryptographic hash.
+ */
+namespace ContentHash {
+/**
+ * @brief Hashes a block of memory
+ *
+ * @param data the memory to hash
+ * @param size the number of bytes to hash
+ * @param seed a seed, which gives a different hash for the same bytes
+ *
+ * @return the 64-bit hash
+ */
+uint64_t hash(const void* data, size_t size, uint64_t seed = 0);
+
+/**
+ * @brief Hashes the contents of a file
+ *
+ * The hash is remembered along with the file's size and modification time, so
+ * asking again for an unchanged file doesn't read it again. This is safe to
+ * call from several threads.
+ *
+ * @param path the path of the file
+ * @param hash set to the hash of the file's contents
+ *
+ * @return false if the file couldn't be read
+ */
+bool hash_file(const std::string& path, uint64_t& hash);
+
+/**
+ * @brief Mixes a value into a hash (e.g. the options a file is loaded with)
+ *
+ * @param hash the hash so far
+ * @param value the value to mix in
+ *
+ * @return the combined hash
+ */
+uint64_t combine(uint64_t hash, uint64_t value);
+} // end of namespace ContentHash
+} // end of namespace BarelyEngine
+
+#endif // defined(BE_CONTENT_HASH_H)
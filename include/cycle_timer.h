@@ -0,0 +1,110 @@
+//
+// cycle_timer.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BE_CYCLE_TIMER_H
+#define BE_CYCLE_TIMER_H
+
+#include <chrono>
+#include <cstdint>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+namespace BarelyEngine {
+/**
+ * @brief Reads the CPU's cycle counter, for timing very short intervals
+ *
+ * On x86 this is the time stamp counter (`rdtsc`), which costs a few
+ * nanoseconds to read, against the few tens a `steady_clock::now()` can cost.
+ * It's assumed to tick at a constant rate on every core (true of any x86 CPU
+ * from the last decade). Ticks are converted to time with a rate calibrated
+ * against `steady_clock` the first time it's needed, so only reading the
+ * results pays for the conversion.
+ *
+ * Elsewhere, the ticks are `steady_clock` nanoseconds.
+ */
+namespace CycleClock {
+/**
+ * @brief Reads the counter at the start of an interval
+ */
+inline uint64_t now()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  return __rdtsc();
+#else
+  return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+    std::chrono::steady_clock::now().time_since_epoch()).count());
+#endif
+}
+
+/**
+ * @brief Reads the counter at the end of an interval, once every instruction
+ *        before it has finished (so they're counted inside the interval)
+ */
+inline uint64_t now_serialized()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  unsigned int core;
+  return __rdtscp(&core);
+#else
+  return now();
+#endif
+}
+
+/**
+ * @brief Gets the number of ticks in a millisecond, calibrating it first if
+ *        this is the first call
+ */
+double ticks_per_millisecond();
+
+/**
+ * @brief Converts a number of ticks to milliseconds
+ */
+inline double to_milliseconds(const uint64_t ticks)
+{
+  return static_cast<double>(ticks) / ticks_per_millisecond();
+}
+} // end of namespace CycleClock
+
+/**
+ * @class CycleTimer
+ * @brief A Timer which reads the cycle counter, for timing intervals only a
+ *        few hundred nanoseconds long
+ */
+class CycleTimer
+{
+public:
+  /**
+   * @brief Construct a new timer
+   */
+  CycleTimer()
+    : then_(CycleClock::now()) {};
+
+  /**
+   * @brief Effectively starts/resets the timer and starts counting
+   */
+  inline void touch() { then_ = CycleClock::now(); }
+
+  /**
+   * @brief Returns the number of ticks since the timer was last touched
+   *
+   * @return the raw number of ticks elapsed since the last call to `touch()`
+   */
+  inline uint64_t ticks() const { return CycleClock::now_serialized() - then_; }
+
+  /*
+   * @brief Returns the number of milliseconds since the timer was last touched
+   *
+   * @return the number of milliseconds elapsed since the last call to `touch()`
+   */
+  inline double peek() const { return CycleClock::to_milliseconds(ticks()); }
+
+private:
+  /// The counter when the timer was last touched
+  uint64_t then_;
+};
+} // end of namespace BarelyEngine
+
+#endif // defined(BE_CYCLE_TIMER_H)
@@ -6,9 +6,12 @@
 #ifndef BE_ENGINE_H
 #define BE_ENGINE_H
 
+#include <memory>
+#include <mutex>
 #include <vector>
 
 namespace BarelyEngine {
+  class JobSystem;
   class Logger;
   enum class LogLevel;
 
@@ -20,9 +23,42 @@ class Engine
 {
 public:
   /**
-   * @brief Initialises various parts of the engine including SDL
+   * @brief Initialises various parts of the engine including the job system
+   *        (see `start_jobs()`) and SDL
+   *
+   * @param worker_count the number of job system worker threads (0 uses one
+   *        fewer than the number of cores)
+   */
+  static void init(size_t worker_count = 0);
+
+  /**
+   * @brief Shuts down what `init()` started: the job system is stopped (see
+   *        `stop_jobs()`) and SDL is quit
+   */
+  static void quit();
+
+  /**
+   * @brief Starts the job system on its own (without needing SDL, e.g. for
+   *        tools and tests). Does nothing if it's already running
+   *
+   * @param worker_count the number of worker threads (0 uses one fewer than
+   *        the number of cores)
    */
-  static void init();
+  static void start_jobs(size_t worker_count = 0);
+
+  /**
+   * @brief Stops the job system's workers, once any jobs still queued have
+   *        run. Does nothing if it isn't running
+   */
+  static void stop_jobs();
+
+  /**
+   * @brief Gets the job system shared by the whole engine
+   *
+   * @returns the job system (an Exception is thrown before `init()` or after
+   *          `quit()`)
+   */
+  static JobSystem& jobs();
 
   /**
    * @brief Registers a logger with the engine, that will be used
@@ -44,6 +80,9 @@ public:
    * @brief Log a message, through each registered logger. Does nothing if there
    *        are no loggers registered
    *
+   * It can be called from any thread (e.g. by loaders prefetching on worker
+   * threads), as logging is serialised by a lock.
+   *
    * @param level the level to log at
    * @param message the message to log
    * @param prefix the prefix to add to the log
@@ -55,11 +94,15 @@ public:
    *
    * @returns a vector of registered loggers
    */
-  static std::vector<Logger*> loggers() { return loggers_; }
+  static std::vector<Logger*> loggers();
 
 private:
   /// The list of loggers registered with the engine
   static std::vector<Logger*> loggers_;
+  /// Guards `loggers_` and the loggers themselves
+  static std::mutex loggers_mutex_;
+  /// The job system shared by the whole engine
+  static std::unique_ptr<JobSystem> jobs_;
 };
 } // end of namespace BarelyEngine
 
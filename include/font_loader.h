@@ -7,6 +7,7 @@
 #define BE_FONT_LOADER_H
 
 #include <memory>
+#include <string>
 #include "free_type/font_generator_fwd.h"
 #include "resource_loader.h"
 
@@ -21,6 +22,14 @@ struct LoaderOptions<FontLoader>
   int size;
 };
 
+/**
+ * @brief Reads a font option from a resource manifest
+ *
+ * The only option is `size` (a number of pixels).
+ */
+bool read_option(LoaderOptions<FontLoader>& options, const std::string& key,
+                 const std::string& value);
+
 /**
  * @class FontLoader
  * @brief Handles loading fonts from the file system, using FreeType2. Most font
@@ -47,6 +56,17 @@ public:
   std::unique_ptr<Font> load(const std::string& name,
                              const LoaderOptions<FontLoader>& options) override;
 
+  /**
+   * @brief Hashes the font's file and size
+   *
+   * @param filename the filename of the resource
+   * @param options the options used to load the font
+   *
+   * @return the hash, or 0 if the file can't be read
+   */
+  uint64_t content_hash(const std::string& filename,
+                        const LoaderOptions<FontLoader>& options) override;
+
 private:
   // Generates fonts using FreeType2
   std::unique_ptr<FreeType::FontGenerator> font_generator_;
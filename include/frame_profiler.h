@@ -6,9 +6,14 @@
 #ifndef BE_FRAME_PROFILER_H
 #define BE_FRAME_PROFILER_H
 
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include "cycle_timer.h"
 #include "pointer_hash.h"
 #include "ring_buffer.h"
-#include "timer.h"
+#include "spsc_ring_buffer.h"
 
 namespace BarelyEngine {
 /**
@@ -21,7 +26,38 @@ class FrameProfiler
 {
 public:
   using SampleBuffer = RingBuffer<float, 100>;
-  using SampleHash = PointerHash<const char*, SampleBuffer, 29>;
+  using SampleHash = PointerHash<const char*, SampleBuffer>;
+
+  /**
+   * @struct QueuedSample
+   * @brief A sample recorded on another thread, waiting to be collected
+   */
+  struct QueuedSample
+  {
+    /// The name of the sample
+    const char* name = nullptr;
+    /// The value of the sample
+    float value = 0.0f;
+  };
+
+  using SampleQueue = SpscRingBuffer<QueuedSample, 1024>;
+
+  /// The number of tick samples kept between conversions, after which the
+  /// oldest are overwritten
+  static const size_t kMaxTickSamples = 1024;
+
+  /**
+   * @struct TickSample
+   * @brief A scope's duration in raw cycle counter ticks, waiting to be
+   *        converted to milliseconds
+   */
+  struct TickSample
+  {
+    /// The name of the sample
+    const char* name;
+    /// The duration of the scope, in ticks
+    uint64_t ticks;
+  };
 
   // Forward-declare the Scope class
   class Scope;
@@ -46,6 +82,39 @@ public:
    */
   void add_sample(const char* name, float value);
 
+  /**
+   * @brief Add a duration measured with the cycle counter (see CycleClock)
+   *
+   * The duration is kept as ticks, and only converted to milliseconds when the
+   * samples are read (or the frame ends), keeping the conversion out of the
+   * code being profiled. Up to `kMaxTickSamples` are kept in the meantime; past
+   * that the oldest are overwritten (see `overwritten_tick_samples()`).
+   *
+   * @param name the name of the sample
+   * @param ticks the duration, in ticks
+   */
+  void add_tick_sample(const char* name, uint64_t ticks);
+
+  /**
+   * @brief Queue a generic float sample from a thread other than the one
+   *        driving the frames (e.g. a resource loading thread)
+   *
+   * The sample is handed over without locking and only lands in `samples()`
+   * once the frame thread collects it. Only one thread may queue samples, and
+   * samples are dropped if the queue fills up between collections.
+   *
+   * @param name the name of the sample
+   * @param value the float value to add
+   */
+  void queue_sample(const char* name, float value);
+
+  /**
+   * @brief Move samples queued from another thread into their sample buffers
+   *
+   * This is called automatically by `add_frame_sample()`.
+   */
+  void collect_queued_samples();
+
   /**
    * @brief Returns the buffer of frame time samples
    *
@@ -54,11 +123,23 @@ public:
   const SampleBuffer& frame_samples() const { return frame_samples_; }
 
   /**
-   * @brief Returns the array of samples
+   * @brief Returns the array of samples, converting any waiting tick samples
+   *        first (which doesn't change what the profiler has recorded, so it
+   *        can be done through a const profiler)
    *
    * @return an array of pairs containing the name and matching sample buffer
    */
-  const std::vector<SampleHash::ValueEntry>& samples() const { return samples_.pairs(); }
+  const std::vector<SampleHash::ValueEntry>& samples() const
+  {
+    convert_tick_samples();
+    return samples_.pairs();
+  }
+
+  /**
+   * @brief Gets the number of tick samples overwritten before they could be
+   *        converted
+   */
+  size_t overwritten_tick_samples() const { return overwritten_tick_samples_; }
 
   /**
    * @brief The static instance of the FrameProfiler
@@ -68,13 +149,30 @@ public:
   static FrameProfiler& instance() { return instance_; }
 
 private:
+  /**
+   * @brief Converts the waiting tick samples to milliseconds, adding them to
+   *        their sample buffers
+   */
+  void convert_tick_samples() const;
+
   /// The static instance of the FrameProfiler
   static FrameProfiler instance_;
 
   /// The buffer specifically for frame time samples (for FPS)
   SampleBuffer frame_samples_;
-  /// The buffer for generic float samples
-  SampleHash samples_;
+  /// The buffer for generic float samples (converting tick samples fills it
+  /// in when it's read)
+  mutable SampleHash samples_;
+  /// Tick samples waiting to be converted, as a ring
+  mutable std::array<TickSample, kMaxTickSamples> tick_samples_;
+  /// The index the next tick sample is written to
+  mutable size_t tick_head_ = 0;
+  /// The number of tick samples waiting to be converted
+  mutable size_t tick_count_ = 0;
+  /// The number of tick samples overwritten before they were converted
+  size_t overwritten_tick_samples_ = 0;
+  /// Samples queued from another thread, waiting to be collected
+  SampleQueue queued_samples_;
 };
 
 /**
@@ -99,12 +197,11 @@ public:
   /**
    * @brief Destructor
    *
-   * The duration are calculated here and then sent to the profiler
+   * The duration is sent to the profiler here, as raw cycle counter ticks
    */
   ~Scope()
   {
-    auto duration = timer_.peek();
-    profiler_.add_sample(name_, duration);
+    profiler_.add_tick_sample(name_, timer_.ticks());
   };
 
 private:
@@ -113,7 +210,7 @@ private:
   /// The name of the profile
   const char* name_;
   /// The timer used to time the lifetime of the object
-  Timer timer_;
+  CycleTimer timer_;
 };
 } // end of namespace BarelyEngine
 
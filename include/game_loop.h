@@ -0,0 +1,163 @@
+//
+// game_loop.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BE_GAME_LOOP_H
+#define BE_GAME_LOOP_H
+
+#include <cstddef>
+#include <functional>
+#include "timer.h"
+
+namespace BarelyEngine {
+/**
+ * @class GameLoop
+ * @brief Runs the game at a fixed update rate, rendering as often as the frame
+ *        rate (or VSync) allows
+ *
+ * Each frame, the time since the last frame is added to an accumulator and the
+ * update function is called once for every whole step in it, always with the
+ * same delta time, so the simulation is deterministic whatever the frame rate.
+ * The render function is then passed how far the accumulator is into the next
+ * step (0 - 1), to interpolate between the last two updates.
+ *
+ * With a frame rate set, each frame waits until its deadline by sleeping while
+ * there's comfortably enough time left and spinning for the remainder. How
+ * long a sleep really takes is measured as the loop runs, so it neither spins
+ * for longer than it has to nor oversleeps. With no frame rate, the loop runs
+ * flat out and relies on `Window::swap_buffer()` blocking for VSync.
+ *
+ * Every frame's time is sampled with PROFILE_FRAME, and the time spent waiting
+ * for the deadline as the "Frame wait" sample.
+ *
+ *    GameLoop loop{60, 0};
+ *    loop.run([&](double dt) { poll_events(); world.update(dt); },
+ *             [&](double alpha) { world.render(alpha); window.swap_buffer(); });
+ */
+class GameLoop
+{
+public:
+  /// The clock the loop is timed with
+  using clock = Timer::clock;
+  /// Called for each update, with the step in milliseconds
+  using UpdateFunction = std::function<void(double dt)>;
+  /// Called for each frame, with how far it is between the last two updates
+  using RenderFunction = std::function<void(double alpha)>;
+
+  /**
+   * @brief Construct a new GameLoop
+   *
+   * @param update_rate the number of updates per second
+   * @param frame_rate the maximum number of frames per second (0 for no limit)
+   *
+   * @throws Exception if the update rate isn't positive
+   */
+  explicit GameLoop(double update_rate = 60, double frame_rate = 0);
+
+  /**
+   * @brief Runs the loop until `stop()` is called (e.g. from an update)
+   *
+   * @param update the function called for each update
+   * @param render the function called for each frame
+   */
+  void run(const UpdateFunction& update, const RenderFunction& render);
+
+  /**
+   * @brief Stops the loop once the current update or frame has finished
+   */
+  void stop() { running_ = false; }
+
+  /**
+   * @brief Whether the loop is running
+   */
+  bool running() const { return running_; }
+
+  /**
+   * @brief Adds time to the accumulator and runs any whole steps in it
+   *
+   * At most `max_updates()` steps are run, and time beyond them is dropped,
+   * so a slow frame can't leave the loop forever trying to catch up.
+   *
+   * @param elapsed the time since the last frame, in milliseconds
+   * @param update the function called for each update
+   *
+   * @return the number of updates run
+   */
+  size_t advance(double elapsed, const UpdateFunction& update);
+
+  /**
+   * @brief Waits until a point in time, sleeping first and then spinning
+   *
+   * @param deadline the time to wait until
+   */
+  void wait_until(clock::time_point deadline);
+
+  /**
+   * @brief Gets how far the accumulator is into the next step (0 - 1)
+   */
+  double alpha() const { return accumulator_ / step_; }
+
+  /**
+   * @brief Gets the length of each update, in milliseconds
+   */
+  double step() const { return step_; }
+
+  /**
+   * @brief Sets the number of updates per second
+   *
+   * @throws Exception if the rate isn't positive
+   */
+  void set_update_rate(double update_rate);
+
+  /**
+   * @brief Sets the maximum number of frames per second (0 for no limit)
+   */
+  void set_frame_rate(double frame_rate);
+
+  /**
+   * @brief Gets the maximum number of updates run in a single frame
+   */
+  size_t max_updates() const { return max_updates_; }
+
+  /**
+   * @brief Sets the maximum number of updates run in a single frame
+   */
+  void set_max_updates(size_t max_updates) { max_updates_ = max_updates; }
+
+  /**
+   * @brief Gets how long a sleep is expected to take at worst, in
+   *        milliseconds (below this much time left, the wait spins)
+   */
+  double sleep_estimate() const { return sleep_estimate_; }
+
+private:
+  /**
+   * @brief Updates the sleep estimate with how long a sleep really took
+   *
+   * @param observed the length of the sleep, in milliseconds
+   */
+  void record_sleep(double observed);
+
+  /// The length of each update, in milliseconds
+  double step_;
+  /// The minimum length of each frame (0 for no limit)
+  clock::duration frame_period_;
+  /// The time which hasn't been simulated yet, in milliseconds
+  double accumulator_ = 0;
+  /// The maximum number of updates run in a single frame
+  size_t max_updates_ = 5;
+  /// Whether the loop is running
+  bool running_ = false;
+  /// The mean plus the standard deviation of the sleeps so far
+  double sleep_estimate_ = 5;
+  /// The mean of the sleeps so far
+  double sleep_mean_ = 5;
+  /// The sum of the squared differences from the mean (for the variance)
+  double sleep_m2_ = 0;
+  /// The number of sleeps measured
+  size_t sleep_count_ = 1;
+};
+} // end of namespace BarelyEngine
+
+#endif // defined(BE_GAME_LOOP_H)
@@ -0,0 +1,57 @@
+//
+// gfx/block_compressor.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BE_BLOCK_COMPRESSOR_H
+#define BE_BLOCK_COMPRESSOR_H
+
+#include <cstdint>
+#include <vector>
+#include "compressed_image.h"
+
+namespace BarelyEngine {
+/**
+ * @brief A simple CPU encoder for the BC1 and BC3 formats, for compressing
+ *        textures offline
+ *
+ * Endpoints are taken from the bounding box of each block's colors, which is
+ * quick and good enough for most sprites. It isn't meant to compete with the
+ * dedicated encoders, which should be used for BC7 and ETC2.
+ */
+namespace BlockCompressor {
+/**
+ * @brief Compresses one 4x4 block to BC1
+ *
+ * @param pixels the 16 pixels of the block as RGBA bytes, row by row
+ * @param block space for the 8 byte compressed block
+ */
+void compress_bc1_block(const uint8_t* pixels, uint8_t* block);
+
+/**
+ * @brief Compresses one 4x4 block to BC3
+ *
+ * @param pixels the 16 pixels of the block as RGBA bytes, row by row
+ * @param block space for the 16 byte compressed block
+ */
+void compress_bc3_block(const uint8_t* pixels, uint8_t* block);
+
+/**
+ * @brief Compresses a whole image
+ *
+ * Edges which aren't a multiple of 4 are padded by repeating the last row or
+ * column. Throws an Exception for formats which can't be encoded.
+ *
+ * @param pixels the pixels as tightly packed RGBA bytes
+ * @param width the width of the image
+ * @param height the height of the image
+ * @param format the format to compress to (BC1 or BC3)
+ *
+ * @return the compressed blocks, row by row
+ */
+std::vector<uint8_t> compress(const uint8_t* pixels, int width, int height,
+                              CompressedFormat format);
+} // end of namespace BlockCompressor
+} // end of namespace BarelyEngine
+
+#endif // defined(BE_BLOCK_COMPRESSOR_H)
@@ -0,0 +1,199 @@
+//
+// gfx/compressed_image.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BE_COMPRESSED_IMAGE_H
+#define BE_COMPRESSED_IMAGE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <OpenGL/gltypes.h>
+
+namespace BarelyEngine {
+/**
+ * @class enum CompressedFormat
+ * @brief The GPU block-compressed formats that can be loaded
+ *
+ * sRGB variants in files are loaded as their linear equivalents, matching the
+ * way uncompressed textures are treated.
+ */
+enum class CompressedFormat
+{
+  BC1,
+  BC3,
+  BC7,
+  ETC2_RGB,
+  ETC2_RGBA
+};
+
+/**
+ * @struct CompressedLevel
+ * @brief Describes where one mipmap level lives in the image data
+ */
+struct CompressedLevel
+{
+  /// Width of the level in pixels
+  int width;
+  /// Height of the level in pixels
+  int height;
+  /// Offset of the level's blocks into the image data
+  size_t offset;
+  /// Size of the level's blocks in bytes
+  size_t size;
+};
+
+/**
+ * @class CompressedImage
+ * @brief Block-compressed image data, ready to be handed straight to the GPU
+ *
+ * Images can be read from DDS (BC1, BC3 and BC7) and KTX2 (all formats)
+ * containers. The file is kept as it is and the levels simply point into it,
+ * so nothing is copied between reading the file and uploading it.
+ */
+class CompressedImage
+{
+public:
+  /**
+   * @brief Construct a new CompressedImage
+   *
+   * @param format the block format of the image
+   * @param data the raw data containing every level
+   * @param levels the mipmap levels, largest first
+   */
+  CompressedImage(CompressedFormat format, std::vector<uint8_t> data,
+                  std::vector<CompressedLevel> levels);
+
+  /**
+   * @brief Reads a DDS or KTX2 file from the file system
+   *
+   * Throws an Exception if the file can't be read or isn't supported.
+   *
+   * @param path the path of the file to read
+   *
+   * @return the image contained in the file
+   */
+  static std::unique_ptr<CompressedImage> load(const std::string& path);
+
+  /**
+   * @brief Reads an image from the contents of a DDS or KTX2 file, detecting
+   *        which it is from the file's signature
+   *
+   * Throws an Exception if the contents aren't valid or aren't supported.
+   *
+   * @param file the contents of the file
+   *
+   * @return the image contained in the file
+   */
+  static std::unique_ptr<CompressedImage> read(std::vector<uint8_t> file);
+
+  /**
+   * @brief Writes the image as the contents of a DDS file
+   *
+   * Throws an Exception for the ETC2 formats, which DDS can't hold.
+   *
+   * @return the contents of the file
+   */
+  std::vector<uint8_t> to_dds() const;
+
+  /**
+   * @brief Writes the image as the contents of a KTX2 file
+   *
+   * @return the contents of the file
+   */
+  std::vector<uint8_t> to_ktx2() const;
+
+  /**
+   * @brief Gets the size of a level of the given dimensions
+   *
+   * @param format the block format
+   * @param width the width of the level in pixels
+   * @param height the height of the level in pixels
+   *
+   * @return the size in bytes
+   */
+  static size_t level_size(CompressedFormat format, int width, int height);
+
+  /**
+   * @brief Gets the size of a single 4x4 block
+   *
+   * @param format the block format
+   *
+   * @return the size in bytes (8 or 16)
+   */
+  static size_t block_size(CompressedFormat format);
+
+  /**
+   * @brief Gets the block format
+   */
+  CompressedFormat format() const { return format_; }
+
+  /**
+   * @brief Gets the internal format to use when uploading with OpenGL
+   *
+   * @return the GLenum of the compressed internal format
+   */
+  GLenum gl_format() const { return gl_format(format_); }
+
+  /**
+   * @brief Gets the internal format to use when uploading a block format
+   *
+   * @param format the block format
+   *
+   * @return the GLenum of the compressed internal format
+   */
+  static GLenum gl_format(CompressedFormat format);
+
+  /**
+   * @brief Gets the width of the largest level
+   */
+  int width() const { return levels_.front().width; }
+
+  /**
+   * @brief Gets the height of the largest level
+   */
+  int height() const { return levels_.front().height; }
+
+  /**
+   * @brief Gets the mipmap levels, largest first
+   */
+  const std::vector<CompressedLevel>& levels() const { return levels_; }
+
+  /**
+   * @brief Gets the raw data the levels' offsets are relative to
+   */
+  const uint8_t* data() const { return data_.data(); }
+
+  /**
+   * @brief Gets the blocks of a level
+   *
+   * @param level the index of the level
+   *
+   * @return a pointer to the start of the level's blocks
+   */
+  const uint8_t* level_data(size_t level) const { return &data_[levels_[level].offset]; }
+
+private:
+  /**
+   * @brief Reads the contents of a DDS file
+   */
+  static std::unique_ptr<CompressedImage> read_dds(std::vector<uint8_t> file);
+
+  /**
+   * @brief Reads the contents of a KTX2 file
+   */
+  static std::unique_ptr<CompressedImage> read_ktx2(std::vector<uint8_t> file);
+
+  /// The block format of the image
+  CompressedFormat format_;
+  /// The raw data (which may include a file header)
+  std::vector<uint8_t> data_;
+  /// The mipmap levels, largest first
+  std::vector<CompressedLevel> levels_;
+};
+} // end of namespace BarelyEngine
+
+#endif // defined(BE_COMPRESSED_IMAGE_H)
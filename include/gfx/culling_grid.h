@@ -0,0 +1,104 @@
+//
+// gfx/culling_grid.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BE_CULLING_GRID_H
+#define BE_CULLING_GRID_H
+
+#include <vector>
+#include "rect.h"
+#include "spatial_hash_grid.h"
+
+namespace BarelyEngine {
+class RenderElement;
+
+/**
+ * @class CullingGrid
+ * @brief A uniform grid of element bounds, for finding the elements inside
+ *        the viewport without testing every element
+ *
+ * Each element is filed under every cell its bounds overlap, so a query only
+ * looks at the elements in the cells the viewport overlaps. The cell size
+ * should be around the size of the viewport (or a fraction of it), and
+ * elements much larger than a cell are fine but cost a little more to insert.
+ *
+ * The grid is kept from frame to frame, as filing every element costs more
+ * than testing its bounds would: insert elements as they're created,
+ * `update()` them when their vertices change and `remove()` them when they go,
+ * then query once a frame.
+ */
+class CullingGrid
+{
+public:
+  /// Refers to an element in the grid
+  using Handle = SpatialHashGrid<const RenderElement*>::Handle;
+
+  /**
+   * @brief Construct an empty grid
+   *
+   * @param cell_size the width and height of each cell (which must be
+   *        positive)
+   */
+  CullingGrid(float cell_size);
+
+  /**
+   * @brief Adds an element to the grid (which must outlive it, or be removed
+   *        first). Elements whose bounds aren't finite are kept, but never
+   *        found until they're updated with finite ones.
+   *
+   * @param render_element the element to add
+   *
+   * @return the handle of the element
+   */
+  Handle insert(const RenderElement* render_element);
+
+  /**
+   * @brief Refiles an element whose bounds have changed (e.g. it has moved)
+   *
+   * @param handle the handle of the element
+   */
+  void update(Handle handle);
+
+  /**
+   * @brief Removes an element from the grid (its handle may be reused)
+   *
+   * @param handle the handle of the element (which mustn't have been removed
+   *        already)
+   */
+  void remove(Handle handle);
+
+  /**
+   * @brief Removes every element from the grid
+   */
+  void clear();
+
+  /**
+   * @brief Finds the elements whose bounds overlap a rectangle
+   *
+   * @param viewport the rectangle to look in
+   * @param visible cleared, then filled with the elements found, in sort key
+   *        order (see `RenderElement::id()`) so they batch well
+   */
+  void query(const Rect& viewport, std::vector<const RenderElement*>& visible);
+
+  /**
+   * @brief Gets the number of elements in the grid
+   */
+  size_t size() const { return grid_.size(); }
+
+private:
+  /**
+   * @brief Gets the bounds to file an element under, which are empty if its
+   *        own aren't finite (as the grid can't file them)
+   */
+  static Rect filed_bounds(const RenderElement* render_element);
+
+  /// The elements, filed by their bounds
+  SpatialHashGrid<const RenderElement*> grid_;
+  /// Scratch space for the handles found by a query
+  std::vector<SpatialHashGrid<const RenderElement*>::Handle> found_;
+};
+} // end of namespace BarelyEngine
+
+#endif // defined(BE_CULLING_GRID_H)
@@ -54,6 +54,15 @@ private:
   /// Glyph metrics for each glyph supported by the font
   GlyphMetricsArray metrics_;
 };
+
+/**
+ * @brief Gets the memory a font (and its atlas) uses, for ResourceManager's
+ *        accounting
+ */
+inline ResourceMemory resource_memory(const Font& font)
+{
+  return {sizeof(Font) + font.texture()->cpu_size(), font.texture()->gpu_size()};
+}
 } // end of namespace BarelyEngine
 
 #endif // defined(BE_FONT_H)
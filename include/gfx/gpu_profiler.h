@@ -0,0 +1,234 @@
+//
+// gfx/gpu_profiler.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BE_GPU_PROFILER_H
+#define BE_GPU_PROFILER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#include <OpenGL/gl3.h>
+
+/// Token-pasting helpers for create unique variable names
+#define GPU_SCOPE_VARIABLE(line) gpu_scope_##line
+#define CREATE_GPU_SCOPE(name, line) BarelyEngine::GpuProfiler::Scope GPU_SCOPE_VARIABLE(line){BarelyEngine::GpuProfiler::instance(), name};
+/// Time a particular scope on the GPU
+#define PROFILE_GPU_SCOPE(name) CREATE_GPU_SCOPE(name, __LINE__)
+
+namespace BarelyEngine {
+class FrameProfiler;
+
+/**
+ * @class GpuQueryBackend
+ * @brief The timestamp queries a GpuProfiler is built on
+ *
+ * `opengl()` is the one the engine uses; anything else is for testing the
+ * profiler without an OpenGL context.
+ */
+class GpuQueryBackend
+{
+public:
+  virtual ~GpuQueryBackend() {}
+
+  /**
+   * @brief Generates new queries
+   *
+   * @param count the number of queries to generate
+   * @param queries the array to write the new queries to
+   */
+  virtual void generate(size_t count, GLuint* queries) = 0;
+
+  /**
+   * @brief Deletes queries
+   *
+   * @param count the number of queries to delete
+   * @param queries the queries to delete
+   */
+  virtual void destroy(size_t count, const GLuint* queries) = 0;
+
+  /**
+   * @brief Writes the GPU's time to a query once the commands before it have
+   *        finished
+   */
+  virtual void write_timestamp(GLuint query) = 0;
+
+  /**
+   * @brief Checks whether a query's result is ready, without waiting
+   */
+  virtual bool available(GLuint query) = 0;
+
+  /**
+   * @brief Gets a query's result (a timestamp, in nanoseconds), waiting for it
+   *        if it isn't ready
+   */
+  virtual uint64_t result(GLuint query) = 0;
+
+  /**
+   * @brief The backend using OpenGL's timer queries
+   *
+   * @return the instance of the OpenGL backend
+   */
+  static GpuQueryBackend& opengl();
+};
+
+/**
+ * @class GpuProfiler
+ * @brief Times how long the GPU spends on parts of a frame, reporting them as
+ *        FrameProfiler samples
+ *
+ * Each scope writes a `GL_TIMESTAMP` query (with `glQueryCounter()`) as it
+ * begins and ends, so scopes can be nested, unlike `GL_TIME_ELAPSED` queries.
+ * The GPU runs behind the CPU, so a frame's results are only read back once
+ * `latency` more frames have ended, by which time they're ready and reading
+ * them doesn't stall. If they still aren't ready, that frame's samples are
+ * dropped rather than waited for.
+ *
+ * The samples are added to the FrameProfiler under the scope's name, in
+ * milliseconds, just like PROFILE_SCOPE's (so give GPU scopes their own
+ * names, e.g. "Flush (GPU)").
+ *
+ * Timer queries are core in OpenGL 3.3, so this works on any context the
+ * engine runs on (including Mesa's software renderers). No OpenGL calls are
+ * made until the first scope begins, and the queries must be deleted with
+ * `release()` while the context is still around (the Window does this for
+ * `instance()`).
+ */
+class GpuProfiler
+{
+public:
+  // Forward-declare the Scope class
+  class Scope;
+
+  /**
+   * @brief Construct a new GpuProfiler
+   *
+   * @param latency the number of frames to wait before reading results back
+   *        (2 for double-buffering, 3 for triple-buffering)
+   * @param backend the queries to time with (which must outlive the profiler)
+   */
+  explicit GpuProfiler(size_t latency = 3, GpuQueryBackend& backend = GpuQueryBackend::opengl());
+
+  GpuProfiler(const GpuProfiler& other) = delete;
+  GpuProfiler& operator=(const GpuProfiler& other) = delete;
+
+  /**
+   * @brief Starts timing a scope
+   *
+   * @param name the name of the sample
+   */
+  void begin(const char* name);
+
+  /**
+   * @brief Stops timing the scope most recently begun
+   */
+  void end();
+
+  /**
+   * @brief Finishes the frame, adding the results of the frame which ended
+   *        `latency` frames before this one to a profiler
+   *
+   * Call it once a frame, after swapping the buffers. With a latency of 2, the
+   * results of frame 1 are added as frame 3 ends.
+   *
+   * @param profiler the profiler to add the samples to
+   */
+  void end_frame(FrameProfiler& profiler);
+
+  /**
+   * @brief Gets the number of frames whose samples were dropped because their
+   *        results weren't ready in time
+   */
+  size_t dropped_frames() const { return dropped_frames_; }
+
+  /**
+   * @brief Deletes every query, dropping the frames still in flight
+   *
+   * The profiler doesn't delete its queries on destruction, as `instance()`
+   * outlives the OpenGL context, so call this before the context is deleted.
+   * The profiler can still be used afterwards (on a new context).
+   */
+  void release();
+
+  /**
+   * @brief The static instance of the GpuProfiler
+   *
+   * @return the instance of the GpuProfiler
+   */
+  static GpuProfiler& instance();
+
+private:
+  /**
+   * @struct Sample
+   * @brief A scope's name and the queries timing it
+   */
+  struct Sample
+  {
+    /// The name of the sample
+    const char* name;
+    /// The timestamp query written when the scope began
+    GLuint start;
+    /// The timestamp query written when the scope ended (0 until it has)
+    GLuint end;
+  };
+
+  /**
+   * @brief Takes a query from the pool, generating more if it's empty
+   */
+  GLuint take_query();
+
+  /**
+   * @brief Reads a frame's results back (if they're ready) and returns its
+   *        queries to the pool
+   */
+  void collect(std::vector<Sample>& frame, FrameProfiler& profiler);
+
+  /// The queries the profiler times with
+  GpuQueryBackend* backend_;
+  /// The samples of each frame in flight (`latency + 1`, as the frame being
+  /// recorded takes one too)
+  std::vector<std::vector<Sample>> frames_;
+  /// The index of the frame being recorded
+  size_t current_ = 0;
+  /// The samples in the current frame which have begun but not ended
+  std::vector<size_t> open_;
+  /// Queries which aren't in use
+  std::vector<GLuint> pool_;
+  /// Every query generated (to delete them)
+  std::vector<GLuint> queries_;
+  /// The number of frames whose samples were dropped
+  size_t dropped_frames_ = 0;
+};
+
+/**
+ * @class GpuProfiler::Scope
+ * @brief Times a particular scope on the GPU (e.g. a flush)
+ */
+class GpuProfiler::Scope
+{
+public:
+  /**
+   * @brief Construct a new Scope, beginning the timing
+   *
+   * @param profiler the GpuProfiler to time the scope with
+   * @param name the name of the profile
+   */
+  Scope(GpuProfiler& profiler, const char* name)
+    : profiler_(profiler)
+  {
+    profiler_.begin(name);
+  }
+
+  /**
+   * @brief Destructor, ending the timing
+   */
+  ~Scope() { profiler_.end(); }
+
+private:
+  /// The profiler timing the scope
+  GpuProfiler& profiler_;
+};
+} // end of namespace BarelyEngine
+
+#endif // defined(BE_GPU_PROFILER_H)
@@ -0,0 +1,463 @@
+//
+// gfx/loose_quadtree.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BE_LOOSE_QUADTREE_H
+#define BE_LOOSE_QUADTREE_H
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <vector>
+#include "rect.h"
+#include "exception.h"
+
+namespace BarelyEngine {
+/**
+ * @class LooseQuadtree
+ * @brief A quadtree over a fixed area, whose nodes are loose (each one holds
+ *        items overlapping up to half a node beyond its edges)
+ *
+ * Looseness means every item lives in exactly one node, picked straight from
+ * its size and centre without walking the tree: the smallest node at least as
+ * big as the item, containing its centre. That makes `move()` cheap (usually
+ * nothing changes) and suits items of very different sizes, where
+ * SpatialHashGrid would file large items under many cells.
+ *
+ * The nodes of each level are stored as a flat grid, so queries go level by
+ * level over just the nodes that can overlap the area. Items outside of the
+ * tree's area (or bigger than it) are kept in the root, and always checked.
+ *
+ * Every node is allocated up front: level n has 4^n nodes, each an empty
+ * vector (24 bytes on 64-bit platforms) until items are filed under it. A
+ * depth of 8 takes about 2 MB, and the deepest allowed, kMaxDepth, about
+ * 34 MB.
+ *
+ * Items are referred to by the handle `insert()` returns, and queries return
+ * the items themselves (usually pointers), in no particular order.
+ */
+template <typename T>
+class LooseQuadtree
+{
+public:
+  /// Refers to an item in the tree
+  using Handle = uint32_t;
+
+  /// The deepest the tree can be
+  static const int kMaxDepth = 10;
+
+  /**
+   * @brief Construct an empty tree
+   *
+   * @param area the area the tree covers (items can still be outside it)
+   * @param depth the number of levels below the root (the smallest nodes are
+   *        1 / 2^depth of the area across), clamped to kMaxDepth
+   *
+   * @throws Exception if the area isn't finite with a positive size
+   */
+  LooseQuadtree(const Rect& area, int depth);
+
+  /**
+   * @brief Adds an item to the tree
+   *
+   * @param item the item to add
+   * @param bounds the bounds of the item
+   *
+   * @return the handle of the item
+   */
+  Handle insert(const T& item, const Rect& bounds);
+
+  /**
+   * @brief Updates the bounds of an item
+   *
+   * @param handle the handle of the item
+   * @param bounds the new bounds of the item
+   */
+  void move(Handle handle, const Rect& bounds);
+
+  /**
+   * @brief Removes an item from the tree (its handle may be reused)
+   *
+   * @param handle the handle of the item (which mustn't have been removed
+   *        already)
+   */
+  void remove(Handle handle);
+
+  /**
+   * @brief Refiles every item in one pass, optionally over a new area (e.g.
+   *        after the level has been loaded)
+   *
+   * @param area the new area to cover (empty, or not finite, keeps the
+   *        current area)
+   */
+  void rebuild(const Rect& area = {});
+
+  /**
+   * @brief Removes every item from the tree
+   */
+  void clear();
+
+  /**
+   * @brief Finds the items whose bounds overlap a rectangle (nothing is found
+   *        if it isn't finite)
+   *
+   * @param area the rectangle to look in
+   * @param found filled with the items found (it isn't cleared first)
+   */
+  void query(const Rect& area, std::vector<T>& found) const;
+
+  /**
+   * @brief Finds the items whose bounds contain a point (e.g. for picking)
+   *
+   * @param x the x position of the point
+   * @param y the y position of the point
+   * @param found filled with the items found (it isn't cleared first)
+   */
+  void query(float x, float y, std::vector<T>& found) const;
+
+  /**
+   * @brief Gets an item
+   */
+  const T& item(Handle handle) const { return items_[handle].item; }
+
+  /**
+   * @brief Gets the bounds of an item
+   */
+  const Rect& bounds(Handle handle) const { return items_[handle].bounds; }
+
+  /**
+   * @brief Gets the number of items in the tree
+   */
+  size_t size() const { return items_.size() - free_.size(); }
+
+private:
+  /**
+   * @struct Item
+   * @brief An item and the node it is filed under
+   */
+  struct Item
+  {
+    /// The item
+    T item;
+    /// The bounds of the item
+    Rect bounds;
+    /// The index of the node the item is in
+    uint32_t node;
+    /// The position of the item in its node
+    uint32_t slot;
+    /// Whether the handle is in use
+    bool alive;
+  };
+
+  /**
+   * @brief Checks whether an area is finite with a positive size, so it can be
+   *        split into nodes
+   */
+  static bool valid_area(const Rect& area)
+  {
+    return area.w > 0 && area.h > 0 && std::isfinite(area.x) && std::isfinite(area.y) &&
+           std::isfinite(area.w) && std::isfinite(area.h);
+  }
+
+  /**
+   * @brief Picks the node an item with some bounds belongs in
+   */
+  uint32_t node_for(const Rect& bounds) const;
+
+  /**
+   * @brief Files an item under a node
+   */
+  void add_to_node(Handle handle, uint32_t node);
+
+  /**
+   * @brief Removes an item from its node
+   */
+  void remove_from_node(Handle handle);
+
+  /**
+   * @brief Sets up the (empty) nodes of every level
+   */
+  void allocate_nodes();
+
+  /// The area the tree covers
+  Rect area_;
+  /// The number of levels below the root
+  int depth_;
+  /// The index of the first node of each level
+  std::vector<uint32_t> level_starts_;
+  /// The number of items in each level
+  std::vector<uint32_t> level_counts_;
+  /// The handles of the items in each node, level by level
+  std::vector<std::vector<Handle>> nodes_;
+  /// Every item, indexed by handle
+  std::vector<Item> items_;
+  /// The handles of removed items, to be reused
+  std::vector<Handle> free_;
+};
+
+template <typename T>
+const int LooseQuadtree<T>::kMaxDepth;
+
+template <typename T>
+LooseQuadtree<T>::LooseQuadtree(const Rect& area, const int depth)
+  : area_(area)
+  , depth_(std::min(std::max(depth, 0), kMaxDepth))
+{
+  if (!valid_area(area))
+  {
+    throw Exception("Quadtrees must cover a finite area with a positive size");
+  }
+
+  allocate_nodes();
+}
+
+template <typename T>
+typename LooseQuadtree<T>::Handle LooseQuadtree<T>::insert(const T& item, const Rect& bounds)
+{
+  Handle handle;
+
+  if (free_.empty())
+  {
+    handle = static_cast<Handle>(items_.size());
+    items_.push_back({});
+  }
+  else
+  {
+    handle = free_.back();
+    free_.pop_back();
+  }
+
+  items_[handle] = {item, bounds, 0, 0, true};
+  add_to_node(handle, node_for(bounds));
+
+  return handle;
+}
+
+template <typename T>
+void LooseQuadtree<T>::move(const Handle handle, const Rect& bounds)
+{
+  const auto node = node_for(bounds);
+
+  items_[handle].bounds = bounds;
+
+  // The loose edges mean small moves rarely change the node
+  if (node != items_[handle].node)
+  {
+    remove_from_node(handle);
+    add_to_node(handle, node);
+  }
+}
+
+template <typename T>
+void LooseQuadtree<T>::remove(const Handle handle)
+{
+  // Removing twice would put the handle on the free list twice
+  assert(items_[handle].alive);
+
+  remove_from_node(handle);
+  items_[handle].alive = false;
+  free_.push_back(handle);
+}
+
+template <typename T>
+void LooseQuadtree<T>::rebuild(const Rect& area)
+{
+  if (valid_area(area))
+  {
+    area_ = area;
+  }
+
+  for (auto& node : nodes_)
+  {
+    node.clear();
+  }
+
+  std::fill(level_counts_.begin(), level_counts_.end(), 0);
+
+  for (Handle handle = 0; handle < items_.size(); handle++)
+  {
+    if (items_[handle].alive)
+    {
+      add_to_node(handle, node_for(items_[handle].bounds));
+    }
+  }
+}
+
+template <typename T>
+void LooseQuadtree<T>::clear()
+{
+  items_.clear();
+  free_.clear();
+
+  for (auto& node : nodes_)
+  {
+    node.clear();
+  }
+
+  std::fill(level_counts_.begin(), level_counts_.end(), 0);
+}
+
+template <typename T>
+void LooseQuadtree<T>::query(const Rect& area, std::vector<T>& found) const
+{
+  if (!std::isfinite(area.x) || !std::isfinite(area.y) || !std::isfinite(area.w) ||
+      !std::isfinite(area.h))
+  {
+    return;
+  }
+
+  for (int level = 0; level <= depth_; level++)
+  {
+    if (level_counts_[level] == 0)
+    {
+      continue;
+    }
+
+    const auto nodes_across = 1 << level;
+    const auto node_w = area_.w / nodes_across;
+    const auto node_h = area_.h / nodes_across;
+
+    // The root also holds anything which doesn't fit in the tree, so every
+    // item in it is checked
+    auto min_column = 0, min_row = 0, max_column = 0, max_row = 0;
+
+    if (level > 0)
+    {
+      // Items stick out up to half a node past their node's edges. The index
+      // is clamped before it's converted, as a huge area's may not fit an int
+      const auto last = static_cast<float>(nodes_across - 1);
+      const auto column = [&](const float x)
+      {
+        return static_cast<int>(std::min(std::max(std::floor((x - area_.x) / node_w), 0.0f), last));
+      };
+      const auto row = [&](const float y)
+      {
+        return static_cast<int>(std::min(std::max(std::floor((y - area_.y) / node_h), 0.0f), last));
+      };
+
+      // Skip the level if the area is wholly past the loose edges of the tree
+      if (area.x + area.w < area_.x - node_w / 2 || area.x > area_.x + area_.w + node_w / 2 ||
+          area.y + area.h < area_.y - node_h / 2 || area.y > area_.y + area_.h + node_h / 2)
+      {
+        continue;
+      }
+
+      min_column = column(area.x - node_w / 2);
+      max_column = column(area.x + area.w + node_w / 2);
+      min_row = row(area.y - node_h / 2);
+      max_row = row(area.y + area.h + node_h / 2);
+    }
+
+    for (auto row = min_row; row <= max_row; row++)
+    {
+      for (auto column = min_column; column <= max_column; column++)
+      {
+        const auto& node = nodes_[level_starts_[level] + row * nodes_across + column];
+
+        for (const auto handle : node)
+        {
+          if (items_[handle].bounds.intersects(area))
+          {
+            found.push_back(items_[handle].item);
+          }
+        }
+      }
+    }
+  }
+}
+
+template <typename T>
+void LooseQuadtree<T>::query(const float x, const float y, std::vector<T>& found) const
+{
+  query(Rect{x, y, 0, 0}, found);
+}
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+template <typename T>
+uint32_t LooseQuadtree<T>::node_for(const Rect& bounds) const
+{
+  const auto centre_x = bounds.x + bounds.w / 2;
+  const auto centre_y = bounds.y + bounds.h / 2;
+
+  if (!area_.contains(centre_x, centre_y))
+  {
+    return 0;
+  }
+
+  // The deepest level whose nodes are still at least as big as the item
+  auto level = depth_;
+  const auto size = std::max(bounds.w / area_.w, bounds.h / area_.h);
+
+  if (size > 0)
+  {
+    level = std::min(depth_, static_cast<int>(std::floor(-std::log2(size))));
+  }
+
+  if (level <= 0)
+  {
+    return 0;
+  }
+
+  const auto nodes_across = 1 << level;
+  const auto column = std::min(static_cast<int>((centre_x - area_.x) / area_.w * nodes_across),
+                               nodes_across - 1);
+  const auto row = std::min(static_cast<int>((centre_y - area_.y) / area_.h * nodes_across),
+                            nodes_across - 1);
+
+  return level_starts_[level] + static_cast<uint32_t>(row * nodes_across + column);
+}
+
+template <typename T>
+void LooseQuadtree<T>::add_to_node(const Handle handle, const uint32_t node)
+{
+  auto& item = items_[handle];
+
+  item.node = node;
+  item.slot = static_cast<uint32_t>(nodes_[node].size());
+  nodes_[node].push_back(handle);
+
+  const auto level = std::upper_bound(level_starts_.begin(), level_starts_.end(), node) -
+                     level_starts_.begin() - 1;
+  level_counts_[level]++;
+}
+
+template <typename T>
+void LooseQuadtree<T>::remove_from_node(const Handle handle)
+{
+  const auto& item = items_[handle];
+  auto& node = nodes_[item.node];
+
+  // Move the last item of the node into the gap
+  node[item.slot] = node.back();
+  items_[node[item.slot]].slot = item.slot;
+  node.pop_back();
+
+  const auto level = std::upper_bound(level_starts_.begin(), level_starts_.end(), item.node) -
+                     level_starts_.begin() - 1;
+  level_counts_[level]--;
+}
+
+template <typename T>
+void LooseQuadtree<T>::allocate_nodes()
+{
+  uint32_t total = 0;
+
+  for (int level = 0; level <= depth_; level++)
+  {
+    level_starts_.push_back(total);
+    total += uint32_t(1) << (2 * level);
+  }
+
+  level_counts_.assign(static_cast<size_t>(depth_ + 1), 0);
+  nodes_.resize(total);
+}
+} // end of namespace BarelyEngine
+
+#endif // defined(BE_LOOSE_QUADTREE_H)
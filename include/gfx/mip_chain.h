@@ -0,0 +1,75 @@
+//
+// gfx/mip_chain.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BE_MIP_CHAIN_H
+#define BE_MIP_CHAIN_H
+
+#include <cstdint>
+#include <vector>
+
+namespace BarelyEngine {
+/**
+ * @class enum MipFilter
+ * @brief The filters available for generating mipmaps
+ */
+enum class MipFilter
+{
+  /// Averages each 2x2 square (quickest, but a little blurry)
+  BOX,
+  /// A Kaiser-windowed sinc over 6x6 pixels (sharper, for offline use)
+  KAISER
+};
+
+/**
+ * @struct MipLevel
+ * @brief The pixels of a single mipmap level
+ */
+struct MipLevel
+{
+  /// Width of the level in pixels
+  int width;
+  /// Height of the level in pixels
+  int height;
+  /// The tightly packed 4-byte pixels
+  std::vector<uint8_t> pixels;
+};
+
+/**
+ * @brief Generates mipmap chains on the CPU
+ *
+ * Each level is filtered from the one above it, halving the size (rounding
+ * down, but never below 1) until reaching 1x1. All 4 channels are filtered in
+ * the same way, so the channel order doesn't matter.
+ *
+ * This is meant to run when a texture is decoded, which may be on a loader
+ * thread, rather than asking the driver to generate the chain on upload.
+ */
+namespace MipChain {
+/**
+ * @brief Generates every level below a base level
+ *
+ * @param pixels the tightly packed 4-byte pixels of the base level
+ * @param width the width of the base level
+ * @param height the height of the base level
+ * @param filter the filter to use
+ *
+ * @return the levels, starting with level 1 (half the size of the base)
+ */
+std::vector<MipLevel> generate(const uint8_t* pixels, int width, int height,
+                               MipFilter filter = MipFilter::BOX);
+
+/**
+ * @brief Gets the number of levels in a full chain, including the base level
+ *
+ * @param width the width of the base level
+ * @param height the height of the base level
+ *
+ * @return the number of levels
+ */
+int level_count(int width, int height);
+} // end of namespace MipChain
+} // end of namespace BarelyEngine
+
+#endif // defined(BE_MIP_CHAIN_H)
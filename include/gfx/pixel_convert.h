@@ -0,0 +1,75 @@
+//
+// gfx/pixel_convert.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BE_PIXEL_CONVERT_H
+#define BE_PIXEL_CONVERT_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace BarelyEngine {
+/**
+ * @brief Kernels for converting between pixel layouts before uploading
+ *
+ * Each kernel works on a run of `count` pixels of 8-bit channels, as laid out
+ * in memory (so "RGBA" means the bytes R, G, B, A in that order). They are
+ * vectorised with SSE2/SSSE3/AVX2 when the engine is compiled with those
+ * instruction sets enabled and fall back to plain loops otherwise. Every
+ * version produces exactly the same output.
+ *
+ * The kernels which keep 4 bytes per pixel work in place.
+ */
+namespace PixelConvert {
+/**
+ * @brief Expands 3-byte pixels to 4-byte pixels with an opaque alpha,
+ *        keeping the channel order (RGB -> RGBA, BGR -> BGRA)
+ *
+ * @param source the 3-byte pixels
+ * @param target space for the 4-byte pixels (must not overlap the source)
+ * @param count the number of pixels
+ */
+void expand_rgb(const uint8_t* source, uint8_t* target, size_t count);
+
+/**
+ * @brief Expands 1-byte palette indices to 4-byte pixels
+ *
+ * @param source the palette indices
+ * @param target space for the 4-byte pixels (must not overlap the source)
+ * @param count the number of pixels
+ * @param palette 256 4-byte colors, in the order they should be written
+ */
+void expand_palette(const uint8_t* source, uint8_t* target, size_t count,
+                    const uint32_t* palette);
+
+/**
+ * @brief Swaps the first and third channels of 4-byte pixels in place
+ *        (RGBA <-> BGRA)
+ *
+ * @param pixels the pixels to swizzle
+ * @param count the number of pixels
+ */
+void swap_red_blue(uint8_t* pixels, size_t count);
+
+/**
+ * @brief Moves the alpha of 4-byte pixels from the first channel to the last
+ *        channel in place (ABGR -> BGRA, ARGB -> RGBA)
+ *
+ * @param pixels the pixels to rotate
+ * @param count the number of pixels
+ */
+void move_alpha_last(uint8_t* pixels, size_t count);
+
+/**
+ * @brief Multiplies the color channels of 4-byte pixels by their alpha (the
+ *        last channel) in place, rounding to the nearest value
+ *
+ * @param pixels the pixels to premultiply
+ * @param count the number of pixels
+ */
+void premultiply_alpha(uint8_t* pixels, size_t count);
+} // end of namespace PixelConvert
+} // end of namespace BarelyEngine
+
+#endif // defined(BE_PIXEL_CONVERT_H)
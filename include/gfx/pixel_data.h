@@ -6,6 +6,8 @@
 #ifndef BE_PIXEL_DATA_H
 #define BE_PIXEL_DATA_H
 
+#include <cstdint>
+#include <vector>
 #include <OpenGL/gltypes.h>
 
 struct SDL_Surface;
@@ -17,6 +19,11 @@ namespace BarelyEngine {
  *
  * `prepare()` should be called before using `pixels()` to ensure the pixels are
  * in the correct format.
+ *
+ * Where possible, the pixels are converted in place in the surface. Formats
+ * which need more space per pixel once converted are expanded into a buffer
+ * owned by the PixelData, and only the formats the conversion kernels don't
+ * handle fall back to converting a copy of the surface with SDL.
  */
 class PixelData
 {
@@ -34,13 +41,21 @@ public:
    *
    * Usually, this won't require doing anything, but occasionally it might need
    * the surface being converted to a more usuable format for uploading to the
-   * GPU.
+   * GPU. 3-byte and palettised pixels are expanded to 4 bytes per pixel.
+   *
+   * Note that this may modify the surface's pixels in place. Calling it more
+   * than once has no further effect.
+   *
+   * @param premultiply_alpha whether to multiply the color channels by alpha
    */
-  void prepare();
+  void prepare(bool premultiply_alpha = false);
 
   /**
    * @brief Gets the pixel format in OpenGL terms
    *
+   * Before `prepare()` has been called, this is the format of the surface as it
+   * is (if it can be uploaded as it is).
+   *
    * @return a GLenum specifying the pixel format or GL_FALSE if unsupported
    */
   GLenum format() const;
@@ -53,8 +68,35 @@ public:
   void* pixels() const;
 
 private:
+  /**
+   * @brief Converts 4-byte pixels with alpha in the lowest byte, in place
+   *
+   * @return the resulting format
+   */
+  GLenum move_alpha_last();
+
+  /**
+   * @brief Expands 3-byte pixels into the buffer
+   *
+   * @return the resulting format
+   */
+  GLenum expand_rgb();
+
+  /**
+   * @brief Expands palettised pixels into the buffer
+   *
+   * @return the resulting format
+   */
+  GLenum expand_palette();
+
   SDL_Surface* surface_;
   SDL_Surface* converted_surface_ = nullptr;
+  /// Pixels expanded from the surface (empty if the surface is used directly)
+  std::vector<uint8_t> buffer_;
+  /// The format of the pixels once prepared (GL_FALSE if not converted)
+  GLenum converted_format_ = GL_FALSE;
+  /// Whether `prepare()` has been called
+  bool prepared_ = false;
 };
 } // end of namespace BarleyEngine
 
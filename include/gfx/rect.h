@@ -0,0 +1,61 @@
+//
+// gfx/rect.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BE_RECT_H
+#define BE_RECT_H
+
+namespace BarelyEngine {
+/**
+ * @struct Rect
+ * @brief An axis-aligned rectangle, in the same units as vertex positions
+ */
+struct Rect
+{
+  /// The x position of the left edge
+  float x = 0;
+  /// The y position of the top edge
+  float y = 0;
+  /// The width of the rectangle
+  float w = 0;
+  /// The height of the rectangle
+  float h = 0;
+
+  Rect() {};
+
+  /**
+   * @brief Construct a new rectangle
+   *
+   * @param x the x position of the left edge
+   * @param y the y position of the top edge
+   * @param w the width of the rectangle
+   * @param h the height of the rectangle
+   */
+  Rect(float x, float y, float w, float h)
+    : x(x)
+    , y(y)
+    , w(w)
+    , h(h) {};
+
+  /**
+   * @brief Checks whether the rectangle overlaps another (touching edges
+   *        count as overlapping)
+   */
+  bool intersects(const Rect& other) const
+  {
+    return x <= other.x + other.w && other.x <= x + w && y <= other.y + other.h &&
+           other.y <= y + h;
+  }
+
+  /**
+   * @brief Checks whether a point lies inside the rectangle
+   */
+  bool contains(float px, float py) const
+  {
+    return px >= x && px <= x + w && py >= y && py <= y + h;
+  }
+};
+} // end of namespace BarelyEngine
+
+#endif // defined(BE_RECT_H)
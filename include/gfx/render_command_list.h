@@ -0,0 +1,276 @@
+//
+// gfx/render_command_list.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BE_RENDER_COMMAND_LIST_H
+#define BE_RENDER_COMMAND_LIST_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "cache_aligned.h"
+#include "quad_generator.h"
+#include "rect.h"
+
+namespace BarelyEngine {
+class RenderElement;
+class Texture;
+class VertexBatcher;
+
+/**
+ * @struct RenderCommand
+ * @brief A run of vertices recorded into a RenderBucket
+ */
+struct RenderCommand
+{
+  /// The sort key of the vertices (see `RenderElement::sort_key()`)
+  uint64_t key;
+  /// The texture to draw the vertices with (may be null)
+  const Texture* texture;
+  /// The index of the first float in the bucket's vertices
+  size_t first;
+  /// The number of floats
+  size_t count;
+};
+
+/**
+ * @class RenderBucket
+ * @brief Records draws from a single thread, without touching OpenGL
+ *
+ * Each thread recording into a RenderCommandList has a bucket to itself, so
+ * recording needs no locking. The vertices are copied (or generated) straight
+ * into the bucket, and the commands refer to them by offset. Buckets are
+ * aligned to (and padded out to) a cache line, so the threads recording into
+ * neighbouring buckets don't share one.
+ *
+ * With a viewport set, elements and quads outside of it are culled as they're
+ * recorded, before their vertices are copied or generated.
+ */
+class alignas(64) RenderBucket
+{
+public:
+  /**
+   * @brief Allocates with cache line alignment (see `cache_aligned_new()`)
+   */
+  static void* operator new(size_t size) { return cache_aligned_new(size); }
+  static void operator delete(void* pointer) { std::free(pointer); }
+
+  /**
+   * @brief Removes every command, keeping the memory for the next frame
+   */
+  void clear();
+
+  /**
+   * @brief Sets the area which can be seen, so elements and quads outside of
+   *        it aren't recorded
+   *
+   * @param viewport the visible area (usually `Window::viewport()`)
+   */
+  void set_viewport(const Rect& viewport);
+
+  /**
+   * @brief Stops skipping elements and quads outside of the viewport
+   */
+  void clear_viewport() { cull_ = false; }
+
+  /**
+   * @brief Records a RenderElement's vertices, with its ID as the sort key
+   *
+   * @param render_element the element to be drawn
+   */
+  void draw(const RenderElement* render_element);
+
+  /**
+   * @brief Records vertices which aren't part of a RenderElement (which
+   *        aren't culled, as their layout isn't known)
+   *
+   * @param texture the texture to draw the vertices with (may be null)
+   * @param key the sort key of the vertices
+   * @param vertices the vertices to draw
+   * @param count the number of floats in `vertices`
+   */
+  void draw(const Texture* texture, uint64_t key, const float* vertices, size_t count);
+
+  /**
+   * @brief Generates a run of textured quads straight into the bucket, leaving
+   *        out those outside of the viewport
+   *
+   * @param texture the texture to draw the quads with (may be null)
+   * @param key the sort key of the quads
+   * @param quads the properties of the quads
+   */
+  void draw_quads(const Texture* texture, uint64_t key, const QuadArrays& quads);
+
+  /**
+   * @brief Sorts the commands by key, keeping commands with the same key in
+   *        the order they were recorded
+   *
+   * Call it from the recording thread once it's finished, so the sorting is
+   * spread over the threads too (the merge sorts any bucket which wasn't).
+   */
+  void sort();
+
+  /**
+   * @brief Gets a command, in sorted order once the bucket is sorted
+   */
+  const RenderCommand& command(size_t index) const { return commands_[index]; }
+
+  /**
+   * @brief Gets the first vertex of a command
+   */
+  const float* vertices(const RenderCommand& command) const
+  {
+    return &vertices_[command.first];
+  }
+
+  /**
+   * @brief Gets the number of commands
+   */
+  size_t size() const { return commands_.size(); }
+
+  /**
+   * @brief Gets the total number of floats recorded
+   */
+  size_t vertex_count() const { return vertices_.size(); }
+
+  /**
+   * @brief Gets the number of elements and quads culled since the bucket was
+   *        cleared
+   */
+  size_t culled_count() const { return culled_count_; }
+
+private:
+  /**
+   * @brief Checks whether something is inside the viewport (always true if
+   *        there isn't one), counting it as culled if it isn't
+   */
+  bool visible(const Rect& bounds);
+
+  /// The recorded commands
+  std::vector<RenderCommand> commands_;
+  /// The vertices of every command
+  std::vector<float> vertices_;
+  /// Whether the commands are in key order
+  bool sorted_ = true;
+  /// Whether elements and quads outside of the viewport are skipped
+  bool cull_ = false;
+  /// The area which can be seen
+  Rect viewport_;
+  /// The number of elements and quads skipped for being outside of the
+  /// viewport
+  size_t culled_count_ = 0;
+};
+
+/**
+ * @class RenderCommandList
+ * @brief Records a frame's draws on many threads, then submits them in sort
+ *        key order on the render thread
+ *
+ * Worker threads each record into their own RenderBucket (element vertices,
+ * raw vertices or quads generated by QuadGenerator) and sort it. The render
+ * thread then merges the sorted buckets by key and sends the commands to a
+ * VertexBatcher, so only the OpenGL calls are serialized.
+ *
+ * Commands with the same key keep the order they were recorded in, with the
+ * commands of lower buckets first, so the result doesn't depend on how the
+ * threads were scheduled.
+ *
+ * A typical frame:
+ *    list.clear();                             // render thread
+ *    list.bucket(i).draw_quads(...);           // worker i
+ *    list.bucket(i).sort();                    // worker i
+ *    list.submit(batcher);                     // render thread, after joining
+ */
+class RenderCommandList
+{
+public:
+  /**
+   * @brief Construct a list with a bucket for each recording thread
+   *
+   * @param bucket_count the number of buckets
+   */
+  explicit RenderCommandList(size_t bucket_count);
+
+  /**
+   * @brief Gets a bucket to record into (one thread per bucket at a time)
+   */
+  RenderBucket& bucket(size_t index) { return *buckets_[index]; }
+  const RenderBucket& bucket(size_t index) const { return *buckets_[index]; }
+
+  /**
+   * @brief Gets the number of buckets
+   */
+  size_t bucket_count() const { return buckets_.size(); }
+
+  /**
+   * @brief Clears every bucket, ready for the next frame
+   */
+  void clear();
+
+  /**
+   * @brief Sets the viewport of every bucket (see `RenderBucket::set_viewport()`),
+   *        before the threads start recording
+   *
+   * @param viewport the visible area (usually `Window::viewport()`)
+   */
+  void set_viewport(const Rect& viewport);
+
+  /**
+   * @brief Stops every bucket culling
+   */
+  void clear_viewport();
+
+  /**
+   * @brief Merges the buckets into sort key order
+   *
+   * Must only be called once every thread has finished recording.
+   */
+  void merge();
+
+  /**
+   * @brief Merges the buckets, then draws every command with a VertexBatcher,
+   *        adding what the buckets culled to `RenderStats::frame()`
+   *
+   * @param batcher the batcher to draw with (between its `begin` and `end`)
+   */
+  void submit(VertexBatcher& batcher);
+
+  /**
+   * @brief Gets a merged command (after `merge()`)
+   */
+  const RenderCommand& command(size_t index) const;
+
+  /**
+   * @brief Gets the vertices of a merged command (after `merge()`)
+   */
+  const float* vertices(size_t index) const;
+
+  /**
+   * @brief Gets the number of merged commands (after `merge()`)
+   */
+  size_t size() const { return merged_.size(); }
+
+private:
+  /**
+   * @struct Entry
+   * @brief Where a merged command is
+   */
+  struct Entry
+  {
+    /// The index of the command's bucket
+    uint32_t bucket;
+    /// The index of the command in its bucket
+    uint32_t command;
+  };
+
+  /// The buckets, each on its own cache lines
+  std::vector<std::unique_ptr<RenderBucket>> buckets_;
+  /// The commands of every bucket, in merged order
+  std::vector<Entry> merged_;
+  /// The next command of each bucket, while merging
+  std::vector<Entry> heap_;
+};
+} // end of namespace BarelyEngine
+
+#endif // defined(BE_RENDER_COMMAND_LIST_H)
@@ -6,8 +6,10 @@
 #ifndef BE_RENDER_ELEMENT_H
 #define BE_RENDER_ELEMENT_H
 
+#include <algorithm>
 #include <vector>
 #include <BarelyGL/vertex_attribute_array.h>
+#include "rect.h"
 #include "texture.h"
 
 namespace BarelyEngine {
@@ -58,6 +60,7 @@ public:
     , texture_(texture)
   {
     id_ = generate_id();
+    update_bounds();
   }
 
   bool operator<(const RenderElement& other) const { return id() < other.id(); }
@@ -68,7 +71,11 @@ public:
    *
    * @param vertices array of floats to be used as vertices
    */
-  void set_vertices(std::vector<float> vertices) { vertices_ = std::move(vertices); }
+  void set_vertices(std::vector<float> vertices)
+  {
+    vertices_ = std::move(vertices);
+    update_bounds();
+  }
 
   /**
    * @brief Gets the ID for this element
@@ -112,34 +119,82 @@ public:
    */
   const BarelyGL::VertexAttributeArray& attributes() const { return attributes_; }
 
-protected:
   /**
-   * @brief Generates an ID based on the texture and layering, to be used when
-   * sorting the draw calls
+   * @brief Gets the bounds of the vertices, for culling
+   *
+   * @returns the smallest rectangle containing every vertex's x and y position
+   */
+  const Rect& bounds() const { return bounds_; }
 
+  /**
+   * @brief Combines the layering and texture into a sort key, as used for IDs
+   *
    * Groups the textures as follows:
    *      (8 bits)  layer   - could be a UI layer, background layer etc
    *      (8 bits)  depth   - the z-order depth within that layer
    *      (32 bits) texture - the ID of the texture
    *
+   * @param layer the layer to be drawn onto
+   * @param depth the depth to be drawn onto
+   * @param texture the texture to be used (may be null)
+   *
    * @returns a uint64_t of the combined texture, layer and depth bits
    */
-  virtual uint64_t generate_id() const
+  static uint64_t sort_key(uint8_t layer, uint8_t depth, const Texture* texture)
   {
     uint64_t texture_id = 0;
 
-    if (texture_ != nullptr)
+    if (texture != nullptr)
     {
-      texture_id = texture_->id();
+      texture_id = texture->id();
     }
 
-    return uint64_t(layer_) << 56 | uint64_t(depth_) << 48 | texture_id;
+    return uint64_t(layer) << 56 | uint64_t(depth) << 48 | texture_id;
   }
 
+protected:
+  /**
+   * @brief Generates an ID based on the texture and layering, to be used when
+   * sorting the draw calls (see `sort_key()`)
+   *
+   * @returns a uint64_t of the combined texture, layer and depth bits
+   */
+  virtual uint64_t generate_id() const { return sort_key(layer_, depth_, texture_); }
+
   /// The ID for this element
   uint64_t id_ = 0;
 
 private:
+  /**
+   * @brief Recalculates the bounds from the vertices (the position is the
+   * first attribute of each vertex)
+   */
+  void update_bounds()
+  {
+    const auto stride = attributes_.size();
+
+    if (stride < 2 || vertices_.size() < stride)
+    {
+      bounds_ = {};
+      return;
+    }
+
+    auto min_x = vertices_[0];
+    auto min_y = vertices_[1];
+    auto max_x = min_x;
+    auto max_y = min_y;
+
+    for (size_t i = stride; i + 1 < vertices_.size(); i += stride)
+    {
+      min_x = std::min(min_x, vertices_[i]);
+      max_x = std::max(max_x, vertices_[i]);
+      min_y = std::min(min_y, vertices_[i + 1]);
+      max_y = std::max(max_y, vertices_[i + 1]);
+    }
+
+    bounds_ = {min_x, min_y, max_x - min_x, max_y - min_y};
+  }
+
   /// A list of vertices
   std::vector<float> vertices_;
   /// The layer this should be rendered on (0 is the back/bottom)
@@ -150,6 +205,8 @@ private:
   BarelyGL::VertexAttributeArray attributes_;
   /// The texture to be used when rendering the vertices
   const Texture* texture_ = nullptr;
+  /// The bounds of the vertices
+  Rect bounds_;
 };
 } // end of namespace BarelyEngine
 
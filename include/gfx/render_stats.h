@@ -0,0 +1,107 @@
+//
+// gfx/render_stats.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BE_RENDER_STATS_H
+#define BE_RENDER_STATS_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace BarelyEngine {
+class FrameProfiler;
+
+/**
+ * @class enum FlushReason
+ * @brief Why a VertexBatcher flushed its batch
+ */
+enum class FlushReason
+{
+  /// The next vertices use a different texture (or sort key)
+  TEXTURE_CHANGE,
+  /// The next vertices wouldn't fit in the batch
+  BATCH_FULL,
+  /// The batcher ended
+  END,
+  /// The number of reasons
+  COUNT
+};
+
+/**
+ * @struct RenderStats
+ * @brief Counts what the renderer did over a frame
+ *
+ * The batchers and textures bump the counters of `RenderStats::frame()` as
+ * they go (plain increments on the render thread, so they're cheap enough to
+ * leave on). Call `end_frame()` once a frame to send them to a FrameProfiler
+ * as samples and start counting again:
+ *
+ *    window.swap_buffer();
+ *    RenderStats::frame().end_frame(FrameProfiler::instance());
+ */
+struct RenderStats
+{
+  /// The number of OpenGL draw calls
+  uint32_t draw_calls = 0;
+  /// The number of vertices drawn
+  uint32_t vertices = 0;
+  /// The number of batches flushed, for each FlushReason
+  uint32_t flushes[static_cast<size_t>(FlushReason::COUNT)] = {};
+  /// The number of bytes of vertices uploaded
+  uint64_t vertex_bytes = 0;
+  /// The number of bytes of pixels uploaded with `Texture::sub_data()`
+  uint64_t texture_bytes = 0;
+  /// The number of times a texture was bound
+  uint32_t texture_binds = 0;
+  /// The number of binds skipped because the texture was already bound
+  uint32_t texture_binds_skipped = 0;
+  /// The number of elements culled for being outside of the viewport
+  uint32_t culled = 0;
+
+  /**
+   * @brief Counts a flushed batch
+   */
+  void add_flush(FlushReason reason) { flushes[static_cast<size_t>(reason)]++; }
+
+  /**
+   * @brief Gets the number of batches flushed for a reason
+   */
+  uint32_t flush_count(FlushReason reason) const
+  {
+    return flushes[static_cast<size_t>(reason)];
+  }
+
+  /**
+   * @brief Sets every counter back to zero
+   */
+  void reset() { *this = RenderStats(); }
+
+  /**
+   * @brief Adds every counter to a profiler as a sample
+   *
+   * @param profiler the profiler to add the samples to
+   */
+  void report(FrameProfiler& profiler) const;
+
+  /**
+   * @brief Reports the counters to a profiler, then resets them
+   *
+   * @param profiler the profiler to add the samples to
+   */
+  void end_frame(FrameProfiler& profiler);
+
+  /**
+   * @brief The counters for the current frame
+   *
+   * @return the stats the renderer is counting into
+   */
+  static RenderStats& frame() { return frame_; }
+
+private:
+  /// The counters for the current frame
+  static RenderStats frame_;
+};
+} // end of namespace BarelyEngine
+
+#endif // defined(BE_RENDER_STATS_H)
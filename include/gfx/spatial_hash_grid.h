@@ -0,0 +1,519 @@
+//
+// gfx/spatial_hash_grid.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BE_SPATIAL_HASH_GRID_H
+#define BE_SPATIAL_HASH_GRID_H
+
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+#include "rect.h"
+#include "exception.h"
+
+namespace BarelyEngine {
+/**
+ * @class SpatialHashGrid
+ * @brief A uniform grid of item bounds, hashed so only occupied cells use
+ *        memory and the world can be any size
+ *
+ * Each item is filed under every cell its bounds overlap, which suits lots of
+ * items of a similar size (around a cell or smaller). `move()` only touches
+ * the cells if the item crosses into different ones, and `rebuild()` refiles
+ * everything at once (e.g. with a new cell size after the items have grown).
+ *
+ * Items are referred to by the handle `insert()` returns, and queries return
+ * the items themselves (usually pointers), in no particular order.
+ *
+ * Items overlapping more than a few hundred cells are kept in a list which
+ * every query checks, rather than being filed under every cell, and a query
+ * bigger than the occupied part of the grid only visits the occupied cells.
+ * Positions are clamped to about 16 million cells either side of the
+ * origin.
+ *
+ * Queries stamp the items they find (so items spanning several cells are only
+ * found once), so they aren't const, and a grid mustn't be queried from more
+ * than one thread at once.
+ */
+template <typename T>
+class SpatialHashGrid
+{
+public:
+  /// Refers to an item in the grid
+  using Handle = uint32_t;
+
+  /**
+   * @brief Construct an empty grid
+   *
+   * @param cell_size the width and height of each cell (which must be
+   *        positive)
+   */
+  SpatialHashGrid(float cell_size)
+    : cell_size_(valid_cell_size(cell_size)) {};
+
+  /**
+   * @brief Adds an item to the grid
+   *
+   * @param item the item to add
+   * @param bounds the bounds of the item (which must be finite)
+   *
+   * @return the handle of the item
+   */
+  Handle insert(const T& item, const Rect& bounds);
+
+  /**
+   * @brief Updates the bounds of an item
+   *
+   * @param handle the handle of the item
+   * @param bounds the new bounds of the item (which must be finite)
+   */
+  void move(Handle handle, const Rect& bounds);
+
+  /**
+   * @brief Removes an item from the grid (its handle may be reused)
+   *
+   * @param handle the handle of the item (which mustn't have been removed
+   *        already)
+   */
+  void remove(Handle handle);
+
+  /**
+   * @brief Refiles every item, optionally with a new cell size
+   *
+   * @param cell_size the new width and height of each cell (0 keeps the
+   *        current size, otherwise it must be positive)
+   */
+  void rebuild(float cell_size = 0);
+
+  /**
+   * @brief Removes every item from the grid
+   */
+  void clear();
+
+  /**
+   * @brief Finds the items whose bounds overlap a rectangle
+   *
+   * @param area the rectangle to look in (nothing is found if it isn't
+   *        finite)
+   * @param found filled with the items found (it isn't cleared first)
+   */
+  void query(const Rect& area, std::vector<T>& found);
+
+  /**
+   * @brief Finds the items whose bounds contain a point (e.g. for picking)
+   *
+   * @param x the x position of the point
+   * @param y the y position of the point
+   * @param found filled with the items found (it isn't cleared first)
+   */
+  void query(float x, float y, std::vector<T>& found);
+
+  /**
+   * @brief Finds the handles of the items whose bounds overlap a rectangle
+   *
+   * @param area the rectangle to look in
+   * @param found filled with the handles found (it isn't cleared first)
+   */
+  void query_handles(const Rect& area, std::vector<Handle>& found);
+
+  /**
+   * @brief Gets an item
+   */
+  const T& item(Handle handle) const { return items_[handle].item; }
+
+  /**
+   * @brief Gets the bounds of an item
+   */
+  const Rect& bounds(Handle handle) const { return items_[handle].bounds; }
+
+  /**
+   * @brief Gets the number of items in the grid
+   */
+  size_t size() const { return items_.size() - free_.size(); }
+
+private:
+  /**
+   * @struct CellRange
+   * @brief The columns and rows of the cells overlapped by some bounds
+   */
+  struct CellRange
+  {
+    int32_t min_column, min_row, max_column, max_row;
+
+    bool operator==(const CellRange& other) const
+    {
+      return min_column == other.min_column && min_row == other.min_row &&
+             max_column == other.max_column && max_row == other.max_row;
+    }
+  };
+
+  /**
+   * @struct Item
+   * @brief An item and the cells it is filed under
+   */
+  struct Item
+  {
+    /// The item
+    T item;
+    /// The bounds of the item
+    Rect bounds;
+    /// The cells the item is filed under
+    CellRange cells;
+    /// The last query that found the item (so it's only found once)
+    uint32_t query_stamp;
+    /// Whether the handle is in use
+    bool alive;
+  };
+
+  /**
+   * @brief Calls a function with the handle of each item overlapping a
+   *        rectangle, once per item
+   */
+  template <typename F>
+  void visit(const Rect& area, F&& visitor);
+
+  /**
+   * @brief Gets the cells overlapped by some bounds
+   */
+  CellRange cell_range(const Rect& bounds) const;
+
+  /**
+   * @brief Gets the number of cells in a range
+   */
+  static int64_t cell_count(const CellRange& range)
+  {
+    return (int64_t(range.max_column) - range.min_column + 1) *
+           (int64_t(range.max_row) - range.min_row + 1);
+  }
+
+  /**
+   * @brief Checks whether a range covers too many cells to file an item under
+   *        each of them
+   */
+  static bool oversized(const CellRange& range) { return cell_count(range) > 256; }
+
+  /**
+   * @brief Checks whether every edge of some bounds is finite
+   */
+  static bool finite(const Rect& bounds)
+  {
+    return std::isfinite(bounds.x) && std::isfinite(bounds.y) && std::isfinite(bounds.w) &&
+           std::isfinite(bounds.h);
+  }
+
+  /**
+   * @brief Throws if a cell size isn't positive and finite
+   */
+  static float valid_cell_size(float cell_size);
+
+  /**
+   * @brief Throws if some bounds aren't finite
+   */
+  static void check_bounds(const Rect& bounds);
+
+  /**
+   * @brief Files a handle under a range of cells
+   */
+  void add_to_cells(Handle handle, const CellRange& range);
+
+  /**
+   * @brief Removes a handle from a range of cells
+   */
+  void remove_from_cells(Handle handle, const CellRange& range);
+
+  /**
+   * @brief Gets the key of the cell at a given column and row
+   */
+  static uint64_t cell_key(int32_t column, int32_t row)
+  {
+    return uint64_t(uint32_t(column)) << 32 | uint32_t(row);
+  }
+
+  /// The width and height of each cell
+  float cell_size_;
+  /// Every item, indexed by handle
+  std::vector<Item> items_;
+  /// The handles of removed items, to be reused
+  std::vector<Handle> free_;
+  /// The handles of the items overlapping each non-empty cell
+  std::unordered_map<uint64_t, std::vector<Handle>> cells_;
+  /// The handles of the items overlapping too many cells to be filed in them
+  std::vector<Handle> oversized_;
+  /// The number of queries made, used to stamp items as they're found
+  uint32_t query_count_ = 0;
+};
+
+template <typename T>
+typename SpatialHashGrid<T>::Handle SpatialHashGrid<T>::insert(const T& item, const Rect& bounds)
+{
+  check_bounds(bounds);
+
+  Handle handle;
+
+  if (free_.empty())
+  {
+    handle = static_cast<Handle>(items_.size());
+    items_.push_back({});
+  }
+  else
+  {
+    handle = free_.back();
+    free_.pop_back();
+  }
+
+  items_[handle] = {item, bounds, cell_range(bounds), query_count_, true};
+  add_to_cells(handle, items_[handle].cells);
+
+  return handle;
+}
+
+template <typename T>
+void SpatialHashGrid<T>::move(const Handle handle, const Rect& bounds)
+{
+  check_bounds(bounds);
+
+  auto& item = items_[handle];
+  const auto range = cell_range(bounds);
+
+  item.bounds = bounds;
+
+  // Most moves stay within the same cells, so there's nothing to refile
+  if (range == item.cells)
+  {
+    return;
+  }
+
+  remove_from_cells(handle, item.cells);
+  add_to_cells(handle, range);
+  item.cells = range;
+}
+
+template <typename T>
+void SpatialHashGrid<T>::remove(const Handle handle)
+{
+  // Removing twice would put the handle on the free list twice
+  assert(items_[handle].alive);
+
+  remove_from_cells(handle, items_[handle].cells);
+  items_[handle].alive = false;
+  free_.push_back(handle);
+}
+
+template <typename T>
+void SpatialHashGrid<T>::rebuild(const float cell_size)
+{
+  if (cell_size != 0)
+  {
+    cell_size_ = valid_cell_size(cell_size);
+  }
+
+  for (auto& cell : cells_)
+  {
+    cell.second.clear();
+  }
+
+  oversized_.clear();
+
+  for (Handle handle = 0; handle < items_.size(); handle++)
+  {
+    auto& item = items_[handle];
+
+    if (item.alive)
+    {
+      item.cells = cell_range(item.bounds);
+      add_to_cells(handle, item.cells);
+    }
+  }
+
+  // Drop the cells nothing is in any more
+  for (auto cell = cells_.begin(); cell != cells_.end();)
+  {
+    cell = cell->second.empty() ? cells_.erase(cell) : std::next(cell);
+  }
+}
+
+template <typename T>
+void SpatialHashGrid<T>::clear()
+{
+  items_.clear();
+  free_.clear();
+  oversized_.clear();
+
+  // Keep the cells' storage around, as grids are often refilled with much the
+  // same items (`rebuild()` drops the empty ones)
+  for (auto& cell : cells_)
+  {
+    cell.second.clear();
+  }
+}
+
+template <typename T>
+void SpatialHashGrid<T>::query(const Rect& area, std::vector<T>& found)
+{
+  visit(area, [this, &found](const Handle handle) { found.push_back(items_[handle].item); });
+}
+
+template <typename T>
+void SpatialHashGrid<T>::query(const float x, const float y, std::vector<T>& found)
+{
+  query(Rect{x, y, 0, 0}, found);
+}
+
+template <typename T>
+void SpatialHashGrid<T>::query_handles(const Rect& area, std::vector<Handle>& found)
+{
+  visit(area, [&found](const Handle handle) { found.push_back(handle); });
+}
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+template <typename T>
+template <typename F>
+void SpatialHashGrid<T>::visit(const Rect& area, F&& visitor)
+{
+  if (!finite(area))
+  {
+    return;
+  }
+
+  const auto range = cell_range(area);
+  const auto stamp = ++query_count_;
+  const auto visit_cell = [&](const std::vector<Handle>& cell)
+  {
+    for (const auto handle : cell)
+    {
+      auto& item = items_[handle];
+
+      // Items spanning several cells would otherwise be found more than once
+      if (item.query_stamp != stamp && item.bounds.intersects(area))
+      {
+        item.query_stamp = stamp;
+        visitor(handle);
+      }
+    }
+  };
+
+  visit_cell(oversized_);
+
+  // A huge area is quicker to search by going through the cells which are
+  // occupied, than by looking up every cell in the area
+  if (cell_count(range) > static_cast<int64_t>(cells_.size()))
+  {
+    for (const auto& cell : cells_)
+    {
+      const auto column = static_cast<int32_t>(cell.first >> 32);
+      const auto row = static_cast<int32_t>(cell.first);
+
+      if (column >= range.min_column && column <= range.max_column &&
+          row >= range.min_row && row <= range.max_row)
+      {
+        visit_cell(cell.second);
+      }
+    }
+
+    return;
+  }
+
+  for (auto row = range.min_row; row <= range.max_row; row++)
+  {
+    for (auto column = range.min_column; column <= range.max_column; column++)
+    {
+      const auto cell = cells_.find(cell_key(column, row));
+
+      if (cell != cells_.end())
+      {
+        visit_cell(cell->second);
+      }
+    }
+  }
+}
+
+template <typename T>
+typename SpatialHashGrid<T>::CellRange SpatialHashGrid<T>::cell_range(const Rect& bounds) const
+{
+  // Clamped, so that far off positions don't overflow the index
+  const auto index = [this](const float position)
+  {
+    const auto kMaxIndex = float(1 << 24);
+    return static_cast<int32_t>(
+      std::max(-kMaxIndex, std::min(std::floor(position / cell_size_), kMaxIndex)));
+  };
+
+  return {index(bounds.x), index(bounds.y), index(bounds.x + bounds.w),
+          index(bounds.y + bounds.h)};
+}
+
+template <typename T>
+void SpatialHashGrid<T>::add_to_cells(const Handle handle, const CellRange& range)
+{
+  if (oversized(range))
+  {
+    oversized_.push_back(handle);
+    return;
+  }
+
+  for (auto row = range.min_row; row <= range.max_row; row++)
+  {
+    for (auto column = range.min_column; column <= range.max_column; column++)
+    {
+      cells_[cell_key(column, row)].push_back(handle);
+    }
+  }
+}
+
+template <typename T>
+void SpatialHashGrid<T>::remove_from_cells(const Handle handle, const CellRange& range)
+{
+  if (oversized(range))
+  {
+    oversized_.erase(std::find(oversized_.begin(), oversized_.end(), handle));
+    return;
+  }
+
+  for (auto row = range.min_row; row <= range.max_row; row++)
+  {
+    for (auto column = range.min_column; column <= range.max_column; column++)
+    {
+      auto& cell = cells_[cell_key(column, row)];
+      const auto position = std::find(cell.begin(), cell.end(), handle);
+
+      // The order within a cell doesn't matter, so swap rather than shuffle
+      if (position != cell.end())
+      {
+        *position = cell.back();
+        cell.pop_back();
+      }
+    }
+  }
+}
+
+template <typename T>
+float SpatialHashGrid<T>::valid_cell_size(const float cell_size)
+{
+  if (!(cell_size > 0) || !std::isfinite(cell_size))
+  {
+    throw Exception("Grid cells must have a positive size");
+  }
+
+  return cell_size;
+}
+
+template <typename T>
+void SpatialHashGrid<T>::check_bounds(const Rect& bounds)
+{
+  if (!finite(bounds))
+  {
+    throw Exception("Grid items must have finite bounds");
+  }
+}
+} // end of namespace BarelyEngine
+
+#endif // defined(BE_SPATIAL_HASH_GRID_H)
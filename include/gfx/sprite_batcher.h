@@ -0,0 +1,162 @@
+//
+// gfx/sprite_batcher.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BE_SPRITE_BATCHER_H
+#define BE_SPRITE_BATCHER_H
+
+#include <cstdint>
+#include <vector>
+#include <OpenGL/gl3.h>
+#include "color.h"
+#include "render_stats.h"
+
+namespace BarelyEngine {
+class Texture;
+
+/**
+ * @struct SpriteInstance
+ * @brief The per-instance attributes of a single sprite (32 bytes)
+ *
+ * The attributes are bound to these locations, for the vertex shader to
+ * place a unit quad (location 0, corners 0 - 1) with:
+ *    0: vec2 corner
+ *    1: vec4 rect         (x, y, width, height)
+ *    2: vec4 uv_rect      (u0, v0, u1, v1, normalised from 16 bits)
+ *    3: vec4 color        (normalised from 8 bits)
+ *    4: vec2 layer_depth  (texture array layer, depth)
+ */
+struct SpriteInstance
+{
+  /// The position and size of the sprite
+  float x, y, w, h;
+  /// The clip of the texture, as fractions of 65535
+  uint16_t u0, v0, u1, v1;
+  /// The color to tint the texture with
+  uint8_t r, g, b, a;
+  /// The layer of the texture array (0 for plain textures)
+  uint16_t texture_layer;
+  /// The depth to draw at (0 is back/bottom)
+  uint16_t depth;
+};
+
+static_assert(sizeof(SpriteInstance) == 32, "SpriteInstance should be tightly packed");
+
+/**
+ * @brief Creates the instance attributes for a sprite using the whole texture
+ *
+ * @param x the x position of the sprite
+ * @param y the y position of the sprite
+ * @param w the width of the sprite
+ * @param h the height of the sprite
+ * @param depth the depth to be drawn at (0 is back/bottom)
+ * @param texture the texture to be drawn (may be null)
+ * @param color the color to tint the texture with
+ *
+ * @return the instance attributes
+ */
+SpriteInstance make_sprite(float x, float y, float w, float h, uint16_t depth,
+                           const Texture* texture, Color color = Color::White);
+
+/**
+ * @brief Creates the instance attributes for a sprite using a clip of the
+ *        texture
+ *
+ * @param x the x position of the sprite
+ * @param y the y position of the sprite
+ * @param w the width of the sprite
+ * @param h the height of the sprite
+ * @param clip_x the x position inside of the texture
+ * @param clip_y the y position inside of the texture
+ * @param clip_w the width of the clip inside the texture
+ * @param clip_h the height of the clip inside the texture
+ * @param depth the depth to be drawn at (0 is back/bottom)
+ * @param texture the texture to be drawn
+ * @param color the color to tint the texture with
+ *
+ * @return the instance attributes
+ */
+SpriteInstance make_sprite(float x, float y, float w, float h, int clip_x, int clip_y, int clip_w,
+                           int clip_h, uint16_t depth, const Texture* texture,
+                           Color color = Color::White);
+
+/**
+ * @class SpriteBatcher
+ * @brief Class that draws sprites as instances of a single unit quad
+ *
+ * Unlike VertexBatcher, nothing is expanded into vertices on the CPU: each
+ * sprite is uploaded as 32 bytes of instance attributes (rather than the 192
+ * bytes of a TexturedQuad's vertices), and every batch is drawn with a single
+ * `glDrawArraysInstanced()` call. A batch is flushed when the texture changes
+ * (layers of a TextureArray count as the same texture) or it fills up.
+ */
+class SpriteBatcher
+{
+public:
+  /**
+   * @brief Construct a new SpriteBatcher
+   *
+   * @param max_sprites the maximum number of sprites to draw at once
+   */
+  explicit SpriteBatcher(size_t max_sprites);
+
+  ~SpriteBatcher();
+
+  SpriteBatcher(const SpriteBatcher& other) = delete;
+  SpriteBatcher& operator=(const SpriteBatcher& other) = delete;
+
+  /**
+   * @brief Setup the batcher to being receiving sprites
+   */
+  void begin();
+
+  /**
+   * @brief Add a sprite to the batch to be drawn
+   *
+   * @param texture the texture to draw the sprite with
+   * @param sprite the instance attributes of the sprite
+   */
+  void draw(const Texture* texture, const SpriteInstance& sprite);
+
+  /**
+   * @brief End the batcher and flush the remaining sprites
+   */
+  void end();
+
+  /**
+   * @brief Get the number of draw calls per frame
+   *
+   * @return the number of times an OpenGL draw was performed between `begin` and
+   * `end`
+   */
+  int draw_count() const { return draw_count_; }
+
+private:
+  /**
+   * @brief Uploads the current set of sprites and draws them
+   *
+   * @param reason why the batch is being flushed (for RenderStats)
+   */
+  void flush(FlushReason reason);
+
+  /// The vertex array object holding the quad and instance attributes
+  GLuint vao_ = 0;
+  /// The buffer holding the corners of the unit quad
+  GLuint quad_vbo_ = 0;
+  /// The buffer holding the instance attributes
+  GLuint instance_vbo_ = 0;
+  /// The maximum number of sprites to draw at once
+  size_t max_sprites_;
+  /// The sprites to be drawn at once
+  std::vector<SpriteInstance> sprites_;
+  /// The texture of the current batch
+  const Texture* current_texture_ = nullptr;
+  /// The last texture that was bound (to avoid binding needlessly)
+  const Texture* last_bound_texture_ = nullptr;
+  /// The number of times an OpenGL draw was performed
+  int draw_count_ = 0;
+};
+} // end of namespace BarelyEngine
+
+#endif // defined(BE_SPRITE_BATCHER_H)
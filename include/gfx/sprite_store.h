@@ -0,0 +1,252 @@
+//
+// gfx/sprite_store.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BE_SPRITE_STORE_H
+#define BE_SPRITE_STORE_H
+
+#include <cstdint>
+#include <vector>
+#include "color.h"
+#include "quad_generator.h"
+
+namespace BarelyEngine {
+class SpriteBatcher;
+class Texture;
+class VertexBatcher;
+
+/**
+ * @struct Sprite
+ * @brief The properties of a sprite being added to a SpriteStore
+ */
+struct Sprite
+{
+  /// The position and size of the sprite
+  float x = 0, y = 0, w = 0, h = 0;
+  /// The texture to draw the sprite with (may be null)
+  const Texture* texture = nullptr;
+  /// The clip of the texture (a clip_w or clip_h of 0 uses the whole texture)
+  int32_t clip_x = 0, clip_y = 0, clip_w = 0, clip_h = 0;
+  /// The color to tint the texture with
+  Color color;
+  /// The layer to be drawn onto (0 is back/bottom)
+  uint8_t layer = 0;
+  /// The depth to be drawn onto (0 is back/bottom)
+  uint8_t depth = 0;
+};
+
+/**
+ * @class SpriteStore
+ * @brief Stores sprites as a structure of arrays, for quickly updating and
+ *        drawing lots of them
+ *
+ * Each property of the sprites (x, y, size, clip, color, sort key etc.) is
+ * kept in its own contiguous array, so systems which update one property walk
+ * straight through memory, and the vertices are generated for whole runs of
+ * sprites at once by QuadGenerator (or sent as instances to a SpriteBatcher).
+ *
+ * Sprites are referred to by the id `add()` returns, which stays the same
+ * when other sprites are removed (removing swaps the last sprite into the
+ * gap) or the store is sorted. `draw()` sorts by sort key first if anything
+ * was added or removed, so each texture is drawn in as few batches as
+ * possible.
+ */
+class SpriteStore
+{
+public:
+  /// Refers to a sprite in the store
+  using Id = uint32_t;
+
+  /**
+   * @brief Adds a sprite
+   *
+   * @param sprite the properties of the sprite
+   *
+   * @return the id of the sprite
+   */
+  Id add(const Sprite& sprite);
+
+  /**
+   * @brief Adds many sprites at once
+   *
+   * @param sprites the properties of the sprites
+   * @param ids filled with the ids of the sprites, in the same order
+   */
+  void add(const std::vector<Sprite>& sprites, std::vector<Id>& ids);
+
+  /**
+   * @brief Removes a sprite (its id may be reused)
+   *
+   * @param id the id of the sprite (nothing is done if it has already been
+   *        removed)
+   */
+  void remove(Id id);
+
+  /**
+   * @brief Removes many sprites at once
+   *
+   * @param ids the ids of the sprites (ids which have already been removed,
+   *        or are repeated, are skipped)
+   */
+  void remove(const std::vector<Id>& ids);
+
+  /**
+   * @brief Checks whether a sprite is in the store
+   *
+   * @param id the id of the sprite
+   *
+   * @return true if the sprite was added and hasn't been removed since
+   */
+  bool contains(Id id) const { return id < indices_.size() && indices_[id] != kRemoved; }
+
+  /**
+   * @brief Removes every sprite
+   */
+  void clear();
+
+  /**
+   * @brief Moves a sprite
+   *
+   * @param id the id of the sprite (nothing is done if it has been removed,
+   *        as with `remove()`)
+   * @param x the new x position
+   * @param y the new y position
+   */
+  void set_position(Id id, float x, float y);
+
+  /**
+   * @brief Changes the tint of a sprite
+   *
+   * @param id the id of the sprite (nothing is done if it has been removed)
+   * @param color the new color
+   */
+  void set_color(Id id, Color color);
+
+  /**
+   * @brief Sorts the sprites by sort key (see `RenderElement::sort_key()`),
+   *        keeping sprites with the same key in the same order
+   */
+  void sort();
+
+  /**
+   * @brief Draws every sprite with a VertexBatcher (with TexturedQuad's vertex
+   *        attributes), generating the vertices for each run of sprites with
+   *        the same sort key at once
+   *
+   * Sprites outside of the batcher's viewport (if it has one) are culled from
+   * their positions and sizes, before any vertices are generated.
+   *
+   * @param batcher the batcher to draw with (between its `begin` and `end`)
+   */
+  void draw(VertexBatcher& batcher);
+
+  /**
+   * @brief Draws every sprite as an instance with a SpriteBatcher
+   *
+   * @param batcher the batcher to draw with (between its `begin` and `end`)
+   */
+  void draw(SpriteBatcher& batcher);
+
+  /**
+   * @brief Gets the properties of a run of sprites, for QuadGenerator
+   *
+   * @param first the index of the first sprite
+   * @param count the number of sprites
+   */
+  QuadArrays quads(size_t first, size_t count) const;
+
+  /**
+   * @brief Gets the index of a sprite in the arrays
+   */
+  size_t index(Id id) const { return indices_[id]; }
+
+  /**
+   * @brief Gets the number of sprites
+   */
+  size_t size() const { return ids_.size(); }
+
+  /**
+   * @brief Gets the x position of every sprite, in index order
+   */
+  std::vector<float>& x() { return x_; }
+  const std::vector<float>& x() const { return x_; }
+
+  /**
+   * @brief Gets the y position of every sprite, in index order
+   */
+  std::vector<float>& y() { return y_; }
+  const std::vector<float>& y() const { return y_; }
+
+  /**
+   * @brief Gets the sort key of every sprite, in index order
+   */
+  const std::vector<uint64_t>& sort_keys() const { return sort_keys_; }
+
+private:
+  /// The index of a removed sprite
+  static const uint32_t kRemoved = UINT32_MAX;
+
+  /**
+   * @brief Appends a sprite's properties to every array
+   */
+  void push_back(Id id, const Sprite& sprite);
+
+  /**
+   * @brief Removes the sprite at an index by moving the last one into its place
+   */
+  void swap_and_pop(size_t index);
+
+  /**
+   * @brief Gets an id which isn't in use
+   */
+  Id next_id();
+
+  /// The x position of each sprite
+  std::vector<float> x_;
+  /// The y position of each sprite
+  std::vector<float> y_;
+  /// The width of each sprite
+  std::vector<float> w_;
+  /// The height of each sprite
+  std::vector<float> h_;
+  /// The x position of each sprite's clip
+  std::vector<int32_t> clip_x_;
+  /// The y position of each sprite's clip
+  std::vector<int32_t> clip_y_;
+  /// The width of each sprite's clip
+  std::vector<int32_t> clip_w_;
+  /// The height of each sprite's clip
+  std::vector<int32_t> clip_h_;
+  /// The width of each sprite's texture
+  std::vector<float> texture_w_;
+  /// The height of each sprite's texture
+  std::vector<float> texture_h_;
+  /// The red tint of each sprite
+  std::vector<uint8_t> r_;
+  /// The green tint of each sprite
+  std::vector<uint8_t> g_;
+  /// The blue tint of each sprite
+  std::vector<uint8_t> b_;
+  /// The texture array layer of each sprite
+  std::vector<float> texture_layer_;
+  /// The depth of each sprite
+  std::vector<uint8_t> depth_;
+  /// The texture of each sprite
+  std::vector<const Texture*> textures_;
+  /// The sort key of each sprite
+  std::vector<uint64_t> sort_keys_;
+  /// The id of each sprite
+  std::vector<Id> ids_;
+  /// The index of each id's sprite (kRemoved if it was removed)
+  std::vector<uint32_t> indices_;
+  /// Ids which aren't in use
+  std::vector<Id> free_ids_;
+  /// Whether the sprites are in sort key order
+  bool sorted_ = true;
+  /// Scratch space for generated vertices
+  std::vector<float> vertices_;
+};
+} // end of namespace BarelyEngine
+
+#endif // defined(BE_SPRITE_STORE_H)
@@ -0,0 +1,156 @@
+//
+// gfx/static_batch.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BE_STATIC_BATCH_H
+#define BE_STATIC_BATCH_H
+
+#include <cstdint>
+#include <vector>
+#include <OpenGL/gl3.h>
+#include <BarelyGL/gl.h>
+
+namespace BarelyEngine {
+class RenderElement;
+class Texture;
+
+/**
+ * @class StaticBatch
+ * @brief A retained batch for elements which rarely change (backgrounds, UI
+ *        frames etc.)
+ *
+ * The elements are sorted and baked into a GPU buffer once, and each frame's
+ * `draw()` just binds it and draws a range per texture, without touching any
+ * vertices on the CPU. After adding or removing elements, or changing their
+ * vertices, call `invalidate()`. The next `draw()` then bakes them again,
+ * unless the sort keys and vertices hash the same as what's already baked.
+ */
+class StaticBatch
+{
+public:
+  /**
+   * @brief Construct an empty StaticBatch
+   *
+   * @param draw_mode the mode used to draw vertices (GL_TRIANGLES usually)
+   * @param attributes the vertex attributes of every element in the batch
+   */
+  StaticBatch(GLuint draw_mode, BarelyGL::VertexAttributeArray attributes);
+
+  /**
+   * @brief Adds an element to the batch (which must outlive it, or be removed)
+   *
+   * @param render_element the element to add
+   */
+  void add(const RenderElement* render_element);
+
+  /**
+   * @brief Removes an element from the batch
+   *
+   * @param render_element the element to remove
+   */
+  void remove(const RenderElement* render_element);
+
+  /**
+   * @brief Removes every element from the batch
+   */
+  void clear();
+
+  /**
+   * @brief Marks the batch to be baked again before it's next drawn
+   */
+  void invalidate() { dirty_ = true; }
+
+  /**
+   * @brief Draws the batch, baking it first if it was invalidated
+   *
+   * It binds textures itself, behind the back of any VertexBatcher or
+   * SpriteBatcher (which remember the texture they last bound), so it must
+   * not be called between a batcher's `begin()` and `end()`.
+   */
+  void draw();
+
+  /**
+   * @brief Get the number of draw calls the last `draw()` made
+   */
+  int draw_count() const { return draw_count_; }
+
+  /**
+   * @brief Get the number of times the batch has been uploaded to the GPU
+   */
+  int bake_count() const { return bake_count_; }
+
+  /**
+   * @brief Get the number of elements in the batch
+   */
+  size_t size() const { return elements_.size(); }
+
+  /**
+   * @struct Range
+   * @brief A run of baked vertices using the same texture
+   */
+  struct Range
+  {
+    /// The texture to draw the range with
+    const Texture* texture;
+    /// The first vertex of the range
+    GLint first;
+    /// The number of vertices in the range
+    GLsizei count;
+  };
+
+  /**
+   * @brief Hashes the sort keys and vertices of elements, to tell whether
+   *        they need baking again
+   *
+   * @param elements the elements, in the order they're baked
+   *
+   * @return the hash
+   */
+  static uint64_t hash(const std::vector<const RenderElement*>& elements);
+
+  /**
+   * @brief Concatenates the vertices of elements, merging the elements using
+   *        the same texture into one range
+   *
+   * @param elements the elements, in the order they're baked
+   * @param stride the number of floats in each vertex
+   * @param vertices filled with every element's vertices
+   * @param ranges filled with the ranges to draw (elements without vertices
+   *        are skipped)
+   */
+  static void build_ranges(const std::vector<const RenderElement*>& elements, size_t stride,
+                           std::vector<float>& vertices, std::vector<Range>& ranges);
+
+private:
+  /**
+   * @brief Sorts the elements and uploads them, if they have changed since
+   *        they were last baked
+   */
+  void bake();
+
+  /// The mode to draw the vertices with
+  GLuint draw_mode_;
+  /// The attributes describing the vertices
+  BarelyGL::VertexAttributeArray attributes_;
+  /// The vertex buffer object holding the baked vertices
+  BarelyGL::VertexBufferObject vbo_{GL_ARRAY_BUFFER, GL_STATIC_DRAW};
+  /// The vertex array object which holds the state of the attribute array and
+  /// vertex buffer object
+  BarelyGL::VertexArrayObject vao_{attributes_, &vbo_};
+  /// The elements in the batch
+  std::vector<const RenderElement*> elements_;
+  /// The runs of baked vertices, in the order they're drawn
+  std::vector<Range> ranges_;
+  /// The hash of the sort keys and vertices which were baked
+  uint64_t baked_hash_ = 0;
+  /// Whether the elements need baking again
+  bool dirty_ = false;
+  /// The number of draw calls the last `draw()` made
+  int draw_count_ = 0;
+  /// The number of times the batch has been uploaded
+  int bake_count_ = 0;
+};
+} // end of namespace BarelyEngine
+
+#endif // defined(BE_STATIC_BATCH_H)
@@ -7,13 +7,24 @@
 #define BE_TEXTURE_H
 
 #include <memory>
+#include <vector>
 #include <OpenGL/gltypes.h>
 #include <BarelyGL/texture.h>
+#include "mip_chain.h"
+#include "resource_inventory.h"
 
 namespace BarelyEngine {
+class CompressedImage;
+class TextureArray;
+struct CompressedLevel;
+
 /**
  * @class Texture
  * @brief Wrapper around GL::Texture
+ *
+ * Block-compressed textures aren't supported by GL::Texture, so those are
+ * created and managed directly. A texture can also stand for a single layer
+ * of a TextureArray, in which case it binds the whole array.
  */
 class Texture
 {
@@ -52,6 +63,111 @@ public:
    */
   Texture(int width, int height, GLenum format, const void* pixels);
 
+  /**
+   * @brief Construct a block-compressed texture, uploading every level
+   *
+   * @param image the compressed image to upload
+   */
+  Texture(const CompressedImage& image);
+
+  /**
+   * @brief Construct a block-compressed texture from levels stored elsewhere,
+   *        uploading every level
+   *
+   * @param compressed_format the compressed internal format
+   * @param levels the levels, largest first
+   * @param data the data the levels' offsets are relative to
+   */
+  Texture(GLenum compressed_format, const std::vector<CompressedLevel>& levels,
+          const uint8_t* data);
+
+  /**
+   * @brief Construct a texture standing for a layer of a texture array (these
+   *        are handed out by `TextureArray::add()`)
+   *
+   * @param array the array the layer belongs to
+   * @param layer the index of the layer
+   */
+  Texture(const TextureArray& array, int layer);
+
+  ~Texture();
+
+  /**
+   * @brief Checks whether the GPU can sample a compressed format
+   *
+   * The supported formats are queried the first time this is called (with the
+   * OpenGL context current) and remembered after that.
+   *
+   * @param compressed_format the compressed internal format
+   *
+   * @return true if the format is supported
+   */
+  static bool supports(GLenum compressed_format);
+
+  /**
+   * @brief Gets the size of a pixel stored in an uncompressed internal format
+   *
+   * @param internal_format the internal format
+   *
+   * @return the number of bytes (usually padded out to 4)
+   */
+  static size_t bytes_per_pixel(GLenum internal_format);
+
+  /**
+   * @brief Checks whether two textures are bound as the same OpenGL texture
+   *        (layers of a texture array are)
+   *
+   * @param a the first texture (may be null)
+   * @param b the second texture (may be null)
+   *
+   * @return true if binding either would bind the same texture
+   */
+  static bool same(const Texture* a, const Texture* b);
+
+  /**
+   * @brief Uploads the mipmap levels below the base level and switches to
+   *        trilinear filtering
+   *
+   * @param levels the levels, starting with level 1
+   * @param format pixel format of the levels (the same as the base level)
+   */
+  void upload_mipmaps(const std::vector<MipLevel>& levels, GLenum format);
+
+  /**
+   * @brief Uploads the mipmap levels below the base level from pixels stored
+   *        elsewhere, and switches to trilinear filtering
+   *
+   * @param levels the tightly packed pixels of each level, starting with level 1
+   * @param format pixel format of the levels (the same as the base level)
+   */
+  void upload_mipmaps(const std::vector<const void*>& levels, GLenum format);
+
+  /**
+   * @brief Starts streaming in a full mipmap chain
+   *
+   * Only the smallest levels are uploaded straight away, and the texture is
+   * sampled from those until the larger levels are uploaded one at a time by
+   * `refine()`. The base level passed to the constructor is ignored (it may be
+   * null) until it is refined.
+   *
+   * @param levels the full chain, starting with level 0
+   * @param format pixel format of the levels
+   * @param resident_levels how many of the smallest levels to upload now
+   */
+  void stream_mipmaps(std::vector<MipLevel> levels, GLenum format, size_t resident_levels);
+
+  /**
+   * @brief Uploads the next larger level of a streaming texture
+   *
+   * @return true if there are still levels waiting to be uploaded
+   */
+  bool refine();
+
+  /**
+   * @brief Whether there are still levels waiting to be uploaded by `refine()`
+   */
+  bool streaming() const { return !pending_levels_.empty(); }
+
   /**
    * @brief Bind the texture for the next set of draw calls
    */
@@ -60,7 +176,7 @@ public:
   /**
    * @brief Uploads raw data to part of the texture
    *
-   * Note: Must call `bind()` first!
+   * Note: Must call `bind()` first! Not available for compressed textures.
    *
    * @param x_offset the x offset into texture
    * @param y_offset the y offset into texture
@@ -96,13 +212,75 @@ public:
    */
   uint32_t id() const;
 
+  /**
+   * @brief Get the layer of the texture array this texture stands for
+   *
+   * @return an int of the layer (0 if it isn't part of an array)
+   */
+  int layer() const { return layer_; }
+
+  /**
+   * @brief Get the (approximate) GPU memory used by the texture, including
+   * any mipmaps uploaded so far
+   *
+   * @return size_t of the number of bytes
+   */
+  size_t gpu_size() const { return gpu_size_; }
+
+  /**
+   * @brief Get the CPU memory held by the texture (the levels of a streaming
+   * texture waiting to be uploaded)
+   *
+   * @return size_t of the number of bytes
+   */
+  size_t cpu_size() const;
+
   Texture(const Texture& other) = delete;
   Texture& operator=(const Texture& other) = delete;
 
 private:
-  /// The underlying BarelyGL::Texture object
+  /**
+   * @brief Uploads a single level of the bound texture
+   */
+  void upload_level(int level, int width, int height, GLenum format, const void* pixels);
+
+  /**
+   * @brief Sets the range of levels which are sampled from (of the bound
+   *        texture)
+   */
+  void set_level_range(int base_level, int max_level);
+
+  /// The underlying BarelyGL::Texture object (null if compressed)
   std::unique_ptr<BarelyGL::Texture> texture_;
+  /// The name of the compressed texture (0 if not compressed)
+  GLuint compressed_id_ = 0;
+  /// The width of the compressed texture
+  int compressed_width_ = 0;
+  /// The height of the compressed texture
+  int compressed_height_ = 0;
+  /// The format the texture is stored as
+  GLenum internal_format_ = 0;
+  /// The levels of a streaming texture still to be uploaded (smallest last)
+  std::vector<MipLevel> pending_levels_;
+  /// The pixel format of the levels still to be uploaded
+  GLenum pending_format_ = 0;
+  /// The smallest level of a streaming texture
+  int max_level_ = 0;
+  /// The memory used by every level uploaded so far
+  size_t gpu_size_ = 0;
+  /// The array this texture is a layer of (null if it isn't part of an array)
+  const TextureArray* array_ = nullptr;
+  /// The layer of the array
+  int layer_ = 0;
 };
+
+/**
+ * @brief Gets the memory a texture uses, for ResourceManager's accounting
+ */
+inline ResourceMemory resource_memory(const Texture& texture)
+{
+  return {texture.cpu_size(), texture.gpu_size()};
+}
 } // end of namespace BarelyEngine
 
 #endif // defined(BE_TEXTURE_H)
@@ -0,0 +1,154 @@
+//
+// gfx/texture_array.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BE_TEXTURE_ARRAY_H
+#define BE_TEXTURE_ARRAY_H
+
+#include <memory>
+#include <vector>
+#include <OpenGL/gltypes.h>
+#include "resource_inventory.h"
+
+namespace BarelyEngine {
+class Texture;
+
+/**
+ * @class TextureArray
+ * @brief A GL_TEXTURE_2D_ARRAY holding same-sized images as layers
+ *
+ * Each layer is handed out as a Texture which shares the array's id, so
+ * elements drawn with different layers have the same sort key and are
+ * batched into one draw. TexturedQuad writes the layer into the z component
+ * of each vertex's position, for the shader to sample with
+ * `texture(sampler2DArray, vec3(uv, position.z))`.
+ */
+class TextureArray
+{
+public:
+  /**
+   * @brief Construct an empty texture array
+   *
+   * @param width width of every layer
+   * @param height height of every layer
+   * @param capacity the number of layers to make room for
+   * @param internal_format format the layers should be stored as
+   */
+  TextureArray(int width, int height, int capacity, GLenum internal_format);
+
+  /**
+   * @brief Construct an empty texture array, stored as GL_RGBA8
+   *
+   * @param width width of every layer
+   * @param height height of every layer
+   * @param capacity the number of layers to make room for
+   */
+  TextureArray(int width, int height, int capacity);
+
+  ~TextureArray();
+
+  TextureArray(const TextureArray& other) = delete;
+  TextureArray& operator=(const TextureArray& other) = delete;
+
+  /**
+   * @brief Uploads an image into the next free layer
+   *
+   * Throws an Exception if the array is full.
+   *
+   * @param format pixel format of the data
+   * @param pixels raw pixel data, the same size as the array
+   *
+   * @return the texture to draw the layer with (owned by the array)
+   */
+  const Texture* add(GLenum format, const void* pixels);
+
+  /**
+   * @brief Generates mipmaps for every layer (after they've all been added)
+   */
+  void generate_mipmaps();
+
+  /**
+   * @brief Bind the array for the next set of draw calls
+   */
+  void bind() const;
+
+  /**
+   * @brief Unbinds the array
+   */
+  void unbind() const;
+
+  /**
+   * @brief Get the texture for a layer
+   *
+   * @param layer the index of the layer
+   *
+   * @return the texture to draw the layer with
+   */
+  const Texture* layer(int layer) const { return layers_[static_cast<size_t>(layer)].get(); }
+
+  /**
+   * @brief Get the width of every layer
+   */
+  int width() const { return width_; }
+
+  /**
+   * @brief Get the height of every layer
+   */
+  int height() const { return height_; }
+
+  /**
+   * @brief Get the number of layers added so far
+   */
+  int size() const { return static_cast<int>(layers_.size()); }
+
+  /**
+   * @brief Get the number of layers there is room for
+   */
+  int capacity() const { return capacity_; }
+
+  /**
+   * @brief Get the id of the array
+   */
+  uint32_t id() const { return id_; }
+
+  /**
+   * @brief Get the (approximate) GPU memory used by the array, including
+   * any mipmaps
+   *
+   * @return size_t of the number of bytes
+   */
+  size_t gpu_size() const { return gpu_size_; }
+
+private:
+  /**
+   * @brief Gets the memory used by the base level of every layer
+   */
+  size_t base_size() const;
+
+  /// The name of the array texture
+  GLuint id_ = 0;
+  /// The width of every layer
+  int width_;
+  /// The height of every layer
+  int height_;
+  /// The number of layers there is room for
+  int capacity_;
+  /// The format the layers are stored as
+  GLenum internal_format_;
+  /// The textures handed out for each layer added so far
+  std::vector<std::unique_ptr<Texture>> layers_;
+  /// The memory used by the array's storage
+  size_t gpu_size_ = 0;
+};
+
+/**
+ * @brief Gets the memory a texture array uses, for ResourceManager's accounting
+ */
+inline ResourceMemory resource_memory(const TextureArray& array)
+{
+  return {0, array.gpu_size()};
+}
+} // end of namespace BarelyEngine
+
+#endif // defined(BE_TEXTURE_ARRAY_H)
@@ -6,17 +6,58 @@
 #ifndef BE_VERTEX_BATCHER_H
 #define BE_VERTEX_BATCHER_H
 
+#include <cstdint>
 #include <vector>
 #include <OpenGL/gl3.h>
 #include <BarelyGL/gl.h>
+#include "rect.h"
+#include "render_stats.h"
 
 namespace BarelyEngine {
 class RenderElement;
 class Texture;
 
+/**
+ * @class enum SubmitMode
+ * @brief When a VertexBatcher sends its batches to OpenGL
+ */
+enum class SubmitMode
+{
+  /// Each batch is uploaded and drawn as soon as it's finished
+  BATCH,
+  /// Every batch in the frame is uploaded at once when the batcher ends, then
+  /// drawn with as few draw calls (and binds) as possible
+  FRAME
+};
+
+/**
+ * @struct DrawArraysIndirectCommand
+ * @brief A single draw, laid out as OpenGL expects in an indirect buffer
+ */
+struct DrawArraysIndirectCommand
+{
+  /// The number of vertices to draw
+  GLuint count;
+  /// The number of instances to draw
+  GLuint instance_count;
+  /// The first vertex to draw
+  GLuint first;
+  /// The first instance to draw (must be 0 before OpenGL 4.2)
+  GLuint base_instance;
+};
+
 /**
  * @class VertexBatcher
  * @brief Class that batches drawing vertices from the same texture
+ *
+ * The layers of a TextureArray count as the same texture, so elements drawn
+ * with different layers still share a batch.
+ *
+ * In SubmitMode::FRAME, the batches for the whole frame are recorded as draw
+ * commands into a single vertex buffer. When the batcher ends, the buffer is
+ * uploaded once and the VAO bound once, then each run of commands using the
+ * same texture is drawn with a single `glMultiDrawArraysIndirect()` (on
+ * OpenGL 4.3+) or `glMultiDrawArrays()` call.
  */
 class VertexBatcher
 {
@@ -34,15 +75,61 @@ public:
    *
    * @param draw_mode the mode used to draw vertices (GL_TRIANGLES usually)
    * @param attributes the vertex attributes to be used when drawing vertices
-   * @param max_vertices the maxium number of vertices to draw at once
+   * @param max_vertices the maxium number of vertices to draw at once (in
+   *        SubmitMode::FRAME, the number to make room for initially), which
+   *        must be at least one primitive's worth
+   * @param submit_mode when to send batches to OpenGL
    */
-  VertexBatcher(GLuint draw_mode, BarelyGL::VertexAttributeArray attributes, int max_vertices);
+  VertexBatcher(GLuint draw_mode, BarelyGL::VertexAttributeArray attributes, int max_vertices,
+                SubmitMode submit_mode = SubmitMode::BATCH);
+
+  ~VertexBatcher();
+
+  VertexBatcher(const VertexBatcher& other) = delete;
+  VertexBatcher& operator=(const VertexBatcher& other) = delete;
 
   /**
    * @brief Setup the batcher to being receiving vertices
    */
   void begin();
 
+  /**
+   * @brief Sets the area which can be seen, so elements outside of it are
+   * skipped by `draw()` before their vertices are copied
+   *
+   * @param viewport the visible area (usually `Window::viewport()`)
+   */
+  void set_viewport(const Rect& viewport);
+
+  /**
+   * @brief Stops skipping elements outside of the viewport
+   */
+  void clear_viewport() { cull_ = false; }
+
+  /**
+   * @brief Checks whether something is inside the viewport (always true if
+   * there isn't one), counting it as culled if it isn't
+   *
+   * This is for culling before vertices are generated for the raw `draw()`
+   * (e.g. by SpriteStore).
+   *
+   * @param bounds the bounds of what would be drawn
+   *
+   * @return true if it should be drawn
+   */
+  bool visible(const Rect& bounds)
+  {
+    if (!cull_ || bounds.intersects(viewport_))
+    {
+      return true;
+    }
+
+    culled_count_++;
+    RenderStats::frame().culled++;
+
+    return false;
+  }
+
   /**
    * @brief Add a render element to the batch to be drawn (containing all the
    * vertices that need to be drawn)
@@ -51,6 +138,23 @@ public:
    */
   void draw(const RenderElement* render_element);
 
+  /**
+   * @brief Add vertices to the batch to be drawn, without a RenderElement
+   * (e.g. vertices generated straight from a SpriteStore)
+   *
+   * The vertices aren't culled, as their layout isn't known here, so cull
+   * before generating them with `visible()` (SpriteStore and RenderBucket
+   * both do). If there are more of them than `capacity()`,
+   * they're split over several batches between whole triangles or lines
+   * (strips, fans and loops can't be split, so an Exception is thrown).
+   *
+   * @param texture the texture to draw the vertices with
+   * @param id the sort key of the vertices, as from `RenderElement::id()`
+   * @param vertices the vertices to draw
+   * @param count the number of floats in the vertices
+   */
+  void draw(const Texture* texture, uint64_t id, const float* vertices, size_t count);
+
   /**
    * @brief End the batcher and flush the remaining draw calls
    */
@@ -64,24 +168,63 @@ public:
    */
   int draw_count() const { return draw_count_; }
 
+  /**
+   * @brief Get the number of floats which can be drawn at once
+   *
+   * @return the maximum number of floats in a batch
+   */
+  size_t capacity() const { return max_size_; }
+
+  /**
+   * @brief Get the number of elements skipped per frame for being outside of
+   * the viewport
+   *
+   * @return the number of elements culled between `begin` and `end`
+   */
+  int culled_count() const { return culled_count_; }
+
 private:
   /**
    * @brief Checks whether the current set of vertices needs to be drawn before
    * adding a new set of vertices to the batch
    *
-   * @param render_element the element which may need to cause a flush
+   * @param id the sort key of the new vertices
+   * @param count the number of floats in the new vertices
+   * @param reason set to why the flush is needed (if it is)
    *
    * @return a bool indicating if a flush is needed
    */
-  bool needs_flush(const RenderElement* render_element) const;
+  bool needs_flush(uint64_t id, size_t count, FlushReason& reason) const;
+
+  /**
+   * @brief Flush the current set of vertices and draw them (or, in
+   * SubmitMode::FRAME, record a command to draw them at the end)
+   *
+   * @param reason why the batch is being flushed, for RenderStats
+   */
+  void flush(FlushReason reason);
+
+  /**
+   * @brief Uploads and draws every command recorded this frame
+   */
+  void submit_frame();
+
+  /**
+   * @brief Binds a texture, unless it is already bound
+   *
+   * @param texture the texture to bind (null leaves the bound texture alone)
+   */
+  void bind_texture(const Texture* texture);
 
   /**
-   * @brief Flush the current set of vertices and draw them
+   * @brief Checks whether the context has `glMultiDrawArraysIndirect()`
    */
-  void flush();
+  static bool supports_multi_draw_indirect();
 
   /// The mode to draw the vertices with
   GLuint draw_mode_;
+  /// When batches are sent to OpenGL
+  SubmitMode submit_mode_;
   /// The attributes to use when drawing the vertices
   BarelyGL::VertexAttributeArray attributes_;
   /// The vertex buffer object to be used for the vertices
@@ -99,10 +242,33 @@ private:
   std::vector<int> indices_;
   /// The last texture that was bound (to avoid binding needlessly)
   const Texture* last_bound_texture_ = nullptr;
-  /// The current element being drawn (or just drawn)
-  const RenderElement* current_element_ = nullptr;
+  /// The texture of the current batch
+  const Texture* current_texture_ = nullptr;
+  /// The sort key of the current batch
+  uint64_t current_id_ = 0;
+  /// Whether anything has been drawn since the batcher began
+  bool has_current_ = false;
   /// The number of times an OpenGL draw was performed
   int draw_count_ = 0;
+  /// Whether elements outside of the viewport are skipped
+  bool cull_ = false;
+  /// The area which can be seen
+  Rect viewport_;
+  /// The number of elements skipped for being outside of the viewport
+  int culled_count_ = 0;
+  /// The vertex capacity of the buffer (in floats) in SubmitMode::FRAME
+  size_t frame_capacity_ = 0;
+  /// The index of the first float not yet covered by a command
+  size_t batch_start_ = 0;
+  /// The draws recorded this frame, in SubmitMode::FRAME
+  std::vector<DrawArraysIndirectCommand> commands_;
+  /// The texture of each recorded draw
+  std::vector<const Texture*> command_textures_;
+  /// Scratch arrays for `glMultiDrawArrays()`
+  std::vector<GLint> firsts_;
+  std::vector<GLsizei> counts_;
+  /// The buffer holding the commands (0 without `glMultiDrawArraysIndirect()`)
+  GLuint indirect_buffer_ = 0;
 };
 } // end of namespace BarelyEngine
 
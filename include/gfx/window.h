@@ -7,6 +7,7 @@
 #define BE_WINDOW_H
 
 #include <string>
+#include "rect.h"
 
 struct SDL_Window;
 typedef void* SDL_GLContext;
@@ -51,6 +52,21 @@ public:
    */
   void swap_buffer();
 
+  /**
+   * @brief Gets the area of the window, for culling elements which can't be
+   *        seen
+   *
+   * The window doesn't know where the view is looking, so pass the position
+   * of the view's top left (e.g. the camera's offset) to get the area in the
+   * same space as the vertices.
+   *
+   * @param x the x position of the view's left edge
+   * @param y the y position of the view's top edge
+   *
+   * @returns a Rect from (x, y), the current size of the window
+   */
+  Rect viewport(float x = 0, float y = 0) const;
+
 private:
   /**
    * @brief Create the SDL window
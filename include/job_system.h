@@ -0,0 +1,236 @@
+//
+// job_system.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BE_JOB_SYSTEM_H
+#define BE_JOB_SYSTEM_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "cache_aligned.h"
+
+namespace BarelyEngine {
+class JobCounter;
+
+/**
+ * @struct Job
+ * @brief A function to be run by a JobSystem, and the counter to decrement
+ *        once it has finished
+ */
+struct Job
+{
+  /// The function to run (it mustn't throw)
+  std::function<void()> function;
+  /// The counter to decrement afterwards (may be null)
+  JobCounter* counter = nullptr;
+};
+
+/**
+ * @class JobCounter
+ * @brief Counts the jobs in a group which haven't finished yet
+ *
+ * Jobs run with a counter increment it when they're scheduled and decrement
+ * it when they finish, so the counter reaches zero once the whole group is
+ * done. It can be waited on with `JobSystem::wait()`, or used as a dependency
+ * of other jobs with `JobSystem::run_after()`.
+ *
+ * A counter must outlive its jobs, and should only be reused once it's done.
+ */
+class JobCounter
+{
+public:
+  /**
+   * @brief Construct a counter with no jobs
+   */
+  JobCounter()
+    : count_(0) {}
+
+  /**
+   * @brief Waits for the last job to let go of the counter
+   */
+  ~JobCounter() { std::lock_guard<std::mutex> lock(mutex_); }
+
+  JobCounter(const JobCounter& other) = delete;
+  JobCounter& operator=(const JobCounter& other) = delete;
+
+  /**
+   * @brief Whether every job has finished
+   */
+  bool done() const { return count_.load(std::memory_order_acquire) == 0; }
+
+  /**
+   * @brief Gets the number of jobs which haven't finished yet
+   */
+  size_t count() const { return count_.load(std::memory_order_acquire); }
+
+private:
+  friend class JobSystem;
+
+  /// The number of jobs which haven't finished
+  std::atomic<size_t> count_;
+  /// Guards `waiting_`
+  std::mutex mutex_;
+  /// Jobs to schedule once the count reaches zero
+  std::vector<Job> waiting_;
+};
+
+/**
+ * @class JobSystem
+ * @brief Runs jobs on a fixed pool of worker threads, shared by the whole
+ *        engine
+ *
+ * Each worker has its own deque of jobs. Jobs scheduled from a worker go onto
+ * the back of its own deque, and it takes jobs from the back too, so related
+ * work stays on the same core while it's still in the cache. A worker with an
+ * empty deque steals from the front of the others' deques (the oldest, and
+ * usually biggest, jobs). Jobs scheduled from any other thread go onto a
+ * shared deque which the workers steal from the same way.
+ *
+ * Threads waiting on a counter run jobs themselves rather than blocking, so
+ * jobs can wait on other jobs and the main thread helps out with the work.
+ * Idle workers sleep until there's something to do.
+ *
+ * The engine owns a JobSystem, created by `Engine::init()` or
+ * `Engine::start_jobs()` (see `Engine::jobs()`), so subsystems don't each
+ * start their own threads and oversubscribe the cores.
+ */
+class JobSystem
+{
+public:
+  /**
+   * @brief Construct a JobSystem and start its workers
+   *
+   * @param worker_count the number of worker threads (0 uses one fewer than
+   *        the number of cores, leaving one for the main thread)
+   */
+  explicit JobSystem(size_t worker_count = 0);
+
+  /**
+   * @brief Runs any jobs still queued, then stops the workers
+   */
+  ~JobSystem();
+
+  JobSystem(const JobSystem& other) = delete;
+  JobSystem& operator=(const JobSystem& other) = delete;
+
+  /**
+   * @brief Schedules a job
+   *
+   * @param function the function to run (it mustn't throw)
+   * @param counter a counter to track the job with (may be null)
+   */
+  void run(std::function<void()> function, JobCounter* counter = nullptr);
+
+  /**
+   * @brief Schedules a job to run once every job of another counter has
+   *        finished
+   *
+   * @param dependency the counter to wait for
+   * @param function the function to run (it mustn't throw)
+   * @param counter a counter to track the job with (may be null). It counts
+   *        the job straight away, even though the job isn't scheduled yet.
+   */
+  void run_after(JobCounter& dependency, std::function<void()> function,
+                 JobCounter* counter = nullptr);
+
+  /**
+   * @brief Runs jobs on the calling thread until every job of a counter has
+   *        finished
+   *
+   * @param counter the counter to wait for
+   */
+  void wait(JobCounter& counter);
+
+  /**
+   * @brief Calls a function for every index in a range, split into jobs, and
+   *        waits for them all to finish
+   *
+   * @param count the number of indices (0 to count - 1)
+   * @param grain the number of indices given to each job at most (0 splits
+   *        the range evenly over the workers, and the calling thread)
+   * @param function called with the first index and one past the last index
+   *        of each part of the range
+   */
+  void parallel_for(size_t count, size_t grain,
+                    const std::function<void(size_t begin, size_t end)>& function);
+
+  /**
+   * @brief Gets the number of worker threads
+   */
+  size_t worker_count() const { return workers_.size(); }
+
+private:
+  /**
+   * @struct Queue
+   * @brief The deque of jobs belonging to a thread, on cache lines of its own
+   */
+  struct alignas(64) Queue
+  {
+    /**
+     * @brief Allocates with cache line alignment (see `cache_aligned_new()`)
+     */
+    static void* operator new(size_t size) { return cache_aligned_new(size); }
+    static void operator delete(void* pointer) { std::free(pointer); }
+
+    /// Guards `jobs`
+    std::mutex mutex;
+    /// The jobs, oldest first
+    std::deque<Job> jobs;
+  };
+
+  /**
+   * @brief The loop run by each worker thread
+   *
+   * @param index the index of the worker's queue
+   */
+  void work(size_t index);
+
+  /**
+   * @brief Adds a job to the calling thread's queue, waking a worker
+   */
+  void schedule(Job job);
+
+  /**
+   * @brief Takes a job from the calling thread's queue, or steals one
+   *
+   * @param job the job taken
+   *
+   * @return false if there aren't any jobs
+   */
+  bool take(Job& job);
+
+  /**
+   * @brief Runs a job, then decrements its counter (scheduling any jobs which
+   *        depended on it)
+   */
+  void execute(Job& job);
+
+  /**
+   * @brief Gets the index of the calling thread's queue
+   */
+  size_t queue_index() const;
+
+  /// The queue of each thread (the shared queue first, then each worker's)
+  std::vector<std::unique_ptr<Queue>> queues_;
+  /// The worker threads
+  std::vector<std::thread> workers_;
+  /// The number of jobs in every queue
+  std::atomic<size_t> queued_;
+  /// Whether the workers should stop once the queues are empty
+  std::atomic<bool> stopping_;
+  /// Guards sleeping, so workers don't miss a wake-up
+  std::mutex sleep_mutex_;
+  /// Wakes sleeping workers when jobs are scheduled
+  std::condition_variable wake_;
+};
+} // end of namespace BarelyEngine
+
+#endif // defined(BE_JOB_SYSTEM_H)
@@ -6,8 +6,12 @@
 #ifndef BE_POINTER_HASH_H
 #define BE_POINTER_HASH_H
 
+#include <cstddef>
+#include <cstdint>
 #include <vector>
-#include <cassert>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
 namespace BarelyEngine {
 /**
@@ -30,15 +34,22 @@ namespace BarelyEngine {
  * and iterating over all key/value pairs was much quicker (access were only
  * slightly slower).
  *
- * Since the keys are all pointers which are fairly close together in memory,
- * just using the address as the 'hash' and using the modulo of the capacity
- * as the index produced the least amount of collisions. Using a prime capacity
- * is important for maximum efficiency though.
+ * The index array is an open-addressing table laid out like Google's
+ * SwissTable. Alongside the slots there is one control byte per slot, which is
+ * either `kEmpty` or the low 7 bits of the key's hash. Slots are probed a group
+ * of 16 at a time: the group's control bytes are compared against the hash
+ * bits all at once (with SSE2 where available), so usually only the one slot
+ * that really holds the key gets looked at.
  *
- * This method also allows you to set the size of the hash table larger without
- * wasting memory, since you only store as many ValueEntries as needed.
+ * Since string literals are packed closely together and aligned, their raw
+ * addresses make for poor hashes, so the address bits are mixed first.
+ *
+ * The table grows (doubling the number of groups) once it is 7/8 full, so
+ * there is no limit on the number of keys. Growing only rebuilds the index
+ * array, although it may move the values; don't hold on to references
+ * returned by `operator[]` across insertions.
  */
-template <typename P, typename T, size_t capacity>
+template <typename P, typename T, size_t initial_capacity = 16>
 class PointerHash
 {
 public:
@@ -80,9 +91,9 @@ public:
    * @brief Construct a new PointerHash
    */
   PointerHash()
-    : size_(0)
   {
-    values_.reserve(capacity);
+    resize((initial_capacity + kGroupWidth - 1) / kGroupWidth);
+    values_.reserve(initial_capacity);
   };
 
   /**
@@ -95,64 +106,221 @@ public:
    *
    * @return a reference to the value corresponding to the pointer key
    */
-  T& operator[](P ptr)
+  T& operator[](P ptr);
+
+  /**
+   * @brief Returns the collection of key/value pairs for iteration
+   *
+   * @return an array of ValueEntry's containing the key/value pairs
+   */
+  const std::vector<ValueEntry>& pairs() const { return values_; }
+
+  /**
+   * @brief Returns the number of key/value pairs in the hash table
+   *
+   * @return the number of key/value pairs in the hash table
+   */
+  size_t size() const { return values_.size(); }
+
+  /**
+   * @brief Returns the number of slots in the index array
+   *
+   * @return the number of slots in the index array
+   */
+  size_t capacity() const { return slots_.size(); }
+
+private:
+  /// The number of slots probed at once
+  static constexpr size_t kGroupWidth = 16;
+  /// The control byte marking an empty slot (a hash byte never has the top bit set)
+  static constexpr uint8_t kEmpty = 0x80;
+
+  /**
+   * @brief Returns the hash of a pointer
+   *
+   * Uses the MurmurHash3 finaliser to spread the (aligned, clustered) address
+   * bits across the whole hash.
+   *
+   * @return the hash of a pointer
+   */
+  static uint64_t hash(P ptr)
   {
-    auto index = hash(ptr) % capacity;
+    auto h = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(ptr));
 
-    // Loop through the table and look for an empty index
-    do
-    {
-      auto& entry = indices_[index];
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
 
-      if (entry.ptr == ptr)
-      {
-        // Found it!
-        return values_[entry.index].second;
-      }
-      else if (entry.ptr != nullptr)
-      {
-        // Keep on searchin'
-        index = (index + 1) % capacity;
-      }
-      else if (entry.ptr == nullptr)
-      {
-        // Empty slot, use it!
-        entry.ptr = ptr;
-        entry.index = size_;
+    return h;
+  }
 
-        values_.emplace_back(ptr);
-        return values_[size_++].second;
-      }
+  /**
+   * @brief Returns a bit mask of the slots in a group whose control byte
+   *        matches the given byte
+   *
+   * @param group index of the first slot in the group
+   * @param byte the control byte to look for
+   *
+   * @return a mask with bit i set if slot (group + i) matches
+   */
+  uint32_t match(size_t group, uint8_t byte) const
+  {
+#if defined(__SSE2__)
+    const auto ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&ctrl_[group]));
+    const auto target = _mm_set1_epi8(static_cast<char>(byte));
 
-      // Stop an infinite loop by making sure we aren't trying to add more than
-      // we can handle!
-      assert(size_ != capacity);
+    return static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(ctrl, target)));
+#else
+    uint32_t mask = 0;
+
+    for (size_t i = 0; i < kGroupWidth; i++)
+    {
+      if (ctrl_[group + i] == byte) mask |= 1u << i;
     }
-    while (true);   // Keep going 'til we find a space
+
+    return mask;
+#endif
   }
 
   /**
-   * @brief Returns the collection of key/value pairs for iteration
+   * @brief Returns the index of the lowest set bit
+   */
+  static size_t lowest_bit(uint32_t mask)
+  {
+#if defined(__GNUC__)
+    return __builtin_ctz(mask);
+#else
+    size_t bit = 0;
+    while ((mask & 1) == 0) { mask >>= 1; bit++; }
+    return bit;
+#endif
+  }
+
+  /**
+   * @brief Finds an empty slot for a key which isn't in the table
    *
-   * @return an array of ValueEntry's containing the key/value pairs
+   * @param h the hash of the key
+   *
+   * @return the index of the slot
    */
-  const std::vector<ValueEntry>& pairs() const { return values_; }
+  size_t find_empty(uint64_t h) const;
 
-private:
   /**
-   * @brief Returns the hash of a pointer
+   * @brief Resizes the index array and re-inserts every key
    *
-   * @return the hash of a pointer
+   * @param num_groups the new number of groups (rounded up to a power of two)
    */
-  size_t hash(P ptr) { return reinterpret_cast<size_t>(ptr); }
+  void resize(size_t num_groups);
 
+  /// The control bytes, one per slot
+  std::vector<uint8_t> ctrl_;
   /// The array of key/index pairs
-  IndexEntry indices_[capacity];
+  std::vector<IndexEntry> slots_;
   /// The array of key/value pairs
   std::vector<ValueEntry> values_;
-  /// The number of key/value pairs in the hash table
-  size_t size_;
+  /// Mask used to wrap a group number into the table
+  size_t group_mask_ = 0;
 };
+
+template <typename P, typename T, size_t initial_capacity>
+constexpr size_t PointerHash<P, T, initial_capacity>::kGroupWidth;
+
+template <typename P, typename T, size_t initial_capacity>
+constexpr uint8_t PointerHash<P, T, initial_capacity>::kEmpty;
+
+template <typename P, typename T, size_t initial_capacity>
+T& PointerHash<P, T, initial_capacity>::operator[](P ptr)
+{
+  const auto h = hash(ptr);
+  const auto h2 = static_cast<uint8_t>(h & 0x7F);
+  auto group = static_cast<size_t>(h >> 7) & group_mask_;
+
+  // Probe group by group (triangular probing visits every group once)
+  for (size_t step = 1;; step++)
+  {
+    const auto first_slot = group * kGroupWidth;
+
+    for (auto candidates = match(first_slot, h2); candidates != 0; candidates &= candidates - 1)
+    {
+      const auto& entry = slots_[first_slot + lowest_bit(candidates)];
+
+      if (entry.ptr == ptr)
+      {
+        // Found it!
+        return values_[entry.index].second;
+      }
+    }
+
+    // An empty slot means the key can't be any further along
+    if (match(first_slot, kEmpty) != 0) break;
+
+    group = (group + step) & group_mask_;
+  }
+
+  // Not found, so insert it (growing first if we're getting too full)
+  if ((values_.size() + 1) * 8 > capacity() * 7)
+  {
+    resize((group_mask_ + 1) * 2);
+  }
+
+  const auto slot = find_empty(h);
+
+  ctrl_[slot] = h2;
+  slots_[slot].ptr = ptr;
+  slots_[slot].index = values_.size();
+
+  values_.emplace_back(ptr);
+  return values_.back().second;
+}
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+template <typename P, typename T, size_t initial_capacity>
+size_t PointerHash<P, T, initial_capacity>::find_empty(const uint64_t h) const
+{
+  auto group = static_cast<size_t>(h >> 7) & group_mask_;
+
+  for (size_t step = 1;; step++)
+  {
+    const auto first_slot = group * kGroupWidth;
+    const auto empty = match(first_slot, kEmpty);
+
+    if (empty != 0)
+    {
+      return first_slot + lowest_bit(empty);
+    }
+
+    group = (group + step) & group_mask_;
+  }
+}
+
+template <typename P, typename T, size_t initial_capacity>
+void PointerHash<P, T, initial_capacity>::resize(size_t num_groups)
+{
+  // Triangular probing only covers every group when there's a power of two
+  size_t groups = 1;
+  while (groups < num_groups) groups *= 2;
+
+  group_mask_ = groups - 1;
+  ctrl_.assign(groups * kGroupWidth, kEmpty);
+  slots_.assign(groups * kGroupWidth, IndexEntry());
+
+  for (size_t i = 0; i < values_.size(); i++)
+  {
+    const auto h = hash(values_[i].first);
+    const auto slot = find_empty(h);
+
+    ctrl_[slot] = static_cast<uint8_t>(h & 0x7F);
+    slots_[slot].ptr = values_[i].first;
+    slots_[slot].index = i;
+  }
+}
 } // end of namespace BarelyEngine
 
 #endif // defined(BE_POINTER_HASH_H)
@@ -6,11 +6,19 @@
 #ifndef BE_RESOURCE_H
 #define BE_RESOURCE_H
 
+#include <memory>
+#include <string>
+
 namespace BarelyEngine {
 typedef std::string resource_id_t;
+
 /**
  * @class Resource
  * @brief Lightweight resource handle, used instead of raw pointers to data
+ *
+ * Handles given out by a ResourceManager share a reference to the resource,
+ * and the manager won't unload a resource while any copies of its handles
+ * are alive.
  */
 template <typename T>
 class Resource
@@ -32,6 +40,16 @@ public:
   Resource(const std::string& name)
     : name_(name) {};
 
+  /**
+   * @brief Construct a resource handle which keeps a resource referenced
+   *
+   * @param name the name of the resource
+   * @param reference the reference shared by all handles to the resource
+   */
+  Resource(const std::string& name, std::shared_ptr<const void> reference)
+    : name_(name)
+    , reference_(std::move(reference)) {};
+
   /**
    * @brief Checks whether this handle is empty (not pointing to a resource)
    *
@@ -52,6 +70,8 @@ public:
 private:
   /// The name of this resource (currently used as the ID)
   std::string name_;
+  /// Keeps the resource loaded while this handle (or a copy) is alive
+  std::shared_ptr<const void> reference_;
 };
 } // end of namespace BarelyEngine
 
@@ -0,0 +1,75 @@
+//
+// resource_inventory.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BE_RESOURCE_INVENTORY_H
+#define BE_RESOURCE_INVENTORY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace BarelyEngine {
+/**
+ * @struct ResourceMemory
+ * @brief The memory used by a resource
+ */
+struct ResourceMemory
+{
+  /// Bytes held in CPU memory
+  size_t cpu = 0;
+  /// Bytes held in GPU memory
+  size_t gpu = 0;
+
+  /**
+   * @brief Gets the memory used altogether
+   */
+  size_t total() const { return cpu + gpu; }
+};
+
+/**
+ * @brief Gets the memory used by a resource, which counts towards its
+ *        manager's budget and shows up in its inventory
+ *
+ * Overload this (in the resource's namespace) for each type of resource which
+ * should be accounted for. Resources without an overload use no memory.
+ *
+ * @return the memory used by the resource
+ */
+template <typename T>
+ResourceMemory resource_memory(const T&) { return {}; }
+
+/**
+ * @struct ResourceInfo
+ * @brief A snapshot of a loaded resource, as listed in an inventory
+ */
+struct ResourceInfo
+{
+  /// The name the resource is stored under
+  std::string name;
+  /// The filename the resource was loaded from
+  std::string filename;
+  /// The memory used by the resource
+  ResourceMemory memory;
+  /// How long the resource took to load, in milliseconds
+  double load_time = 0.0;
+  /// The frame the resource was last used on
+  uint64_t last_used_frame = 0;
+  /// The number of handles to the resource which are alive
+  long references = 0;
+};
+
+/**
+ * @brief Formats an inventory as a table, with a line of totals first
+ *
+ * @param title the name of the inventory (e.g. "Textures")
+ * @param inventory the resources in the inventory
+ *
+ * @return the table, one line per resource
+ */
+std::string format_inventory(const std::string& title, const std::vector<ResourceInfo>& inventory);
+} // end of namespace BarelyEngine
+
+#endif // defined(BE_RESOURCE_INVENTORY_H)
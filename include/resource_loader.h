@@ -6,6 +6,7 @@
 #ifndef BE_RESOURCE_LOADER_H
 #define BE_RESOURCE_LOADER_H
 
+#include <cstdint>
 #include "logging.h"
 
 namespace BarelyEngine {
@@ -30,6 +31,60 @@ public:
    */
   virtual std::unique_ptr<T> load(const std::string& filename, const LoaderOptions<L>& options) = 0;
 
+  /**
+   * @brief Does whatever work towards loading a resource can be done ahead of
+   *        time, so that `load()` is quicker. This is called on worker
+   *        threads, so must be thread safe (though it can log, including
+   *        through `loading()` and `failed()`). Nothing is done by default.
+   *
+   * @param filename the filename of the resource to load
+   * @param options the options used to load the resource
+   */
+  virtual void prefetch(const std::string& /* filename */,
+                        const LoaderOptions<L>& /* options */) {}
+
+  /**
+   * @brief Throws away whatever `prefetch()` did for a resource which isn't
+   *        going to be loaded after all, e.g. because an identical resource is
+   *        shared instead. Nothing is done by default.
+   *
+   * @param filename the filename of the resource
+   * @param options the options the resource was prefetched with
+   */
+  virtual void discard_prefetched(const std::string& /* filename */,
+                                  const LoaderOptions<L>& /* options */) {}
+
+  /**
+   * @brief Gets where a resource should come in the order resources are
+   *        prefetched in (lowest first), e.g. so that files are read in the
+   *        order they're laid out on disk. By default the order isn't changed.
+   *
+   * @param filename the filename of the resource
+   *
+   * @return the position of the resource in the order
+   */
+  virtual uint64_t prefetch_order(const std::string& /* filename */) { return 0; }
+
+  /**
+   * @brief Hashes the contents of a resource, along with the options it's
+   *        loaded with, so that identical resources can be shared. By default
+   *        resources aren't hashed (or shared).
+   *
+   * While prefetching, this is called on a worker thread straight after
+   * `prefetch()`, so the two may share what they read (and must both be safe
+   * to call from several threads at once).
+   *
+   * @param filename the filename of the resource
+   * @param options the options used to load the resource
+   *
+   * @return the hash, or 0 if it's unknown
+   */
+  virtual uint64_t content_hash(const std::string& /* filename */,
+                                const LoaderOptions<L>& /* options */)
+  {
+    return 0;
+  }
+
 protected:
   /**
    * @brief Callback when the resource is loading (for logging)
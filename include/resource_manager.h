@@ -6,11 +6,23 @@
 #ifndef BE_RESOURCE_MANAGER_H
 #define BE_RESOURCE_MANAGER_H
 
+#include <algorithm>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <limits>
+#include <memory>
 #include <unordered_map>
+#include <unordered_set>
 #include <string>
+#include <vector>
+#include "job_system.h"
+#include "resource_inventory.h"
 #include "resource_loader.h"
+#include "resource_manifest.h"
 #include "resource.h"
 #include "logging.h"
+#include "timer.h"
 
 namespace BarelyEngine {
 /**
@@ -20,8 +32,21 @@ namespace BarelyEngine {
  * This is a very simple implementation of a resource manager, using handles
  * instead of raw pointers to resources. This means that later on it will be
  * much easier to add more sophisticated managing of resources (dedicated handle
- * manager, reference counting etc) if needed, without needing to change too
- * much client code.
+ * manager etc) if needed, without needing to change too much client code.
+ *
+ * Handles are reference counted. Each manager can be given a budget (in bytes,
+ * as measured by `resource_memory()` when loaded), and when its resources go
+ * over budget the least recently used ones without any handles alive are
+ * unloaded. Unloaded resources are loaded again, from their load state, the
+ * next time they're asked for.
+ *
+ * `inventory()` lists what each loaded resource costs, and the manager can log
+ * it periodically if `next_frame()` is called once per frame.
+ *
+ * If the loader can hash the contents of resources (see
+ * `ResourceLoader::content_hash()`), resources with identical contents (and
+ * options) share a single loaded copy, however many names or files they're
+ * loaded from. Shared resources are only counted once towards the budget.
  */
 template <typename T, typename L>
 class ResourceManager
@@ -81,12 +106,50 @@ public:
   template <typename... Args>
   const Resource<T> load(const std::string& filename, const std::string& name, Args... options);
 
+  /**
+   * @brief Loads every resource in a manifest which isn't loaded yet, e.g.
+   * while showing a loading screen
+   *
+   * Jobs prefetch the resources (see `ResourceLoader::prefetch()`) in the
+   * order the loader prefers, while this thread finishes loading each one as
+   * soon as it has been prefetched (running prefetch jobs itself while it
+   * waits). Only a couple of resources per worker are prefetched ahead of the
+   * loading. If prefetching throws, the exception is rethrown here once the
+   * jobs already scheduled have finished.
+   *
+   * @param manifest the resources to load
+   * @param jobs the job system to prefetch with
+   * @param progress called after each resource is loaded, with the number
+   *        loaded so far and the number being loaded altogether
+   *
+   * @return the number of resources loaded successfully
+   */
+  size_t prefetch(const ResourceManifest<L>& manifest, JobSystem& jobs,
+                  const std::function<void(size_t, size_t)>& progress = nullptr);
+
+  /**
+   * @brief Loads every resource in a manifest which isn't loaded yet, with
+   *        the engine's job system (see `Engine::jobs()`)
+   *
+   * @param manifest the resources to load
+   * @param progress called after each resource is loaded, with the number
+   *        loaded so far and the number being loaded altogether
+   *
+   * @return the number of resources loaded successfully
+   */
+  size_t prefetch(const ResourceManifest<L>& manifest,
+                  const std::function<void(size_t, size_t)>& progress = nullptr)
+  {
+    return prefetch(manifest, Engine::jobs(), progress);
+  }
+
   /**
    * @brief Gets the specified resource with type T
    *
    * @param name the file name of the resource to get
    *
    * @return a handle to the resource requested or a null handle if not found
+   *         (resources which were unloaded are loaded again)
    */
   const Resource<T> get(const std::string& name);
 
@@ -111,6 +174,20 @@ public:
    */
   void reload(const std::string& name);
 
+  /**
+   * @brief Reload only the resources loaded from certain files
+   *
+   * Every loaded resource from one of the files is reloaded, however many
+   * names it was stored under (unloaded resources pick up the changes when
+   * they're next loaded). Filenames are as they were passed to `load()`,
+   * which is how ResourceWatcher reports changed files.
+   *
+   * @param filenames the files which have changed
+   *
+   * @return the number of resources reloaded
+   */
+  size_t reload_files(const std::vector<std::string>& filenames);
+
   /**
    * @brief Gets the number of resources currently loaded
    *
@@ -118,7 +195,112 @@ public:
    */
   size_t count() const { return resources_.size(); }
 
+  /**
+   * @brief Sets the budget for the resources, unloading any which are over it
+   *
+   * @param bytes the budget in bytes
+   */
+  void set_budget(size_t bytes);
+
+  /**
+   * @brief Gets the budget for the resources
+   *
+   * @return size_t of the budget in bytes (the maximum size_t if unlimited)
+   */
+  size_t budget() const { return budget_; }
+
+  /**
+   * @brief Gets the memory used by the resources currently loaded
+   *
+   * @return size_t of the number of bytes
+   */
+  size_t resident_bytes() const { return resident_bytes_; }
+
+  /**
+   * @brief Unloads the least recently used resources without any handles
+   * alive, until the resources fit in the budget
+   *
+   * This happens automatically whenever a resource is loaded, but handles may
+   * have been dropped since then.
+   */
+  void trim();
+
+  /**
+   * @brief Takes a snapshot of every loaded resource
+   *
+   * @return the resources, using the most memory first
+   */
+  std::vector<ResourceInfo> inventory() const;
+
+  /**
+   * @brief Logs the inventory of loaded resources
+   *
+   * @param title the name of the inventory in the log (e.g. "Textures")
+   */
+  void log_inventory(const std::string& title) const;
+
+  /**
+   * @brief Moves on to the next frame, which resources are marked as last used
+   * on, and logs the inventory if it's due
+   */
+  void next_frame();
+
+  /**
+   * @brief Logs the inventory every so many frames
+   *
+   * @param frames the number of frames between each log (0 to stop logging)
+   * @param title the name of the inventory in the log
+   */
+  void set_report_interval(uint64_t frames, const std::string& title);
+
+  /**
+   * @brief Gets the current frame
+   *
+   * @return uint64_t of the number of calls to `next_frame()`
+   */
+  uint64_t frame() const { return frame_; }
+
 private:
+  /**
+   * @struct Entry
+   * @brief A loaded resource and its bookkeeping
+   */
+  struct Entry
+  {
+    /// The resource itself (which may be shared with other names)
+    std::shared_ptr<T> resource;
+    /// The hash of the resource's contents (0 if unknown)
+    uint64_t hash = 0;
+    /// The size of the resource in bytes (when it was loaded)
+    size_t size = 0;
+    /// How long the resource took to load, in milliseconds
+    double load_time = 0.0;
+    /// When the resource was last used (in `use_clock_` ticks)
+    mutable uint64_t last_used = 0;
+    /// The frame the resource was last used on
+    mutable uint64_t last_used_frame = 0;
+    /// The reference shared by all the handles to the resource
+    std::weak_ptr<const void> reference;
+  };
+
+  /**
+   * @brief Makes a handle to a loaded resource, marking it as used
+   *
+   * @param name the name of the resource
+   * @param entry the entry for the resource
+   *
+   * @return a handle sharing the resource's reference
+   */
+  const Resource<T> handle(const std::string& name, Entry& entry);
+
+  /**
+   * @brief Stops counting an entry's resource towards the budget (and stops
+   * sharing it by its hash), if no other names share it
+   *
+   * @param entry the entry which is about to let go of its resource
+   */
+  void release(const Entry& entry);
+
   /**
    * @brief Loads the resource without checking if it exists or not
    *
@@ -129,6 +311,18 @@ private:
    */
   const Resource<T> force_load(const std::string& name);
 
+  /**
+   * @brief Loads the resource without checking if it exists or not, with its
+   *        contents already hashed (e.g. while prefetching)
+   *
+   * @param name the file name of the resource to load
+   * @param hash the hash of the resource's contents (0 if it's unknown)
+   *
+   * @return a handle to the resource requested or a null handle if the load
+   *         fails
+   */
+  const Resource<T> force_load(const std::string& name, uint64_t hash);
+
   /**
    * @brief Saves the loading state for a particular resource
    *
@@ -139,12 +333,36 @@ private:
   template <typename... Args>
   void save_state(const std::string& name, const std::string& filename, Args... options);
 
+  /**
+   * @brief Saves the loading state for a particular resource
+   *
+   * @param name the name of the resource
+   * @param filename the filename used to load the resource
+   * @param options the options used to load the resource
+   */
+  void save_state(const std::string& name, const std::string& filename,
+                  const LoaderOptions<L>& options);
+
   /// Resource loader for the manager
   std::shared_ptr<L> loader_;
   /// Hash of resources by their names
-  std::unordered_map<std::string, std::unique_ptr<T>> resources_;
+  std::unordered_map<std::string, Entry> resources_;
   /// Hash of states used to load resources initially
   std::unordered_map<std::string, LoadState> load_states_;
+  /// Loaded resources by the hash of their contents, to share identical ones
+  std::unordered_map<uint64_t, std::weak_ptr<T>> by_hash_;
+  /// The budget for the resources in bytes
+  size_t budget_ = std::numeric_limits<size_t>::max();
+  /// The memory used by the resources currently loaded
+  size_t resident_bytes_ = 0;
+  /// Ticks every time a resource is used, to find the least recently used
+  mutable uint64_t use_clock_ = 0;
+  /// The current frame
+  uint64_t frame_ = 0;
+  /// The number of frames between each inventory log (0 for none)
+  uint64_t report_interval_ = 0;
+  /// The name of the inventory when it's logged
+  std::string report_title_;
 };
 
 template <typename T, typename L>
@@ -162,15 +380,143 @@ const Resource<T> ResourceManager<T, L>::load(const std::string& filename, const
 
   if (search != resources_.end())
   {
-    return Resource<T>(name);
+    return handle(name, search->second);
   }
   else
   {
     save_state(name, filename, options...);
-    return force_load(name);
+
+    const auto resource = force_load(name);
+    trim();
+
+    return resource;
   }
 }
 
+template <typename T, typename L>
+size_t ResourceManager<T, L>::prefetch(const ResourceManifest<L>& manifest, JobSystem& jobs,
+                                       const std::function<void(size_t, size_t)>& progress)
+{
+  using Entry = typename ResourceManifest<L>::Entry;
+  std::vector<std::pair<uint64_t, const Entry*>> pending;
+
+  for (const auto& entry : manifest.entries())
+  {
+    if (resources_.find(entry.name) == resources_.end())
+    {
+      pending.emplace_back(loader_->prefetch_order(entry.filename), &entry);
+    }
+  }
+
+  std::stable_sort(pending.begin(), pending.end(),
+                   [](const auto& a, const auto& b) { return a.first < b.first; });
+
+  const auto count = pending.size();
+  // Prefetching only runs this far ahead of the loading, so a big manifest
+  // isn't all held prefetched (e.g. decoded) at once
+  const auto window = std::max<size_t>(jobs.worker_count(), 1) * 2;
+
+  // Each resource's job has a counter of its own to wait for, and somewhere
+  // to leave what it threw (only read once the job has finished)
+  const auto done = std::make_unique<JobCounter[]>(count);
+  std::vector<std::exception_ptr> errors(count);
+  // The contents are hashed by the jobs too, so loading doesn't read each
+  // file again on this thread
+  std::vector<uint64_t> hashes(count);
+
+  // Waits for the jobs scheduled so far however this returns, including by
+  // throwing, as they refer to the locals above
+  struct Scheduled
+  {
+    JobSystem& jobs;
+    JobCounter* done;
+    size_t count;
+
+    ~Scheduled()
+    {
+      for (size_t i = 0; i < count; i++)
+      {
+        jobs.wait(done[i]);
+      }
+    }
+  } scheduled{jobs, done.get(), 0};
+
+  const auto schedule = [&](const size_t end) {
+    for (; scheduled.count < std::min(end, count); scheduled.count++)
+    {
+      const auto index = scheduled.count;
+
+      jobs.run([this, &pending, &errors, &hashes, index]() {
+        const auto entry = pending[index].second;
+
+        try
+        {
+          loader_->prefetch(entry->filename, entry->options);
+          hashes[index] = loader_->content_hash(entry->filename, entry->options);
+        }
+        catch (...)
+        {
+          errors[index] = std::current_exception();
+        }
+      }, &done[index]);
+    }
+  };
+
+  size_t loaded = 0;
+  size_t consumed = 0;
+
+  try
+  {
+    schedule(window);
+
+    for (; consumed < count; consumed++)
+    {
+      jobs.wait(done[consumed]);
+
+      if (errors[consumed])
+      {
+        std::rethrow_exception(errors[consumed]);
+      }
+
+      const auto entry = pending[consumed].second;
+
+      save_state(entry->name, entry->filename, entry->options);
+
+      if (!force_load(entry->name, hashes[consumed]).is_null())
+      {
+        loaded++;
+      }
+
+      if (progress)
+      {
+        progress(consumed + 1, count);
+      }
+
+      schedule(consumed + 1 + window);
+    }
+  }
+  catch (...)
+  {
+    // Throw away whatever was prefetched but won't be loaded now
+    for (auto i = consumed; i < scheduled.count; i++)
+    {
+      jobs.wait(done[i]);
+
+      if (!errors[i])
+      {
+        const auto entry = pending[i].second;
+        loader_->discard_prefetched(entry->filename, entry->options);
+      }
+    }
+
+    throw;
+  }
+
+  trim();
+
+  return loaded;
+}
+
 template <typename T, typename L>
 const Resource<T> ResourceManager<T, L>::get(const std::string& name)
 {
@@ -178,7 +524,15 @@ const Resource<T> ResourceManager<T, L>::get(const std::string& name)
 
   if (search != resources_.end())
   {
-    return Resource<T>(name);
+    return handle(name, search->second);
+  }
+  else if (load_states_.find(name) != load_states_.end())
+  {
+    // It was unloaded to stay within the budget
+    const auto resource = force_load(name);
+    trim();
+
+    return resource;
   }
   else
   {
@@ -204,7 +558,9 @@ const T* ResourceManager<T, L>::get(const Resource<T>& resource) const
 
   if (search != resources_.end())
   {
-    return search->second.get();
+    search->second.last_used = ++use_clock_;
+    search->second.last_used_frame = frame_;
+    return search->second.resource.get();
   }
   else
   {
@@ -221,6 +577,8 @@ void ResourceManager<T, L>::reload()
   {
     force_load(resource.first);
   }
+
+  trim();
 }
 
 template <typename T, typename L>
@@ -228,6 +586,134 @@ void ResourceManager<T, L>::reload(const std::string& name)
 {
   BE_LOG("Reloading resource '" + name + "'...");
   force_load(name);
+  trim();
+}
+
+template <typename T, typename L>
+size_t ResourceManager<T, L>::reload_files(const std::vector<std::string>& filenames)
+{
+  if (filenames.empty())
+  {
+    return 0;
+  }
+
+  const std::unordered_set<std::string> changed(filenames.begin(), filenames.end());
+  size_t count = 0;
+
+  for (const auto& resource : resources_)
+  {
+    if (changed.count(load_states_.at(resource.first).filename) > 0)
+    {
+      BE_LOG("Reloading resource '" + resource.first + "'...");
+      force_load(resource.first);
+      count++;
+    }
+  }
+
+  trim();
+
+  return count;
+}
+
+template <typename T, typename L>
+void ResourceManager<T, L>::set_budget(const size_t bytes)
+{
+  budget_ = bytes;
+  trim();
+}
+
+template <typename T, typename L>
+void ResourceManager<T, L>::trim()
+{
+  if (resident_bytes_ <= budget_)
+  {
+    return;
+  }
+
+  // Only resources without any handles alive can be unloaded
+  std::vector<typename decltype(resources_)::iterator> unused;
+
+  for (auto resource = resources_.begin(); resource != resources_.end(); ++resource)
+  {
+    if (resource->second.reference.expired())
+    {
+      unused.push_back(resource);
+    }
+  }
+
+  std::sort(unused.begin(), unused.end(), [](const auto& a, const auto& b) {
+    return a->second.last_used < b->second.last_used;
+  });
+
+  for (const auto& resource : unused)
+  {
+    if (resident_bytes_ <= budget_)
+    {
+      break;
+    }
+
+    BE_LOG_DEBUG("Unloading resource '" + resource->first + "' to stay within budget");
+    release(resource->second);
+    resources_.erase(resource);
+  }
+
+  if (resident_bytes_ > budget_)
+  {
+    BE_LOG_WARN("Resources are over budget, but all of them are in use");
+  }
+}
+
+template <typename T, typename L>
+std::vector<ResourceInfo> ResourceManager<T, L>::inventory() const
+{
+  std::vector<ResourceInfo> inventory;
+  std::unordered_set<const T*> counted;
+  inventory.reserve(resources_.size());
+
+  for (const auto& resource : resources_)
+  {
+    const auto& entry = resource.second;
+
+    // Ask again rather than using the size when loaded, as streaming textures
+    // move their levels from CPU to GPU memory over time. Shared resources
+    // only show their memory under one of their names.
+    const auto memory = counted.insert(entry.resource.get()).second
+                          ? resource_memory(*entry.resource)
+                          : ResourceMemory();
+
+    inventory.push_back({resource.first, load_states_.at(resource.first).filename, memory,
+                         entry.load_time, entry.last_used_frame, entry.reference.use_count()});
+  }
+
+  std::sort(inventory.begin(), inventory.end(), [](const auto& a, const auto& b) {
+    return a.memory.total() > b.memory.total();
+  });
+
+  return inventory;
+}
+
+template <typename T, typename L>
+void ResourceManager<T, L>::log_inventory(const std::string& title) const
+{
+  BE_LOG(format_inventory(title, inventory()));
+}
+
+template <typename T, typename L>
+void ResourceManager<T, L>::next_frame()
+{
+  frame_++;
+
+  if (report_interval_ > 0 && frame_ % report_interval_ == 0)
+  {
+    log_inventory(report_title_);
+  }
+}
+
+template <typename T, typename L>
+void ResourceManager<T, L>::set_report_interval(const uint64_t frames, const std::string& title)
+{
+  report_interval_ = frames;
+  report_title_ = title;
 }
 
 //
@@ -237,6 +723,19 @@ void ResourceManager<T, L>::reload(const std::string& name)
 //
 template <typename T, typename L>
 const Resource<T> ResourceManager<T, L>::force_load(const std::string& name)
+{
+  const auto search = load_states_.find(name);
+
+  if (name.empty() || search == load_states_.end())
+  {
+    return force_load(name, 0);
+  }
+
+  return force_load(name, loader_->content_hash(search->second.filename, search->second.options));
+}
+
+template <typename T, typename L>
+const Resource<T> ResourceManager<T, L>::force_load(const std::string& name, const uint64_t hash)
 {
   if (!name.empty())
   {
@@ -244,12 +743,61 @@ const Resource<T> ResourceManager<T, L>::force_load(const std::string& name)
 
     if (search != load_states_.end())
     {
-      auto resource = loader_->load(search->second.filename, search->second.options);
+      Timer timer;
+      const auto& state = search->second;
+      const auto current = resources_.find(name);
+      std::shared_ptr<T> resource;
+
+      if (hash != 0)
+      {
+        const auto identical = by_hash_.find(hash);
+
+        if (identical != by_hash_.end())
+        {
+          resource = identical->second.lock();
+        }
+
+        // Reloading should load a new copy, rather than sharing the old one
+        if (current != resources_.end() && resource == current->second.resource)
+        {
+          resource.reset();
+        }
+      }
 
       if (resource != nullptr)
       {
-        resources_[name] = std::move(resource);
-        return Resource<T>(name);
+        BE_LOG_DEBUG("Sharing resource '" + name + "' with an identical one");
+
+        // It may have been prefetched before it was known to be identical
+        loader_->discard_prefetched(state.filename, state.options);
+      }
+      else
+      {
+        resource = loader_->load(state.filename, state.options);
+
+        if (resource != nullptr && hash != 0)
+        {
+          by_hash_[hash] = resource;
+        }
+      }
+
+      if (resource != nullptr)
+      {
+        // Reloading keeps the handles (and when it was last used) as they were
+        auto& entry = resources_[name];
+
+        release(entry);
+        entry.size = resource_memory(*resource).total();
+        entry.load_time = timer.peek();
+        entry.hash = hash;
+        entry.resource = std::move(resource);
+
+        if (entry.resource.use_count() == 1)
+        {
+          resident_bytes_ += entry.size;
+        }
+
+        return handle(name, entry);
       }
     }
     else
@@ -262,12 +810,53 @@ const Resource<T> ResourceManager<T, L>::force_load(const std::string& name)
   return Resource<T>();
 }
 
+template <typename T, typename L>
+const Resource<T> ResourceManager<T, L>::handle(const std::string& name, Entry& entry)
+{
+  auto reference = entry.reference.lock();
+
+  if (!reference)
+  {
+    reference = std::make_shared<const resource_id_t>(name);
+    entry.reference = reference;
+  }
+
+  entry.last_used = ++use_clock_;
+  entry.last_used_frame = frame_;
+
+  return Resource<T>(name, std::move(reference));
+}
+
+template <typename T, typename L>
+void ResourceManager<T, L>::release(const Entry& entry)
+{
+  if (entry.resource != nullptr && entry.resource.use_count() == 1)
+  {
+    resident_bytes_ -= entry.size;
+
+    // Nothing else can share it once it's gone
+    const auto identical = by_hash_.find(entry.hash);
+
+    if (identical != by_hash_.end() && identical->second.lock() == entry.resource)
+    {
+      by_hash_.erase(identical);
+    }
+  }
+}
+
 template <typename T, typename L>
 template <typename... Args>
 void ResourceManager<T, L>::save_state(const std::string& name, const std::string& filename,
                                        Args... options)
 {
-  load_states_[name] = {filename, LoaderOptions<L>{options...}};
+  save_state(name, filename, LoaderOptions<L>{options...});
+}
+
+template <typename T, typename L>
+void ResourceManager<T, L>::save_state(const std::string& name, const std::string& filename,
+                                       const LoaderOptions<L>& options)
+{
+  load_states_[name] = {filename, options};
 }
 } // end of namespace BarelyEngine
 
@@ -0,0 +1,172 @@
+//
+// resource_manifest.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BE_RESOURCE_MANIFEST_H
+#define BE_RESOURCE_MANIFEST_H
+
+#include <fstream>
+#include <istream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "resource_loader.h"
+#include "exception.h"
+
+namespace BarelyEngine {
+/**
+ * @brief Reads a single option for a loader from a manifest
+ *
+ * Overload this (in the loader's namespace) for each loader whose options can
+ * be set in manifests. Without an overload, loaders don't accept any options.
+ *
+ * @param options the options to set
+ * @param key the name of the option
+ * @param value the value of the option
+ *
+ * @return false if the option (or its value) isn't recognised
+ */
+template <typename L>
+bool read_option(LoaderOptions<L>&, const std::string&, const std::string&) { return false; }
+
+/**
+ * @class ResourceManifest
+ * @brief A list of resources that are needed together (e.g. by a scene), so
+ *        they can be loaded up front with `ResourceManager::prefetch()`
+ *
+ * Manifest files have one resource on each line: its filename, then
+ * optionally the name to store it under, then any loader options as
+ * `key=value` pairs. Blank lines and lines starting with `#` are skipped:
+ *
+ *     # Title screen
+ *     logo.png
+ *     background.png title_background mipmaps=true
+ */
+template <typename L>
+class ResourceManifest
+{
+public:
+  /**
+   * @struct Entry
+   * @brief A resource in the manifest
+   */
+  struct Entry
+  {
+    /// The filename of the resource
+    std::string filename;
+    /// The name to store the resource under
+    std::string name;
+    /// The options to load the resource with
+    LoaderOptions<L> options;
+  };
+
+  /**
+   * @brief Reads a manifest file from the file system
+   *
+   * Throws an Exception if the file can't be read or isn't valid.
+   *
+   * @param path the path of the manifest
+   *
+   * @return the manifest
+   */
+  static ResourceManifest<L> load(const std::string& path);
+
+  /**
+   * @brief Reads a manifest from a stream
+   *
+   * Throws an Exception if the manifest isn't valid.
+   *
+   * @param stream the stream to read from
+   *
+   * @return the manifest
+   */
+  static ResourceManifest<L> read(std::istream& stream);
+
+  /**
+   * @brief Adds a resource to the manifest
+   *
+   * @param filename the filename of the resource
+   * @param name the name to store the resource under
+   * @param options the options to load the resource with
+   */
+  void add(const std::string& filename, const std::string& name,
+           const LoaderOptions<L>& options = {})
+  {
+    entries_.push_back({filename, name, options});
+  }
+
+  /**
+   * @brief Gets the resources in the manifest, in the order they were added
+   */
+  const std::vector<Entry>& entries() const { return entries_; }
+
+  /**
+   * @brief Gets the number of resources in the manifest
+   */
+  size_t size() const { return entries_.size(); }
+
+private:
+  /// The resources in the manifest
+  std::vector<Entry> entries_;
+};
+
+template <typename L>
+ResourceManifest<L> ResourceManifest<L>::load(const std::string& path)
+{
+  std::ifstream stream(path);
+
+  if (!stream)
+  {
+    throw Exception("Couldn't read resource manifest '" + path + "'");
+  }
+
+  return read(stream);
+}
+
+template <typename L>
+ResourceManifest<L> ResourceManifest<L>::read(std::istream& stream)
+{
+  ResourceManifest<L> manifest;
+  std::string line;
+  size_t line_number = 0;
+
+  while (std::getline(stream, line))
+  {
+    line_number++;
+
+    std::istringstream words(line);
+    std::string filename;
+
+    if (!(words >> filename) || filename[0] == '#')
+    {
+      continue;
+    }
+
+    auto name = filename;
+    LoaderOptions<L> options = {};
+    std::string word;
+
+    while (words >> word)
+    {
+      const auto equals = word.find('=');
+
+      if (equals == std::string::npos)
+      {
+        name = word;
+      }
+      else if (!read_option(options, word.substr(0, equals), word.substr(equals + 1)))
+      {
+        throw Exception("Unknown option '" + word + "' on line " + std::to_string(line_number) +
+                        " of resource manifest");
+      }
+    }
+
+    manifest.add(filename, name, options);
+  }
+
+  return manifest;
+}
+} // end of namespace BarelyEngine
+
+#endif // defined(BE_RESOURCE_MANIFEST_H)
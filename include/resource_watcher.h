@@ -0,0 +1,134 @@
+//
+// resource_watcher.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BE_RESOURCE_WATCHER_H
+#define BE_RESOURCE_WATCHER_H
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include <sys/types.h>
+
+namespace BarelyEngine {
+/**
+ * @class ResourceWatcher
+ * @brief Watches a resource directory on a background thread and reports the
+ *        files which have changed
+ *
+ * Reloading every resource whenever one file is saved gets slow with a few
+ * thousand textures. Instead, the watcher hands back just the changed files,
+ * relative to the watched directory, which is how loaders are given filenames,
+ * so they can be passed straight to `ResourceManager::reload_files()`:
+ *
+ *     textures.reload_files(texture_watcher.changed());
+ *
+ * Changes are debounced: a file is only reported once it has stopped changing
+ * for the debounce interval, so an editor writing a file in several chunks (or
+ * saving it several times in a row) causes a single reload.
+ *
+ * On Linux, changes are detected with inotify. Elsewhere the directory is
+ * polled, comparing modification times.
+ */
+class ResourceWatcher
+{
+public:
+  using clock = std::chrono::steady_clock;
+  /// A file's modification time and size, used to spot changes when polling
+  using Stamp = std::pair<time_t, off_t>;
+
+  /**
+   * @brief Construct a new ResourceWatcher and start watching
+   *
+   * Throws an Exception if the directory can't be watched.
+   *
+   * @param directory the directory to watch (including its subdirectories)
+   * @param debounce how long a file must be left alone before it's reported
+   */
+  ResourceWatcher(const std::string& directory,
+                  clock::duration debounce = std::chrono::milliseconds(100));
+
+  /**
+   * @brief Stops watching
+   */
+  ~ResourceWatcher();
+
+  ResourceWatcher(const ResourceWatcher& other) = delete;
+  ResourceWatcher& operator=(const ResourceWatcher& other) = delete;
+
+  /**
+   * @brief Takes the files which have changed since the last call
+   *
+   * @return the changed files, relative to the watched directory (each one
+   *         appears at most once)
+   */
+  std::vector<std::string> changed();
+
+private:
+  /**
+   * @brief The loop run by the watching thread
+   */
+  void run();
+
+  /**
+   * @brief Records that a file has changed, restarting its debounce interval
+   *
+   * @param filename the file, relative to the watched directory
+   */
+  void touch(const std::string& filename);
+
+  /**
+   * @brief Moves the files which have settled from `pending_` to `changed_`
+   */
+  void settle();
+
+  /**
+   * @brief Lists a directory and its subdirectories
+   *
+   * @param relative the directory to list, relative to the watched directory
+   *        (empty for the watched directory itself)
+   * @param files set to the files found, with their stamps
+   * @param directories set to the subdirectories found
+   */
+  void scan(const std::string& relative, std::unordered_map<std::string, Stamp>& files,
+            std::vector<std::string>& directories) const;
+
+  /**
+   * @brief Starts watching a directory (and its subdirectories) with inotify
+   *
+   * @param relative the directory, relative to the watched directory
+   * @param existing_changed whether to treat files already in the directory as
+   *        changed (for directories which have just been created or moved in)
+   */
+  void watch(const std::string& relative, bool existing_changed);
+
+  /// The directory being watched, ending with a '/'
+  std::string directory_;
+  /// How long a file must be left alone before it's reported
+  clock::duration debounce_;
+  /// The inotify instance (-1 when polling)
+  int inotify_ = -1;
+  /// The directory each inotify watch is for (relative to `directory_`)
+  std::unordered_map<int, std::string> watches_;
+  /// The files seen by the last scan (only when polling)
+  std::unordered_map<std::string, Stamp> files_;
+  /// Files which have changed, but haven't settled yet (watching thread only)
+  std::unordered_map<std::string, clock::time_point> pending_;
+  /// Files which have settled, waiting to be taken by `changed()`
+  std::vector<std::string> changed_;
+  /// Guards `changed_`
+  std::mutex changed_mutex_;
+  /// Whether the watching thread should keep running
+  std::atomic<bool> running_{true};
+  /// The watching thread
+  std::thread thread_;
+};
+} // end of namespace BarelyEngine
+
+#endif // defined(BE_RESOURCE_WATCHER_H)
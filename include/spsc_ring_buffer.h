@@ -0,0 +1,298 @@
+//
+// spsc_ring_buffer.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BE_SPSC_RING_BUFFER_H
+#define BE_SPSC_RING_BUFFER_H
+
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdlib>
+#include "cache_aligned.h"
+
+namespace BarelyEngine {
+/**
+ * @class SpscRingBuffer
+ * @brief A bounded, lock-free ring buffer for passing values from exactly one
+ *        producer thread to exactly one consumer thread.
+ *
+ * Unlike RingBuffer, this never overwrites the oldest value when full; pushes
+ * fail instead, so nothing handed across threads is silently lost. No memory
+ * is allocated after construction.
+ *
+ * The head (read) and tail (write) indices grow forever and are only wrapped
+ * when indexing into the array, which is why the size must be a power of two.
+ * Each index lives on its own cache line, next to a cached copy of the other
+ * thread's index, so the producer and consumer only touch each other's cache
+ * line when their cached copy says the buffer is full (or empty).
+ *
+ * Only the producer may call `push_back()` and only the consumer may call
+ * `front()` and `pop_front()`.
+ */
+template <typename T, int S>
+class SpscRingBuffer
+{
+  static_assert(S > 0 && (S & (S - 1)) == 0, "SpscRingBuffer size must be a power of two");
+
+public:
+  /**
+   * @brief Construct a new SpscRingBuffer
+   */
+  SpscRingBuffer()
+    : tail_(0)
+    , head_(0) {};
+
+  SpscRingBuffer(const SpscRingBuffer& other) = delete;
+  SpscRingBuffer& operator=(const SpscRingBuffer& other) = delete;
+
+  /**
+   * @brief Allocates with cache line alignment (see `cache_aligned_new()`)
+   */
+  static void* operator new(size_t size) { return cache_aligned_new(size); }
+  static void operator delete(void* pointer) { std::free(pointer); }
+
+  /**
+   * @brief Returns the number of elements the ring buffer can contain
+   *
+   * @return the number of elements the ring buffer can contain
+   */
+  constexpr size_t capacity() const { return S; }
+
+  /**
+   * @brief Returns the number of elements currently in the ring buffer
+   *
+   * If called from a thread other than the producer or consumer, this is only a
+   * snapshot and may be out of date as soon as it returns.
+   *
+   * @return the number of elements currently in the ring buffer
+   */
+  size_t size() const;
+
+  /**
+   * @brief Checks whether the ring buffer is empty
+   *
+   * @return a bool indicating if the ring buffer is empty
+   */
+  bool empty() const { return size() == 0; }
+
+  /**
+   * @brief Appends the given element value to the end of the ring buffer
+   *
+   * @param the element value to append to the ring buffer (copied)
+   *
+   * @return false if the ring buffer was full and the value wasn't added
+   */
+  bool push_back(const T& value);
+
+  /**
+   * @brief Appends the given element value to the end of the ring buffer
+   *
+   * @param the element value to append to the ring buffer (moved)
+   *
+   * @return false if the ring buffer was full and the value wasn't added
+   */
+  bool push_back(T&& value);
+
+  /**
+   * @brief Appends as many of the given values as will fit, publishing them to
+   *        the consumer all at once
+   *
+   * @param values pointer to the first value to append (copied)
+   * @param count the number of values to append
+   *
+   * @return the number of values actually appended
+   */
+  size_t push_back(const T* values, size_t count);
+
+  /**
+   * @brief Returns the element at the front of the ring buffer
+   *
+   * @return the element at the front of the ring buffer
+   */
+  T& front();
+
+  /**
+   * @brief Removes the element at the front of the ring buffer
+   *
+   * @param value the value to move the front element into
+   *
+   * @return false if the ring buffer was empty
+   */
+  bool pop_front(T& value);
+
+  /**
+   * @brief Removes up to `count` elements from the front of the ring buffer,
+   *        releasing them back to the producer all at once
+   *
+   * @param values pointer to an array of at least `count` values to move the
+   *               elements into
+   * @param count the maximum number of elements to remove
+   *
+   * @return the number of elements actually removed
+   */
+  size_t pop_front(T* values, size_t count);
+
+private:
+  /// Assumed size of a cache line, used to keep the indices apart
+  static constexpr size_t kCacheLineSize = 64;
+  /// Mask used to wrap an index into the underlying array
+  static constexpr size_t kMask = S - 1;
+
+  /**
+   * @brief Returns the number of free slots, as seen by the producer
+   *
+   * @param tail the producer's current tail index
+   * @param wanted the number of slots the producer would like to fill
+   */
+  size_t free_slots(size_t tail, size_t wanted);
+
+  /**
+   * @brief Returns the number of filled slots, as seen by the consumer
+   *
+   * @param head the consumer's current head index
+   * @param wanted the number of slots the consumer would like to empty
+   */
+  size_t filled_slots(size_t head, size_t wanted);
+
+  /// Index of the next element to write (written by the producer only)
+  alignas(kCacheLineSize) std::atomic<size_t> tail_;
+  /// The producer's last known value of `head_`
+  size_t cached_head_ = 0;
+  /// Index of the next element to read (written by the consumer only)
+  alignas(kCacheLineSize) std::atomic<size_t> head_;
+  /// The consumer's last known value of `tail_`
+  size_t cached_tail_ = 0;
+  /// The underlying array used by the ring buffer
+  alignas(kCacheLineSize) std::array<T, S> buffer_;
+};
+
+template <typename T, int S>
+size_t SpscRingBuffer<T, S>::size() const
+{
+  // Load the head first, as the tail can only move further ahead of it
+  const auto head = head_.load(std::memory_order_acquire);
+  const auto tail = tail_.load(std::memory_order_acquire);
+
+  return tail - head;
+}
+
+template <typename T, int S>
+bool SpscRingBuffer<T, S>::push_back(const T& value)
+{
+  const auto tail = tail_.load(std::memory_order_relaxed);
+
+  if (free_slots(tail, 1) == 0) return false;
+
+  buffer_[tail & kMask] = value;
+  tail_.store(tail + 1, std::memory_order_release);
+
+  return true;
+}
+
+template <typename T, int S>
+bool SpscRingBuffer<T, S>::push_back(T&& value)
+{
+  const auto tail = tail_.load(std::memory_order_relaxed);
+
+  if (free_slots(tail, 1) == 0) return false;
+
+  buffer_[tail & kMask] = std::move(value);
+  tail_.store(tail + 1, std::memory_order_release);
+
+  return true;
+}
+
+template <typename T, int S>
+size_t SpscRingBuffer<T, S>::push_back(const T* values, size_t count)
+{
+  const auto tail = tail_.load(std::memory_order_relaxed);
+  const auto pushed = std::min(count, free_slots(tail, count));
+
+  // Copy in (at most) two runs, either side of the end of the array
+  const auto start = tail & kMask;
+  const auto first_run = std::min(pushed, S - start);
+
+  std::copy(values, values + first_run, buffer_.begin() + start);
+  std::copy(values + first_run, values + pushed, buffer_.begin());
+
+  tail_.store(tail + pushed, std::memory_order_release);
+
+  return pushed;
+}
+
+template <typename T, int S>
+T& SpscRingBuffer<T, S>::front()
+{
+  const auto head = head_.load(std::memory_order_relaxed);
+
+  assert(filled_slots(head, 1) > 0);
+  return buffer_[head & kMask];
+}
+
+template <typename T, int S>
+bool SpscRingBuffer<T, S>::pop_front(T& value)
+{
+  const auto head = head_.load(std::memory_order_relaxed);
+
+  if (filled_slots(head, 1) == 0) return false;
+
+  value = std::move(buffer_[head & kMask]);
+  head_.store(head + 1, std::memory_order_release);
+
+  return true;
+}
+
+template <typename T, int S>
+size_t SpscRingBuffer<T, S>::pop_front(T* values, size_t count)
+{
+  const auto head = head_.load(std::memory_order_relaxed);
+  const auto popped = std::min(count, filled_slots(head, count));
+
+  // Move out in (at most) two runs, either side of the end of the array
+  const auto start = head & kMask;
+  const auto first_run = std::min(popped, S - start);
+
+  std::move(buffer_.begin() + start, buffer_.begin() + start + first_run, values);
+  std::move(buffer_.begin(), buffer_.begin() + (popped - first_run), values + first_run);
+
+  head_.store(head + popped, std::memory_order_release);
+
+  return popped;
+}
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+template <typename T, int S>
+size_t SpscRingBuffer<T, S>::free_slots(const size_t tail, const size_t wanted)
+{
+  // Only look at the consumer's index (and its cache line) when our cached
+  // copy says there isn't enough room
+  if (S - (tail - cached_head_) < wanted)
+  {
+    cached_head_ = head_.load(std::memory_order_acquire);
+  }
+
+  return S - (tail - cached_head_);
+}
+
+template <typename T, int S>
+size_t SpscRingBuffer<T, S>::filled_slots(const size_t head, const size_t wanted)
+{
+  if (cached_tail_ - head < wanted)
+  {
+    cached_tail_ = tail_.load(std::memory_order_acquire);
+  }
+
+  return cached_tail_ - head;
+}
+} // end of namespace BarelyEngine
+
+#endif // defined(BE_SPSC_RING_BUFFER_H)
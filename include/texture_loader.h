@@ -7,21 +7,117 @@
 #define BE_TEXTURE_LOADER_H
 
 #include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
 #include <OpenGL/gltypes.h>
 #include "resource_loader.h"
+#include "mip_chain.h"
+#include "texture_pack.h"
+
+struct SDL_Surface;
 
 namespace BarelyEngine {
+class CompressedImage;
+class PixelData;
 class Texture;
 class TextureLoader;
 
+/**
+ * @struct DecodedTexture
+ * @brief Pixels of a texture that have been loaded and prepared in CPU memory,
+ *        but not yet uploaded to the GPU
+ */
+struct DecodedTexture
+{
+  /**
+   * @brief Construct a new DecodedTexture, taking ownership of the surface
+   *
+   * @param path the path the texture was loaded from
+   * @param surface the loaded surface (or null if the load failed)
+   */
+  DecodedTexture(const std::string& path, SDL_Surface* surface);
+
+  /**
+   * @brief Construct a new DecodedTexture from a block-compressed image
+   *
+   * @param path the path the texture was loaded from
+   * @param compressed the loaded image (or null if the load failed)
+   */
+  DecodedTexture(const std::string& path, std::unique_ptr<CompressedImage> compressed);
+
+  /**
+   * @brief Construct a new DecodedTexture from an entry in a texture pack
+   *
+   * @param path the path the texture would have been loaded from
+   * @param pack the pack containing the texture
+   * @param packed the texture's entry in the pack
+   */
+  DecodedTexture(const std::string& path, std::shared_ptr<const TexturePack> pack,
+                 const TexturePack::Entry* packed);
+  ~DecodedTexture();
+
+  /**
+   * @brief Whether the load succeeded
+   */
+  bool valid() const { return surface != nullptr || compressed != nullptr || packed != nullptr; }
+
+  DecodedTexture(const DecodedTexture& other) = delete;
+  DecodedTexture& operator=(const DecodedTexture& other) = delete;
+
+  /// The path the texture was loaded from
+  std::string path;
+  /// The loaded surface (null if the load failed)
+  SDL_Surface* surface = nullptr;
+  /// The surface's pixels, prepared for upload
+  std::unique_ptr<PixelData> pixel_data;
+  /// The block-compressed image, for DDS and KTX2 files (instead of a surface)
+  std::unique_ptr<CompressedImage> compressed;
+  /// Generated mipmap levels (starting at level 1, or level 0 if streamed)
+  std::vector<MipLevel> mip_levels;
+  /// How many levels to upload straight away (0 if not streamed)
+  size_t resident_mip_levels = 0;
+  /// The pack containing the texture (kept open until it is uploaded)
+  std::shared_ptr<const TexturePack> pack;
+  /// The texture's entry in the pack (instead of a surface)
+  const TexturePack::Entry* packed = nullptr;
+};
+
 template <>
 struct LoaderOptions<TextureLoader>
 {
+  /// Whether to multiply the color channels by alpha before uploading
+  bool premultiply_alpha = false;
+  /// Whether to generate mipmaps (compressed files bring their own)
+  bool mipmaps = false;
+  /// The filter used to generate mipmaps
+  MipFilter mip_filter = MipFilter::BOX;
+  /// If non-zero, only this many of the smallest mipmaps are uploaded at first
+  /// and the rest are streamed in with `Texture::refine()`
+  size_t resident_mip_levels = 0;
 };
 
+/**
+ * @brief Reads a texture option from a resource manifest
+ *
+ * The options are `premultiply_alpha`, `mipmaps` (`true` or `false`),
+ * `mip_filter` (`box` or `kaiser`) and `resident_mip_levels` (a number).
+ */
+bool read_option(LoaderOptions<TextureLoader>& options, const std::string& key,
+                 const std::string& value);
+
 /**
  * @class TextureLoader
  * @brief Handles loading textures from the file system
+ *
+ * Textures are looked for in any texture packs that have been added first,
+ * and uploaded straight from the pack. Otherwise, files ending in `.dds` or
+ * `.ktx2` are loaded as block-compressed textures and uploaded as they are;
+ * everything else is decoded with SDL_image.
+ *
+ * When prefetched, textures are decoded (or their pack pages read in) ahead
+ * of time and held until they're loaded, which then only has to upload them.
  */
 class TextureLoader : public ResourceLoader<Texture, TextureLoader>
 {
@@ -31,17 +127,147 @@ public:
    */
   TextureLoader() {}
 
+  /**
+   * @brief Adds a texture pack to look for textures in, before the file system
+   *
+   * The options for textures loaded from packs are ignored, since they are
+   * stored ready to upload. Packs must be added before any textures are loaded
+   * on another thread (e.g. by a TextureStream).
+   *
+   * @param pack the pack to add
+   */
+  void add_pack(std::shared_ptr<const TexturePack> pack);
+
   /**
    * @brief Loads a texture from the file system. Assumes the files are located
    *        in `resources/textures/`
    *
    * @param filename the filename of the resource to load
-   * @param options the options used to load the texture (unused)
+   * @param options the options used to load the texture
    *
    * @return a unique_ptr to the resource
    */
   std::unique_ptr<Texture> load(const std::string& name,
                                 const LoaderOptions<TextureLoader>& options) override;
+
+  /**
+   * @brief Decodes a texture ahead of time, holding it until it's loaded
+   *
+   * @param filename the filename of the resource to load
+   * @param options the options used to load the texture
+   */
+  void prefetch(const std::string& filename,
+                const LoaderOptions<TextureLoader>& options) override;
+
+  /**
+   * @brief Frees a texture decoded by `prefetch()` which isn't going to be
+   *        loaded
+   *
+   * @param filename the filename of the resource
+   * @param options the options the texture was decoded with
+   */
+  void discard_prefetched(const std::string& filename,
+                          const LoaderOptions<TextureLoader>& options) override;
+
+  /**
+   * @brief Orders textures in packs first, by pack and then by where they are
+   *        in the pack (so the packs are read from start to end), then the
+   *        remaining files largest first (so the slowest decodes start first)
+   *
+   * @param filename the filename of the resource
+   *
+   * @return the position of the resource in the order
+   */
+  uint64_t prefetch_order(const std::string& filename) override;
+
+  /**
+   * @brief Hashes the texture's file (or its data in a pack) and options
+   *
+   * Each file or pack entry is only read for this once (until a file
+   * changes), and it's safe to call while prefetching.
+   *
+   * @param filename the filename of the resource
+   * @param options the options used to load the texture
+   *
+   * @return the hash, or 0 if the texture can't be read
+   */
+  uint64_t content_hash(const std::string& filename,
+                        const LoaderOptions<TextureLoader>& options) override;
+
+  /**
+   * @brief Loads a texture from the file system and prepares its pixels (and
+   *        mipmaps) for upload, without touching OpenGL. This is safe to call
+   *        from a thread which doesn't own the OpenGL context.
+   *
+   * @param filename the filename of the resource to load
+   * @param options the options used to load the texture
+   *
+   * @return the decoded texture (which isn't valid if the load failed)
+   */
+  std::unique_ptr<DecodedTexture> decode(const std::string& filename,
+                                         const LoaderOptions<TextureLoader>& options = {});
+
+  /**
+   * @brief Uploads a decoded texture to the GPU. Must be called on the thread
+   *        which owns the OpenGL context.
+   *
+   * @param decoded the texture to upload (its mipmaps may be moved out)
+   *
+   * @return a unique_ptr to the resource or null if the decode had failed (or
+   *         the GPU doesn't support the compressed format)
+   */
+  std::unique_ptr<Texture> upload(DecodedTexture& decoded);
+
+private:
+  /**
+   * @brief Generates the mipmaps of a decoded texture
+   *
+   * @param decoded the decoded texture, which must have prepared pixels
+   * @param options the options used to load the texture
+   */
+  void generate_mipmaps(DecodedTexture& decoded, const LoaderOptions<TextureLoader>& options);
+
+  /**
+   * @brief Checks whether a file holds a block-compressed texture, from its
+   *        extension
+   */
+  static bool is_compressed(const std::string& filename);
+
+  /**
+   * @brief Uploads a texture from a pack
+   */
+  std::unique_ptr<Texture> upload_packed(const DecodedTexture& decoded);
+
+  /**
+   * @struct Prefetched
+   * @brief A texture decoded by `prefetch()`, waiting to be loaded
+   */
+  struct Prefetched
+  {
+    /// The options the texture was decoded with
+    LoaderOptions<TextureLoader> options;
+    /// The decoded texture
+    std::unique_ptr<DecodedTexture> decoded;
+  };
+
+  /**
+   * @brief Takes a prefetched texture, if one was decoded with the same options
+   *
+   * @return the decoded texture, or null if it wasn't prefetched
+   */
+  std::unique_ptr<DecodedTexture> take_prefetched(const std::string& filename,
+                                                  const LoaderOptions<TextureLoader>& options);
+
+  /// The packs to look for textures in, in the order they were added
+  std::vector<std::shared_ptr<const TexturePack>> packs_;
+  /// Textures decoded by `prefetch()`, by filename
+  std::unordered_multimap<std::string, Prefetched> prefetched_;
+  /// Guards `prefetched_`
+  std::mutex prefetched_mutex_;
+  /// The hashes of pack entries already read (packs don't change once added)
+  std::unordered_map<const TexturePack::Entry*, uint64_t> pack_hashes_;
+  /// Guards `pack_hashes_`
+  std::mutex pack_hashes_mutex_;
 };
 } // end of namespace BarelyEngine
 
@@ -0,0 +1,183 @@
+//
+// texture_pack.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BE_TEXTURE_PACK_H
+#define BE_TEXTURE_PACK_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <OpenGL/gltypes.h>
+#include "compressed_image.h"
+#include "mip_chain.h"
+
+namespace BarelyEngine {
+/**
+ * @class TexturePack
+ * @brief A single file holding many textures, ready to upload, which is mapped
+ *        into memory rather than read
+ *
+ * Opening thousands of small image files (and decoding each one) is slow,
+ * especially from network drives. A pack is opened once, and each texture in
+ * it is stored exactly as it will be uploaded: either 4-byte pixels or GPU
+ * compressed blocks, plus any mipmaps. Textures are uploaded straight from the
+ * mapped pages, so nothing is decoded or copied on the CPU.
+ *
+ * The file is laid out as:
+ * - a 16 byte header (magic, version and the number of entries)
+ * - a table of contents with a fixed-size record for each entry
+ * - the entry names, one after another
+ * - the data of each entry (all of its levels, largest first), aligned to
+ *   `kAlignment` bytes
+ *
+ * Packs are written by TexturePackWriter (see `tools/pack_textures.cpp`).
+ */
+class TexturePack
+{
+public:
+  /// The alignment of each entry's data within the file
+  static const size_t kAlignment = 64;
+
+  /**
+   * @struct Entry
+   * @brief A texture stored in the pack
+   */
+  struct Entry
+  {
+    /// Whether the data is GPU compressed blocks (rather than 4-byte pixels)
+    bool compressed;
+    /// The pixel format of uncompressed data (GL_RGBA or GL_BGRA)
+    GLenum format;
+    /// The block format of compressed data
+    CompressedFormat compressed_format;
+    /// Width of the largest level in pixels
+    int width;
+    /// Height of the largest level in pixels
+    int height;
+    /// Where each level lives, relative to the start of the file
+    std::vector<CompressedLevel> levels;
+  };
+
+  /**
+   * @brief Opens a pack and maps it into memory
+   *
+   * Throws an Exception if the file can't be mapped or isn't a valid pack.
+   *
+   * @param path the path of the pack
+   */
+  TexturePack(const std::string& path);
+  ~TexturePack();
+
+  TexturePack(const TexturePack& other) = delete;
+  TexturePack& operator=(const TexturePack& other) = delete;
+
+  /**
+   * @brief Finds a texture in the pack
+   *
+   * @param name the name the texture was packed with
+   *
+   * @return the entry for the texture, or null if it isn't in the pack
+   */
+  const Entry* find(const std::string& name) const;
+
+  /**
+   * @brief Asks the OS to start reading a texture's pages in, so that they're
+   *        hopefully resident by the time the texture is uploaded
+   *
+   * @param entry the entry to read in
+   */
+  void prefetch(const Entry& entry) const;
+
+  /**
+   * @brief Gets the start of the mapped file, which the levels' offsets are
+   *        relative to
+   */
+  const uint8_t* data() const { return data_; }
+
+  /**
+   * @brief Gets the number of textures in the pack
+   */
+  size_t size() const { return entries_.size(); }
+
+private:
+  /**
+   * @brief Reads and validates the table of contents
+   */
+  void read_contents();
+
+  /// The path of the pack (for error messages)
+  std::string path_;
+  /// The mapped file
+  const uint8_t* data_ = nullptr;
+  /// The size of the mapped file
+  size_t size_ = 0;
+  /// Every entry, indexed by name
+  std::unordered_map<std::string, Entry> entries_;
+};
+
+/**
+ * @class TexturePackWriter
+ * @brief Builds up a TexturePack file
+ */
+class TexturePackWriter
+{
+public:
+  /**
+   * @brief Adds uncompressed pixels to the pack
+   *
+   * @param name the name the texture is loaded with
+   * @param width the width of the texture
+   * @param height the height of the texture
+   * @param format the pixel format (GL_RGBA or GL_BGRA)
+   * @param pixels the tightly packed 4-byte pixels
+   * @param mip_levels any mipmaps (starting with level 1)
+   */
+  void add(const std::string& name, int width, int height, GLenum format, const uint8_t* pixels,
+           const std::vector<MipLevel>& mip_levels = {});
+
+  /**
+   * @brief Adds a compressed image to the pack
+   *
+   * @param name the name the texture is loaded with
+   * @param image the image (including any mipmaps)
+   */
+  void add(const std::string& name, const CompressedImage& image);
+
+  /**
+   * @brief Lays out the pack
+   *
+   * @return the contents of the pack file
+   */
+  std::vector<uint8_t> contents() const;
+
+  /**
+   * @brief Writes the pack to the file system
+   *
+   * Throws an Exception if the file can't be written.
+   *
+   * @param path the path of the file to write
+   */
+  void save(const std::string& path) const;
+
+private:
+  /**
+   * @struct PendingEntry
+   * @brief An entry waiting to be written
+   */
+  struct PendingEntry
+  {
+    std::string name;
+    TexturePack::Entry entry;
+    std::vector<uint8_t> data;
+  };
+
+  /// The entries added so far
+  std::vector<PendingEntry> entries_;
+};
+} // end of namespace BarelyEngine
+
+#endif // defined(BE_TEXTURE_PACK_H)
@@ -0,0 +1,111 @@
+//
+// texture_stream.h
+// Copyright (c) 2015 Adam Ransom
+//
+
+#ifndef BE_TEXTURE_STREAM_H
+#define BE_TEXTURE_STREAM_H
+
+#include <atomic>
+#include <memory>
+#include <string>
+#include <thread>
+#include "spsc_ring_buffer.h"
+
+namespace BarelyEngine {
+class Texture;
+class TextureLoader;
+struct DecodedTexture;
+
+/**
+ * @class TextureStream
+ * @brief Loads textures on a background thread, handing them back to the
+ *        thread which owns the OpenGL context for uploading
+ *
+ * Reading and decoding image files is slow, but only the thread owning the
+ * OpenGL context can upload textures. The stream splits the work in two: the
+ * loader thread decodes requested textures into CPU memory and the render
+ * thread uploads whatever has finished decoding, when it calls `receive()`.
+ *
+ * Requests and decoded textures are passed through a pair of single-producer,
+ * single-consumer queues, so neither thread ever blocks on the other. Only one
+ * thread should make requests and receive textures.
+ */
+class TextureStream
+{
+public:
+  using RequestQueue = SpscRingBuffer<std::string, 256>;
+  using DecodedQueue = SpscRingBuffer<std::unique_ptr<DecodedTexture>, 64>;
+
+  /**
+   * @brief Construct a new TextureStream and start its loader thread
+   *
+   * @param loader the loader used to decode and upload textures
+   */
+  TextureStream(std::shared_ptr<TextureLoader> loader);
+
+  /**
+   * @brief Stops the loader thread, discarding any textures not yet received
+   */
+  ~TextureStream();
+
+  TextureStream(const TextureStream& other) = delete;
+  TextureStream& operator=(const TextureStream& other) = delete;
+
+  /**
+   * @brief Allocates with cache line alignment, so the queues' indices stay
+   *        on separate cache lines (see `cache_aligned_new()`)
+   */
+  static void* operator new(size_t size) { return cache_aligned_new(size); }
+  static void operator delete(void* pointer) { std::free(pointer); }
+
+  /**
+   * @brief Request a texture to be loaded in the background
+   *
+   * @param filename the filename of the texture to load
+   *
+   * @return false if too many requests are pending and this one was not queued
+   */
+  bool request(const std::string& filename);
+
+  /**
+   * @brief Uploads the next texture which has finished decoding (if any)
+   *
+   * Must be called on the thread which owns the OpenGL context.
+   *
+   * @param path set to the path the received texture was loaded from
+   * @param texture set to the received texture (null if the load failed)
+   *
+   * @return false if no textures have finished decoding
+   */
+  bool receive(std::string& path, std::unique_ptr<Texture>& texture);
+
+  /**
+   * @brief Gets the number of requested textures not yet received
+   *
+   * @return size_t of the number of pending textures
+   */
+  size_t pending() const { return pending_; }
+
+private:
+  /**
+   * @brief The loop run by the loader thread
+   */
+  void run();
+
+  /// The loader used to decode and upload the textures
+  std::shared_ptr<TextureLoader> loader_;
+  /// Filenames waiting to be decoded (render thread -> loader thread)
+  RequestQueue requests_;
+  /// Textures waiting to be uploaded (loader thread -> render thread)
+  DecodedQueue decoded_;
+  /// The number of requested textures not yet received
+  size_t pending_ = 0;
+  /// Whether the loader thread should keep running
+  std::atomic<bool> running_{true};
+  /// The loader thread
+  std::thread thread_;
+};
+} // end of namespace BarelyEngine
+
+#endif // defined(BE_TEXTURE_STREAM_H)
@@ -0,0 +1,203 @@
+//
+// content_hash.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <cstring>
+#include <mutex>
+#include <unordered_map>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "content_hash.h"
+
+namespace BarelyEngine {
+namespace ContentHash {
+namespace {
+const uint64_t kPrime1 = 0x9E3779B185EBCA87ULL;
+const uint64_t kPrime2 = 0xC2B2AE3D27D4EB4FULL;
+const uint64_t kPrime3 = 0x165667B19E3779F9ULL;
+const uint64_t kPrime4 = 0x85EBCA77C2B2AE63ULL;
+const uint64_t kPrime5 = 0x27D4EB2F165667C5ULL;
+
+/**
+ * A file's hash, and what the file looked like when it was hashed
+ */
+struct FileHash
+{
+  ino_t inode;
+  off_t size;
+  time_t modified;
+  uint64_t hash;
+};
+
+/// Hashes of files already read, so an unchanged file is only read once
+std::unordered_map<std::string, FileHash> file_hashes;
+std::mutex file_hashes_mutex;
+
+inline uint64_t rotate_left(const uint64_t value, const int bits)
+{
+  return (value << bits) | (value >> (64 - bits));
+}
+
+// Unaligned (little-endian) reads, which compile down to single loads
+inline uint64_t read64(const uint8_t* data)
+{
+  uint64_t value;
+  std::memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+inline uint32_t read32(const uint8_t* data)
+{
+  uint32_t value;
+  std::memcpy(&value, data, sizeof(value));
+  return value;
+}
+
+inline uint64_t accumulate(uint64_t accumulator, const uint64_t input)
+{
+  accumulator += input * kPrime2;
+  accumulator = rotate_left(accumulator, 31);
+  return accumulator * kPrime1;
+}
+
+inline uint64_t merge_round(uint64_t accumulator, const uint64_t value)
+{
+  accumulator ^= accumulate(0, value);
+  return accumulator * kPrime1 + kPrime4;
+}
+} // end of anonymous namespace
+
+uint64_t hash(const void* data, const size_t size, const uint64_t seed)
+{
+  auto bytes = static_cast<const uint8_t*>(data);
+  const auto end = bytes + size;
+  uint64_t result;
+
+  if (size >= 32)
+  {
+    // Four independent lanes over 32-byte stripes, so the multiplies overlap
+    const auto limit = end - 32;
+    uint64_t v1 = seed + kPrime1 + kPrime2;
+    uint64_t v2 = seed + kPrime2;
+    uint64_t v3 = seed;
+    uint64_t v4 = seed - kPrime1;
+
+    do
+    {
+      v1 = accumulate(v1, read64(bytes));
+      v2 = accumulate(v2, read64(bytes + 8));
+      v3 = accumulate(v3, read64(bytes + 16));
+      v4 = accumulate(v4, read64(bytes + 24));
+      bytes += 32;
+    } while (bytes <= limit);
+
+    result = rotate_left(v1, 1) + rotate_left(v2, 7) + rotate_left(v3, 12) + rotate_left(v4, 18);
+    result = merge_round(result, v1);
+    result = merge_round(result, v2);
+    result = merge_round(result, v3);
+    result = merge_round(result, v4);
+  }
+  else
+  {
+    result = seed + kPrime5;
+  }
+
+  result += static_cast<uint64_t>(size);
+
+  for (; bytes + 8 <= end; bytes += 8)
+  {
+    result ^= accumulate(0, read64(bytes));
+    result = rotate_left(result, 27) * kPrime1 + kPrime4;
+  }
+
+  if (bytes + 4 <= end)
+  {
+    result ^= static_cast<uint64_t>(read32(bytes)) * kPrime1;
+    result = rotate_left(result, 23) * kPrime2 + kPrime3;
+    bytes += 4;
+  }
+
+  for (; bytes < end; bytes++)
+  {
+    result ^= *bytes * kPrime5;
+    result = rotate_left(result, 11) * kPrime1;
+  }
+
+  // Avalanche, so every input bit affects every output bit
+  result ^= result >> 33;
+  result *= kPrime2;
+  result ^= result >> 29;
+  result *= kPrime3;
+  result ^= result >> 32;
+
+  return result;
+}
+
+bool hash_file(const std::string& path, uint64_t& hash)
+{
+  const auto file = open(path.c_str(), O_RDONLY);
+
+  if (file < 0)
+  {
+    return false;
+  }
+
+  struct stat info;
+
+  if (fstat(file, &info) != 0)
+  {
+    close(file);
+    return false;
+  }
+
+  {
+    std::lock_guard<std::mutex> lock(file_hashes_mutex);
+    const auto cached = file_hashes.find(path);
+
+    if (cached != file_hashes.end() && cached->second.inode == info.st_ino &&
+        cached->second.size == info.st_size && cached->second.modified == info.st_mtime)
+    {
+      close(file);
+      hash = cached->second.hash;
+
+      return true;
+    }
+  }
+
+  const auto size = static_cast<size_t>(info.st_size);
+
+  // Mapping avoids copying the file, and an empty file can't be mapped anyway
+  if (size == 0)
+  {
+    close(file);
+    hash = ContentHash::hash(nullptr, 0);
+
+    return true;
+  }
+
+  const auto mapping = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+  close(file);
+
+  if (mapping == MAP_FAILED)
+  {
+    return false;
+  }
+
+  hash = ContentHash::hash(mapping, size);
+  munmap(mapping, size);
+
+  std::lock_guard<std::mutex> lock(file_hashes_mutex);
+  file_hashes[path] = {info.st_ino, info.st_size, info.st_mtime, hash};
+
+  return true;
+}
+
+uint64_t combine(const uint64_t hash, const uint64_t value)
+{
+  return ContentHash::hash(&value, sizeof(value), hash);
+}
+} // end of namespace ContentHash
+} // end of namespace BarelyEngine
@@ -0,0 +1,89 @@
+//
+// cycle_timer.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include "cycle_timer.h"
+
+namespace BarelyEngine {
+namespace CycleClock {
+namespace {
+using clock = std::chrono::steady_clock;
+using milliseconds = std::chrono::duration<double, std::milli>;
+
+/// The shortest interval to calibrate over, in milliseconds
+const double kCalibrationMilliseconds = 50;
+/// The number of times to read both clocks, keeping the closest reading
+const int kReadAttempts = 8;
+
+/**
+ * A reading of both clocks, for calibrating against
+ */
+struct Reading
+{
+  uint64_t ticks;
+  clock::time_point time;
+};
+
+Reading read()
+{
+  // Read the cycle counter either side of the clock, and use the middle of
+  // the closest pair (the others may have been interrupted)
+  Reading best{0, clock::now()};
+  auto best_spread = UINT64_MAX;
+
+  for (int i = 0; i < kReadAttempts; i++)
+  {
+    const auto before = now();
+    const auto time = clock::now();
+    const auto after = now_serialized();
+
+    if (after - before < best_spread)
+    {
+      best = {before + (after - before) / 2, time};
+      best_spread = after - before;
+    }
+  }
+
+  return best;
+}
+
+/**
+ * The reading calibration starts from, taken on first use (so it's safe to
+ * use from other static initialisers)
+ */
+const Reading& start()
+{
+  static const Reading reading = read();
+  return reading;
+}
+
+/// Takes the starting reading when the program starts, so by the time anything
+/// is converted the calibration interval has usually passed already
+const Reading& kStartAtLoad = start();
+
+double calibrate()
+{
+#if defined(__x86_64__) || defined(__i386__)
+  const auto& begin = start();
+  auto end = read();
+
+  while (milliseconds(end.time - begin.time).count() < kCalibrationMilliseconds)
+  {
+    end = read();
+  }
+
+  return (end.ticks - begin.ticks) / milliseconds(end.time - begin.time).count();
+#else
+  return 1000000.0;
+#endif
+}
+} // end of anonymous namespace
+
+double ticks_per_millisecond()
+{
+  static const double rate = calibrate();
+  return rate;
+}
+} // end of namespace CycleClock
+} // end of namespace BarelyEngine
@@ -7,15 +7,20 @@
 #include <SDL2/SDL.h>
 #include "engine.h"
 #include "exception.h"
+#include "job_system.h"
 #include "logging.h"
 
 using namespace std::literals;
 
 namespace BarelyEngine {
 std::vector<Logger*> Engine::loggers_;
+std::mutex Engine::loggers_mutex_;
+std::unique_ptr<JobSystem> Engine::jobs_;
 
-void Engine::init()
+void Engine::init(const size_t worker_count)
 {
+  start_jobs(worker_count);
+
   BE_LOG("Initialising SDL...");
 
   if (SDL_Init(SDL_INIT_VIDEO) != 0)
@@ -24,8 +29,43 @@ void Engine::init()
   }
 }
 
+void Engine::quit()
+{
+  stop_jobs();
+  SDL_Quit();
+}
+
+void Engine::start_jobs(const size_t worker_count)
+{
+  if (!jobs_)
+  {
+    jobs_ = std::make_unique<JobSystem>(worker_count);
+    BE_LOG("Started job system with " + std::to_string(jobs_->worker_count()) + " workers");
+  }
+}
+
+void Engine::stop_jobs()
+{
+  if (jobs_)
+  {
+    jobs_.reset();
+    BE_LOG("Stopped job system");
+  }
+}
+
+JobSystem& Engine::jobs()
+{
+  if (!jobs_)
+  {
+    throw Exception("The job system isn't running (call Engine::init() or Engine::start_jobs() first)");
+  }
+
+  return *jobs_;
+}
+
 void Engine::register_logger(Logger* const logger)
 {
+  std::lock_guard<std::mutex> lock(loggers_mutex_);
   const auto search = std::find(loggers_.begin(), loggers_.end(), logger);
 
   if (search == loggers_.end())
@@ -36,11 +76,14 @@ void Engine::register_logger(Logger* const logger)
 
 void Engine::unregister_logger(Logger* const logger)
 {
+  std::lock_guard<std::mutex> lock(loggers_mutex_);
   loggers_.erase(std::remove(loggers_.begin(), loggers_.end(), logger), loggers_.end());
 }
 
 void Engine::log(const LogLevel level, const std::string& message, const std::string& prefix)
 {
+  std::lock_guard<std::mutex> lock(loggers_mutex_);
+
   for (const auto logger : loggers_)
   {
     if (logger != nullptr)
@@ -49,4 +92,10 @@ void Engine::log(const LogLevel level, const std::string& message, const std::st
     }
   }
 }
+
+std::vector<Logger*> Engine::loggers()
+{
+  std::lock_guard<std::mutex> lock(loggers_mutex_);
+  return loggers_;
+}
 } // end of namespace BarelyEngine
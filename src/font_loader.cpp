@@ -7,12 +7,26 @@
 #include "font_loader.h"
 #include "font.h"
 #include "font_generator.h"
+#include "content_hash.h"
 #include "logging.h"
 #include "exception.h"
 
 using namespace std::literals;
 
 namespace BarelyEngine {
+bool read_option(LoaderOptions<FontLoader>& options, const std::string& key,
+                 const std::string& value)
+{
+  if (key == "size" && !value.empty() && value.size() < 6 &&
+      value.find_first_not_of("0123456789") == std::string::npos)
+  {
+    options.size = std::stoi(value);
+    return true;
+  }
+
+  return false;
+}
+
 FontLoader::FontLoader()
   : font_generator_(std::make_unique<FreeType::FontGenerator>())
 {
@@ -41,4 +55,20 @@ std::unique_ptr<Font> FontLoader::load(const std::string& filename,
     return nullptr;
   }
 }
+
+uint64_t FontLoader::content_hash(const std::string& filename,
+                                  const LoaderOptions<FontLoader>& options)
+{
+  uint64_t hash;
+
+  if (!ContentHash::hash_file("resources/fonts/" + filename, hash))
+  {
+    return 0;
+  }
+
+  hash = ContentHash::combine(hash, static_cast<uint64_t>(options.size));
+
+  // 0 means unknown, so nudge the (very unlikely) real one
+  return hash != 0 ? hash : 1;
+}
 } // end of namespace BarelyEngine
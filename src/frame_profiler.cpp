@@ -7,9 +7,12 @@
 
 namespace BarelyEngine {
 FrameProfiler FrameProfiler::instance_;
+const size_t FrameProfiler::kMaxTickSamples;
 
 void FrameProfiler::add_frame_sample(float dt)
 {
+  collect_queued_samples();
+  convert_tick_samples();
   frame_samples_.push_back(dt);
 }
 
@@ -17,4 +20,59 @@ void FrameProfiler::add_sample(const char* name, float value)
 {
   samples_[name].push_back(value);
 }
+
+void FrameProfiler::add_tick_sample(const char* name, uint64_t ticks)
+{
+  tick_samples_[tick_head_] = {name, ticks};
+  tick_head_ = (tick_head_ + 1) % kMaxTickSamples;
+
+  if (tick_count_ < kMaxTickSamples)
+  {
+    tick_count_++;
+  }
+  else
+  {
+    // Full, so that was the oldest sample
+    overwritten_tick_samples_++;
+  }
+}
+
+void FrameProfiler::queue_sample(const char* name, float value)
+{
+  queued_samples_.push_back({name, value});
+}
+
+void FrameProfiler::collect_queued_samples()
+{
+  QueuedSample batch[64];
+  size_t count = 0;
+
+  while ((count = queued_samples_.pop_front(batch, 64)) > 0)
+  {
+    for (size_t i = 0; i < count; i++)
+    {
+      add_sample(batch[i].name, batch[i].value);
+    }
+  }
+}
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+void FrameProfiler::convert_tick_samples() const
+{
+  // Oldest first, so each buffer's samples stay in order
+  const auto oldest = (tick_head_ + kMaxTickSamples - tick_count_) % kMaxTickSamples;
+
+  for (size_t i = 0; i < tick_count_; i++)
+  {
+    const auto& sample = tick_samples_[(oldest + i) % kMaxTickSamples];
+    samples_[sample.name].push_back(static_cast<float>(CycleClock::to_milliseconds(sample.ticks)));
+  }
+
+  tick_count_ = 0;
+}
 } // end of namespace BarelyEngine
@@ -0,0 +1,158 @@
+//
+// game_loop.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <thread>
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include "game_loop.h"
+#include "exception.h"
+#include "profiling.h"
+
+namespace BarelyEngine {
+namespace {
+/// How long each sleep of a wait asks for, in milliseconds
+const double kSleepMilliseconds = 1;
+/// The number of sleeps the estimate is averaged over, so it keeps adapting
+/// if the system gets busier (or quieter)
+const size_t kSleepWindow = 1000;
+} // end of anonymous namespace
+
+GameLoop::GameLoop(const double update_rate, const double frame_rate)
+{
+  set_update_rate(update_rate);
+  set_frame_rate(frame_rate);
+}
+
+void GameLoop::run(const UpdateFunction& update, const RenderFunction& render)
+{
+  running_ = true;
+  accumulator_ = 0;
+
+  auto previous = clock::now();
+  auto deadline = previous;
+
+  while (running_)
+  {
+    const auto now = clock::now();
+    const std::chrono::duration<double, std::milli> elapsed = now - previous;
+    previous = now;
+
+    PROFILE_FRAME(static_cast<float>(elapsed.count()));
+
+    advance(elapsed.count(), update);
+
+    if (!running_)
+    {
+      break;
+    }
+
+    render(alpha());
+
+    if (frame_period_ > clock::duration::zero())
+    {
+      // Frames are paced from the last deadline rather than from now, so they
+      // don't drift, unless the loop has fallen a whole frame behind
+      deadline = std::max(deadline + frame_period_, clock::now());
+
+      Timer wait;
+      wait_until(deadline);
+      PROFILE_VALUE("Frame wait", static_cast<float>(wait.peek()));
+    }
+  }
+}
+
+size_t GameLoop::advance(const double elapsed, const UpdateFunction& update)
+{
+  accumulator_ += std::min(elapsed, step_ * max_updates_);
+
+  size_t updates = 0;
+
+  while (accumulator_ >= step_)
+  {
+    update(step_);
+    accumulator_ -= step_;
+    updates++;
+  }
+
+  return updates;
+}
+
+void GameLoop::wait_until(const clock::time_point deadline)
+{
+  using milliseconds = std::chrono::duration<double, std::milli>;
+
+  // Sleep while even a slow sleep would wake up before the deadline
+  while (milliseconds(deadline - clock::now()).count() > sleep_estimate_)
+  {
+    const auto start = clock::now();
+    std::this_thread::sleep_for(milliseconds(kSleepMilliseconds));
+    record_sleep(milliseconds(clock::now() - start).count());
+  }
+
+  // Spin for the rest, which is too short to trust to the scheduler
+  while (clock::now() < deadline)
+  {
+    // Hint that this is a spin, so it doesn't starve a sibling hyperthread
+#if defined(__SSE2__)
+    _mm_pause();
+#else
+    std::this_thread::yield();
+#endif
+  }
+}
+
+void GameLoop::set_update_rate(const double update_rate)
+{
+  // Also rejects NaN
+  if (!(update_rate > 0))
+  {
+    throw Exception("Update rate must be positive, not " + std::to_string(update_rate));
+  }
+
+  step_ = 1000.0 / update_rate;
+}
+
+void GameLoop::set_frame_rate(const double frame_rate)
+{
+  if (frame_rate > 0)
+  {
+    frame_period_ = std::chrono::duration_cast<clock::duration>(
+      std::chrono::duration<double>(1.0 / frame_rate));
+  }
+  else
+  {
+    frame_period_ = clock::duration::zero();
+  }
+}
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+void GameLoop::record_sleep(const double observed)
+{
+  // Welford's running mean and variance, restarted every so often so old
+  // sleeps stop counting
+  if (sleep_count_ >= kSleepWindow)
+  {
+    sleep_count_ = 1;
+    sleep_m2_ = 0;
+  }
+
+  sleep_count_++;
+
+  const auto delta = observed - sleep_mean_;
+  sleep_mean_ += delta / sleep_count_;
+  sleep_m2_ += delta * (observed - sleep_mean_);
+
+  sleep_estimate_ = sleep_mean_ + std::sqrt(sleep_m2_ / (sleep_count_ - 1));
+}
+} // end of namespace BarelyEngine
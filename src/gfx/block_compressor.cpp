@@ -0,0 +1,209 @@
+//
+// gfx/block_compressor.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <algorithm>
+#include <cstdlib>
+#include "block_compressor.h"
+#include "exception.h"
+
+namespace BarelyEngine {
+namespace BlockCompressor {
+namespace {
+/**
+ * @brief Packs a color into RGB565
+ */
+uint16_t pack_565(const int r, const int g, const int b)
+{
+  return static_cast<uint16_t>((r * 31 + 127) / 255 << 11 | (g * 63 + 127) / 255 << 5 |
+                               (b * 31 + 127) / 255);
+}
+
+/**
+ * @brief Unpacks an RGB565 color, replicating the high bits into the low bits
+ */
+void unpack_565(const uint16_t color, int* rgb)
+{
+  const auto r = color >> 11 & 0x1F;
+  const auto g = color >> 5 & 0x3F;
+  const auto b = color & 0x1F;
+
+  rgb[0] = r << 3 | r >> 2;
+  rgb[1] = g << 2 | g >> 4;
+  rgb[2] = b << 3 | b >> 2;
+}
+
+void write_u16(uint8_t* target, const uint16_t value)
+{
+  target[0] = static_cast<uint8_t>(value);
+  target[1] = static_cast<uint8_t>(value >> 8);
+}
+} // end of anonymous namespace
+
+void compress_bc1_block(const uint8_t* pixels, uint8_t* block)
+{
+  int min[3] = {255, 255, 255};
+  int max[3] = {0, 0, 0};
+
+  for (int i = 0; i < 16; i++)
+  {
+    for (int c = 0; c < 3; c++)
+    {
+      min[c] = std::min<int>(min[c], pixels[i * 4 + c]);
+      max[c] = std::max<int>(max[c], pixels[i * 4 + c]);
+    }
+  }
+
+  // The first color must not be less than the second, or the block is decoded
+  // in the 3 color (punch-through alpha) mode. Since every channel of the max
+  // is at least that of the min, that's always the case here.
+  const auto color0 = pack_565(max[0], max[1], max[2]);
+  const auto color1 = pack_565(min[0], min[1], min[2]);
+
+  write_u16(&block[0], color0);
+  write_u16(&block[2], color1);
+
+  uint32_t indices = 0;
+
+  if (color0 != color1)
+  {
+    // The palette in index order: color0, color1, 2/3 color0 + 1/3 color1,
+    // 1/3 color0 + 2/3 color1
+    int palette[4][3];
+    unpack_565(color0, palette[0]);
+    unpack_565(color1, palette[1]);
+
+    for (int c = 0; c < 3; c++)
+    {
+      palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+      palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+    }
+
+    for (int i = 0; i < 16; i++)
+    {
+      int best = 0;
+      int best_distance = 0x7FFFFFFF;
+
+      for (int p = 0; p < 4; p++)
+      {
+        int distance = 0;
+
+        for (int c = 0; c < 3; c++)
+        {
+          const auto delta = pixels[i * 4 + c] - palette[p][c];
+          distance += delta * delta;
+        }
+
+        if (distance < best_distance)
+        {
+          best = p;
+          best_distance = distance;
+        }
+      }
+
+      indices |= static_cast<uint32_t>(best) << (i * 2);
+    }
+  }
+
+  write_u16(&block[4], static_cast<uint16_t>(indices));
+  write_u16(&block[6], static_cast<uint16_t>(indices >> 16));
+}
+
+void compress_bc3_block(const uint8_t* pixels, uint8_t* block)
+{
+  int alpha0 = 0;
+  int alpha1 = 255;
+
+  for (int i = 0; i < 16; i++)
+  {
+    alpha0 = std::max<int>(alpha0, pixels[i * 4 + 3]);
+    alpha1 = std::min<int>(alpha1, pixels[i * 4 + 3]);
+  }
+
+  block[0] = static_cast<uint8_t>(alpha0);
+  block[1] = static_cast<uint8_t>(alpha1);
+
+  uint64_t indices = 0;
+
+  if (alpha0 != alpha1)
+  {
+    // With alpha0 > alpha1 the palette is alpha0, alpha1 then 6 values
+    // interpolated between them
+    int palette[8] = {alpha0, alpha1};
+
+    for (int p = 1; p < 7; p++)
+    {
+      palette[p + 1] = ((7 - p) * alpha0 + p * alpha1) / 7;
+    }
+
+    for (int i = 0; i < 16; i++)
+    {
+      int best = 0;
+
+      for (int p = 1; p < 8; p++)
+      {
+        if (std::abs(pixels[i * 4 + 3] - palette[p]) <
+            std::abs(pixels[i * 4 + 3] - palette[best]))
+        {
+          best = p;
+        }
+      }
+
+      indices |= static_cast<uint64_t>(best) << (i * 3);
+    }
+  }
+
+  for (int i = 0; i < 6; i++)
+  {
+    block[2 + i] = static_cast<uint8_t>(indices >> (i * 8));
+  }
+
+  compress_bc1_block(pixels, &block[8]);
+}
+
+std::vector<uint8_t> compress(const uint8_t* pixels, const int width, const int height,
+                              const CompressedFormat format)
+{
+  if (format != CompressedFormat::BC1 && format != CompressedFormat::BC3)
+  {
+    throw Exception("Only BC1 and BC3 can be compressed by the engine");
+  }
+
+  const auto block_size = CompressedImage::block_size(format);
+  std::vector<uint8_t> blocks(CompressedImage::level_size(format, width, height));
+  auto block = blocks.data();
+
+  for (int block_y = 0; block_y < height; block_y += 4)
+  {
+    for (int block_x = 0; block_x < width; block_x += 4, block += block_size)
+    {
+      uint8_t block_pixels[16 * 4];
+
+      for (int y = 0; y < 4; y++)
+      {
+        for (int x = 0; x < 4; x++)
+        {
+          const auto source_x = std::min(block_x + x, width - 1);
+          const auto source_y = std::min(block_y + y, height - 1);
+          const auto source = &pixels[(source_y * width + source_x) * 4];
+
+          std::copy(source, source + 4, &block_pixels[(y * 4 + x) * 4]);
+        }
+      }
+
+      if (format == CompressedFormat::BC1)
+      {
+        compress_bc1_block(block_pixels, block);
+      }
+      else
+      {
+        compress_bc3_block(block_pixels, block);
+      }
+    }
+  }
+
+  return blocks;
+}
+} // end of namespace BlockCompressor
+} // end of namespace BarelyEngine
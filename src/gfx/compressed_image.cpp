@@ -0,0 +1,484 @@
+//
+// gfx/compressed_image.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <utility>
+#include "compressed_image.h"
+#include "exception.h"
+
+using namespace std::literals;
+
+namespace BarelyEngine {
+namespace {
+/*
+ * Compressed internal formats. Most of these come from extensions, so aren't
+ * in the OpenGL 3.3 headers.
+ */
+const GLenum kCompressedRgbaS3tcDxt1 = 0x83F1;
+const GLenum kCompressedRgbaS3tcDxt5 = 0x83F3;
+const GLenum kCompressedRgbaBptcUnorm = 0x8E8C;
+const GLenum kCompressedRgb8Etc2 = 0x9274;
+const GLenum kCompressedRgba8Etc2Eac = 0x9278;
+
+/*
+ * DDS layout (see "Programming Guide for DDS" on MSDN)
+ */
+const uint32_t kDdsMagic = 0x20534444; // "DDS "
+const size_t kDdsHeaderSize = 128;     // Including the magic
+const size_t kDdsDx10HeaderSize = 20;
+const uint32_t kDxt1 = 0x31545844;     // "DXT1"
+const uint32_t kDxt5 = 0x35545844;     // "DXT5"
+const uint32_t kDx10 = 0x30315844;     // "DX10"
+
+/*
+ * KTX2 layout (see the KTX File Format Specification, version 2)
+ */
+const uint8_t kKtx2Identifier[] = {0xAB, 0x4B, 0x54, 0x58, 0x20, 0x32,
+                                   0x30, 0xBB, 0x0D, 0x0A, 0x1A, 0x0A};
+const size_t kKtx2HeaderSize = 80; // Including the identifier and index
+const size_t kKtx2LevelIndexSize = 24;
+
+uint32_t read_u32(const std::vector<uint8_t>& file, const size_t offset)
+{
+  uint32_t value;
+  std::memcpy(&value, &file[offset], sizeof(value));
+  return value;
+}
+
+uint64_t read_u64(const std::vector<uint8_t>& file, const size_t offset)
+{
+  uint64_t value;
+  std::memcpy(&value, &file[offset], sizeof(value));
+  return value;
+}
+
+void write_u32(std::vector<uint8_t>& file, const uint32_t value)
+{
+  const auto bytes = reinterpret_cast<const uint8_t*>(&value);
+  file.insert(file.end(), bytes, bytes + sizeof(value));
+}
+
+void write_u64(std::vector<uint8_t>& file, const uint64_t value)
+{
+  const auto bytes = reinterpret_cast<const uint8_t*>(&value);
+  file.insert(file.end(), bytes, bytes + sizeof(value));
+}
+
+/**
+ * @brief Builds the levels of a mipmap chain stored back to back, largest first
+ */
+std::vector<CompressedLevel> contiguous_levels(const CompressedFormat format, const int width,
+                                               const int height, const size_t count,
+                                               size_t offset)
+{
+  std::vector<CompressedLevel> levels;
+
+  for (size_t i = 0; i < count; i++)
+  {
+    const auto level_width = std::max(1, width >> i);
+    const auto level_height = std::max(1, height >> i);
+    const auto size = CompressedImage::level_size(format, level_width, level_height);
+
+    levels.push_back({level_width, level_height, offset, size});
+    offset += size;
+  }
+
+  return levels;
+}
+
+/**
+ * @brief Returns the KTX2 basic data format descriptor for a format
+ *
+ * Loaders identify the format from the header's vkFormat, but the descriptor
+ * is required for the file to be valid.
+ */
+std::vector<uint32_t> ktx2_descriptor(const CompressedFormat format)
+{
+  // Khronos Data Format colour models and channel ids
+  const uint32_t kModelBc1a = 128, kModelBc3 = 130, kModelBc7 = 135, kModelEtc2 = 161;
+  const uint32_t kChannelColor = 0, kChannelEtc2Color = 2, kChannelAlpha = 15;
+
+  uint32_t model = 0;
+  // Pairs of (channel id, bit offset) for each 64-bit sample
+  std::vector<std::pair<uint32_t, uint32_t>> samples;
+  uint32_t sample_bits = 64;
+
+  switch (format)
+  {
+    case CompressedFormat::BC1:
+      model = kModelBc1a;
+      samples = {{kChannelColor, 0}};
+      break;
+    case CompressedFormat::BC3:
+      model = kModelBc3;
+      samples = {{kChannelAlpha, 0}, {kChannelColor, 64}};
+      break;
+    case CompressedFormat::BC7:
+      model = kModelBc7;
+      samples = {{kChannelColor, 0}};
+      sample_bits = 128;
+      break;
+    case CompressedFormat::ETC2_RGB:
+      model = kModelEtc2;
+      samples = {{kChannelEtc2Color, 0}};
+      break;
+    case CompressedFormat::ETC2_RGBA:
+      model = kModelEtc2;
+      samples = {{kChannelAlpha, 0}, {kChannelEtc2Color, 64}};
+      break;
+  }
+
+  const auto block_size = static_cast<uint32_t>(24 + 16 * samples.size());
+  std::vector<uint32_t> words = {
+    block_size + 4,                       // Total size
+    0,                                    // Vendor (Khronos) and descriptor type (basic)
+    2 | block_size << 16,                 // Version and block size
+    model | 1 << 8 | 1 << 16,             // Model, BT.709 primaries, linear transfer
+    3 | 3 << 8,                           // Block dimensions (4x4, stored minus one)
+    static_cast<uint32_t>(CompressedImage::block_size(format)), // Bytes in plane 0
+    0};
+
+  for (const auto& sample : samples)
+  {
+    words.push_back(sample.second | (sample_bits - 1) << 16 | sample.first << 24);
+    words.push_back(0);          // Sample position
+    words.push_back(0);          // Lower bound
+    words.push_back(0xFFFFFFFF); // Upper bound
+  }
+
+  return words;
+}
+} // end of anonymous namespace
+
+CompressedImage::CompressedImage(const CompressedFormat format, std::vector<uint8_t> data,
+                                 std::vector<CompressedLevel> levels)
+  : format_(format)
+  , data_(std::move(data))
+  , levels_(std::move(levels))
+{
+  if (levels_.empty())
+  {
+    throw Exception("Compressed image has no levels");
+  }
+
+  for (const auto& level : levels_)
+  {
+    if (level.offset + level.size > data_.size() ||
+        level.size != level_size(format_, level.width, level.height))
+    {
+      throw Exception("Compressed image level doesn't fit its data");
+    }
+  }
+}
+
+std::unique_ptr<CompressedImage> CompressedImage::load(const std::string& path)
+{
+  std::ifstream stream(path, std::ios::binary);
+
+  if (!stream)
+  {
+    throw Exception("Couldn't open '"s + path + "'");
+  }
+
+  std::vector<uint8_t> file((std::istreambuf_iterator<char>(stream)),
+                            std::istreambuf_iterator<char>());
+
+  return read(std::move(file));
+}
+
+std::unique_ptr<CompressedImage> CompressedImage::read(std::vector<uint8_t> file)
+{
+  if (file.size() >= 4 && read_u32(file, 0) == kDdsMagic)
+  {
+    return read_dds(std::move(file));
+  }
+  else if (file.size() >= sizeof(kKtx2Identifier) &&
+           std::equal(std::begin(kKtx2Identifier), std::end(kKtx2Identifier), file.begin()))
+  {
+    return read_ktx2(std::move(file));
+  }
+
+  throw Exception("Not a DDS or KTX2 file");
+}
+
+std::vector<uint8_t> CompressedImage::to_dds() const
+{
+  uint32_t four_cc = 0;
+
+  switch (format_)
+  {
+    case CompressedFormat::BC1: four_cc = kDxt1; break;
+    case CompressedFormat::BC3: four_cc = kDxt5; break;
+    case CompressedFormat::BC7: four_cc = kDx10; break;
+    default: throw Exception("DDS files can't hold ETC2 images");
+  }
+
+  const auto level_count = static_cast<uint32_t>(levels_.size());
+  const auto has_mipmaps = level_count > 1;
+
+  std::vector<uint8_t> file;
+
+  write_u32(file, kDdsMagic);
+  write_u32(file, 124); // Header size
+  // Caps, height, width, pixel format, linear size (and mipmap count)
+  write_u32(file, 0x81007 | (has_mipmaps ? 0x20000 : 0));
+  write_u32(file, static_cast<uint32_t>(height()));
+  write_u32(file, static_cast<uint32_t>(width()));
+  write_u32(file, static_cast<uint32_t>(levels_.front().size));
+  write_u32(file, 0); // Depth
+  write_u32(file, level_count);
+  for (int i = 0; i < 11; i++) write_u32(file, 0);
+
+  // Pixel format (only the four character code is used)
+  write_u32(file, 32);
+  write_u32(file, 0x4);
+  write_u32(file, four_cc);
+  for (int i = 0; i < 5; i++) write_u32(file, 0);
+
+  // Texture (plus complex and mipmap, when there's more than one level)
+  write_u32(file, 0x1000 | (has_mipmaps ? 0x400008 : 0));
+  for (int i = 0; i < 4; i++) write_u32(file, 0);
+
+  if (four_cc == kDx10)
+  {
+    write_u32(file, 98); // DXGI_FORMAT_BC7_UNORM
+    write_u32(file, 3);  // Texture2D
+    write_u32(file, 0);
+    write_u32(file, 1);  // Array size
+    write_u32(file, 0);
+  }
+
+  for (size_t i = 0; i < levels_.size(); i++)
+  {
+    file.insert(file.end(), level_data(i), level_data(i) + levels_[i].size);
+  }
+
+  return file;
+}
+
+std::vector<uint8_t> CompressedImage::to_ktx2() const
+{
+  uint32_t vk_format = 0;
+
+  switch (format_)
+  {
+    case CompressedFormat::BC1: vk_format = 133; break;       // BC1_RGBA_UNORM_BLOCK
+    case CompressedFormat::BC3: vk_format = 137; break;       // BC3_UNORM_BLOCK
+    case CompressedFormat::BC7: vk_format = 145; break;       // BC7_UNORM_BLOCK
+    case CompressedFormat::ETC2_RGB: vk_format = 147; break;  // ETC2_R8G8B8_UNORM_BLOCK
+    case CompressedFormat::ETC2_RGBA: vk_format = 151; break; // ETC2_R8G8B8A8_UNORM_BLOCK
+  }
+
+  const auto descriptor = ktx2_descriptor(format_);
+  const auto level_count = levels_.size();
+  const auto descriptor_offset = kKtx2HeaderSize + kKtx2LevelIndexSize * level_count;
+  const auto descriptor_size = descriptor.size() * sizeof(uint32_t);
+
+  // Levels are stored smallest first, each aligned to the block size
+  const auto alignment = block_size(format_);
+  std::vector<size_t> offsets(level_count);
+  auto offset = descriptor_offset + descriptor_size;
+
+  for (size_t i = level_count; i-- > 0;)
+  {
+    offset = (offset + alignment - 1) / alignment * alignment;
+    offsets[i] = offset;
+    offset += levels_[i].size;
+  }
+
+  std::vector<uint8_t> file(std::begin(kKtx2Identifier), std::end(kKtx2Identifier));
+
+  write_u32(file, vk_format);
+  write_u32(file, 1); // Type size
+  write_u32(file, static_cast<uint32_t>(width()));
+  write_u32(file, static_cast<uint32_t>(height()));
+  write_u32(file, 0); // Depth
+  write_u32(file, 0); // Layers
+  write_u32(file, 1); // Faces
+  write_u32(file, static_cast<uint32_t>(level_count));
+  write_u32(file, 0); // Supercompression
+
+  write_u32(file, static_cast<uint32_t>(descriptor_offset));
+  write_u32(file, static_cast<uint32_t>(descriptor_size));
+  write_u32(file, 0); // Key/value data
+  write_u32(file, 0);
+  write_u64(file, 0); // Supercompression global data
+  write_u64(file, 0);
+
+  for (size_t i = 0; i < level_count; i++)
+  {
+    write_u64(file, offsets[i]);
+    write_u64(file, levels_[i].size);
+    write_u64(file, levels_[i].size);
+  }
+
+  for (const auto word : descriptor)
+  {
+    write_u32(file, word);
+  }
+
+  file.resize(offset);
+
+  for (size_t i = 0; i < level_count; i++)
+  {
+    std::copy(level_data(i), level_data(i) + levels_[i].size, &file[offsets[i]]);
+  }
+
+  return file;
+}
+
+size_t CompressedImage::level_size(const CompressedFormat format, const int width,
+                                   const int height)
+{
+  const auto blocks_wide = static_cast<size_t>((width + 3) / 4);
+  const auto blocks_high = static_cast<size_t>((height + 3) / 4);
+
+  return blocks_wide * blocks_high * block_size(format);
+}
+
+size_t CompressedImage::block_size(const CompressedFormat format)
+{
+  switch (format)
+  {
+    case CompressedFormat::BC1:
+    case CompressedFormat::ETC2_RGB:
+      return 8;
+    default:
+      return 16;
+  }
+}
+
+GLenum CompressedImage::gl_format(const CompressedFormat format)
+{
+  switch (format)
+  {
+    case CompressedFormat::BC1: return kCompressedRgbaS3tcDxt1;
+    case CompressedFormat::BC3: return kCompressedRgbaS3tcDxt5;
+    case CompressedFormat::BC7: return kCompressedRgbaBptcUnorm;
+    case CompressedFormat::ETC2_RGB: return kCompressedRgb8Etc2;
+    case CompressedFormat::ETC2_RGBA: return kCompressedRgba8Etc2Eac;
+  }
+
+  return GL_FALSE;
+}
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+std::unique_ptr<CompressedImage> CompressedImage::read_dds(std::vector<uint8_t> file)
+{
+  if (file.size() < kDdsHeaderSize || read_u32(file, 4) != 124)
+  {
+    throw Exception("DDS header is truncated");
+  }
+
+  const auto height = static_cast<int>(read_u32(file, 12));
+  const auto width = static_cast<int>(read_u32(file, 16));
+  const auto level_count = std::max<uint32_t>(1, read_u32(file, 28));
+  const auto four_cc = read_u32(file, 84);
+
+  CompressedFormat format;
+  size_t data_offset = kDdsHeaderSize;
+
+  if (four_cc == kDxt1)
+  {
+    format = CompressedFormat::BC1;
+  }
+  else if (four_cc == kDxt5)
+  {
+    format = CompressedFormat::BC3;
+  }
+  else if (four_cc == kDx10 && file.size() >= kDdsHeaderSize + kDdsDx10HeaderSize)
+  {
+    data_offset += kDdsDx10HeaderSize;
+
+    switch (read_u32(file, kDdsHeaderSize))
+    {
+      case 71: case 72: format = CompressedFormat::BC1; break;
+      case 77: case 78: format = CompressedFormat::BC3; break;
+      case 98: case 99: format = CompressedFormat::BC7; break;
+      default: throw Exception("Unsupported DXGI format in DDS file");
+    }
+  }
+  else
+  {
+    throw Exception("Unsupported DDS pixel format");
+  }
+
+  if (width <= 0 || height <= 0 || level_count > 32)
+  {
+    throw Exception("DDS file has invalid dimensions");
+  }
+
+  auto levels = contiguous_levels(format, width, height, level_count, data_offset);
+
+  return std::make_unique<CompressedImage>(format, std::move(file), std::move(levels));
+}
+
+std::unique_ptr<CompressedImage> CompressedImage::read_ktx2(std::vector<uint8_t> file)
+{
+  if (file.size() < kKtx2HeaderSize)
+  {
+    throw Exception("KTX2 header is truncated");
+  }
+
+  CompressedFormat format;
+
+  switch (read_u32(file, 12))
+  {
+    case 131: case 132: case 133: case 134: format = CompressedFormat::BC1; break;
+    case 137: case 138: format = CompressedFormat::BC3; break;
+    case 145: case 146: format = CompressedFormat::BC7; break;
+    case 147: case 148: format = CompressedFormat::ETC2_RGB; break;
+    case 151: case 152: format = CompressedFormat::ETC2_RGBA; break;
+    default: throw Exception("Unsupported vkFormat in KTX2 file");
+  }
+
+  const auto width = static_cast<int>(read_u32(file, 20));
+  const auto height = static_cast<int>(read_u32(file, 24));
+  const auto level_count = std::max<uint32_t>(1, read_u32(file, 40));
+
+  if (read_u32(file, 28) != 0 || read_u32(file, 32) > 1 || read_u32(file, 36) != 1)
+  {
+    throw Exception("Only 2D KTX2 files are supported (no arrays, cube maps or 3D)");
+  }
+
+  if (read_u32(file, 44) != 0)
+  {
+    throw Exception("Supercompressed KTX2 files aren't supported");
+  }
+
+  if (width <= 0 || height <= 0 || level_count > 32 ||
+      file.size() < kKtx2HeaderSize + kKtx2LevelIndexSize * level_count)
+  {
+    throw Exception("KTX2 file has invalid dimensions");
+  }
+
+  std::vector<CompressedLevel> levels;
+
+  for (size_t i = 0; i < level_count; i++)
+  {
+    const auto index = kKtx2HeaderSize + kKtx2LevelIndexSize * i;
+    const auto offset = read_u64(file, index);
+    const auto size = read_u64(file, index + 8);
+
+    if (offset > file.size() || size > file.size() - offset)
+    {
+      throw Exception("KTX2 level lies outside of the file");
+    }
+
+    levels.push_back({std::max(1, width >> i), std::max(1, height >> i),
+                      static_cast<size_t>(offset), static_cast<size_t>(size)});
+  }
+
+  return std::make_unique<CompressedImage>(format, std::move(file), std::move(levels));
+}
+} // end of namespace BarelyEngine
@@ -0,0 +1,86 @@
+//
+// gfx/culling_grid.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <algorithm>
+#include <cmath>
+#include "culling_grid.h"
+#include "render_element.h"
+
+namespace BarelyEngine {
+CullingGrid::CullingGrid(const float cell_size)
+  : grid_(cell_size)
+{
+}
+
+CullingGrid::Handle CullingGrid::insert(const RenderElement* render_element)
+{
+  return grid_.insert(render_element, filed_bounds(render_element));
+}
+
+void CullingGrid::update(const Handle handle)
+{
+  grid_.move(handle, filed_bounds(grid_.item(handle)));
+}
+
+void CullingGrid::remove(const Handle handle)
+{
+  grid_.remove(handle);
+}
+
+void CullingGrid::clear()
+{
+  grid_.clear();
+}
+
+void CullingGrid::query(const Rect& viewport, std::vector<const RenderElement*>& visible)
+{
+  visible.clear();
+  found_.clear();
+
+  grid_.query_handles(viewport, found_);
+
+  // Handles are reused, so they say nothing about order, but the sort keys
+  // do (and ties keep to handle order, so the result doesn't vary)
+  std::sort(found_.begin(), found_.end(), [this](const Handle a, const Handle b)
+  {
+    const auto a_key = grid_.item(a)->id();
+    const auto b_key = grid_.item(b)->id();
+
+    return a_key < b_key || (a_key == b_key && a < b);
+  });
+
+  for (const auto handle : found_)
+  {
+    const auto render_element = grid_.item(handle);
+
+    // Elements filed under empty bounds only really overlap if theirs do
+    if (render_element->bounds().intersects(viewport))
+    {
+      visible.push_back(render_element);
+    }
+  }
+}
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+Rect CullingGrid::filed_bounds(const RenderElement* render_element)
+{
+  const auto& bounds = render_element->bounds();
+
+  // A bad vertex shouldn't stop the rest of the frame being drawn (and the
+  // element can't be seen anyway)
+  if (std::isfinite(bounds.x) && std::isfinite(bounds.y) && std::isfinite(bounds.w) &&
+      std::isfinite(bounds.h))
+  {
+    return bounds;
+  }
+
+  return {};
+}
+} // end of namespace BarelyEngine
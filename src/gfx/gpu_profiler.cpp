@@ -0,0 +1,194 @@
+//
+// gfx/gpu_profiler.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <algorithm>
+#include "gpu_profiler.h"
+#include "frame_profiler.h"
+
+namespace BarelyEngine {
+namespace {
+/// The number of queries generated at once when the pool runs out
+const size_t kQueryBlock = 32;
+
+/**
+ * The backend using OpenGL's timer queries
+ */
+class OpenGlQueryBackend : public GpuQueryBackend
+{
+public:
+  void generate(const size_t count, GLuint* const queries) override
+  {
+    glGenQueries(static_cast<GLsizei>(count), queries);
+  }
+
+  void destroy(const size_t count, const GLuint* const queries) override
+  {
+    glDeleteQueries(static_cast<GLsizei>(count), queries);
+  }
+
+  void write_timestamp(const GLuint query) override { glQueryCounter(query, GL_TIMESTAMP); }
+
+  bool available(const GLuint query) override
+  {
+    GLint ready = GL_FALSE;
+    glGetQueryObjectiv(query, GL_QUERY_RESULT_AVAILABLE, &ready);
+
+    return ready == GL_TRUE;
+  }
+
+  uint64_t result(const GLuint query) override
+  {
+    GLuint64 time = 0;
+    glGetQueryObjectui64v(query, GL_QUERY_RESULT, &time);
+
+    return time;
+  }
+};
+} // end of anonymous namespace
+
+GpuQueryBackend& GpuQueryBackend::opengl()
+{
+  static OpenGlQueryBackend backend;
+  return backend;
+}
+
+GpuProfiler::GpuProfiler(const size_t latency, GpuQueryBackend& backend)
+  : backend_(&backend)
+  , frames_(std::max<size_t>(latency, 1) + 1)
+{
+}
+
+void GpuProfiler::begin(const char* name)
+{
+  auto& frame = frames_[current_];
+  const auto start = take_query();
+
+  backend_->write_timestamp(start);
+
+  open_.push_back(frame.size());
+  frame.push_back({name, start, 0});
+}
+
+void GpuProfiler::end()
+{
+  if (open_.empty())
+  {
+    return;
+  }
+
+  auto& sample = frames_[current_][open_.back()];
+  open_.pop_back();
+
+  sample.end = take_query();
+  backend_->write_timestamp(sample.end);
+}
+
+void GpuProfiler::end_frame(FrameProfiler& profiler)
+{
+  // Scopes left open are ended with the frame
+  while (!open_.empty())
+  {
+    end();
+  }
+
+  // The next slot holds the oldest frame, which ended `latency` frames before
+  // this one, so it's read back before it's reused
+  current_ = (current_ + 1) % frames_.size();
+  collect(frames_[current_], profiler);
+}
+
+void GpuProfiler::release()
+{
+  if (!queries_.empty())
+  {
+    backend_->destroy(queries_.size(), queries_.data());
+  }
+
+  for (auto& frame : frames_)
+  {
+    frame.clear();
+  }
+
+  open_.clear();
+  pool_.clear();
+  queries_.clear();
+}
+
+GpuProfiler& GpuProfiler::instance()
+{
+  // Created on first use, though it doesn't touch OpenGL until a scope begins.
+  // It outlives the context, so the Window releases its queries instead
+  static GpuProfiler instance;
+  return instance;
+}
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+GLuint GpuProfiler::take_query()
+{
+  if (pool_.empty())
+  {
+    GLuint queries[kQueryBlock];
+    backend_->generate(kQueryBlock, queries);
+
+    pool_.insert(pool_.end(), queries, queries + kQueryBlock);
+    queries_.insert(queries_.end(), queries, queries + kQueryBlock);
+  }
+
+  const auto query = pool_.back();
+  pool_.pop_back();
+
+  return query;
+}
+
+void GpuProfiler::collect(std::vector<Sample>& frame, FrameProfiler& profiler)
+{
+  if (frame.empty())
+  {
+    return;
+  }
+
+  // Checking is cheap, unlike waiting, so only read the frame back if every
+  // query in it is ready
+  auto available = true;
+
+  for (const auto& sample : frame)
+  {
+    if (!backend_->available(sample.end))
+    {
+      available = false;
+      break;
+    }
+  }
+
+  if (available)
+  {
+    for (const auto& sample : frame)
+    {
+      const auto start = backend_->result(sample.start);
+      const auto end = backend_->result(sample.end);
+
+      // Timestamps are in nanoseconds
+      profiler.add_sample(sample.name, static_cast<float>((end - start) / 1000000.0));
+    }
+  }
+  else
+  {
+    dropped_frames_++;
+  }
+
+  for (const auto& sample : frame)
+  {
+    pool_.push_back(sample.start);
+    pool_.push_back(sample.end);
+  }
+
+  frame.clear();
+}
+} // end of namespace BarelyEngine
@@ -0,0 +1,221 @@
+//
+// gfx/mip_chain.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <algorithm>
+#include <cmath>
+#include "mip_chain.h"
+
+namespace BarelyEngine {
+namespace MipChain {
+namespace {
+/// The number of source pixels (per axis) contributing to each Kaiser output
+const int kKaiserTaps = 6;
+
+/**
+ * @brief Halves a level by averaging each 2x2 square
+ *
+ * When a dimension is odd, the last row or column is dropped. When it's
+ * already 1, the same pixels are used twice.
+ */
+MipLevel box_filter(const uint8_t* pixels, const int width, const int height)
+{
+  MipLevel target{std::max(1, width / 2), std::max(1, height / 2), {}};
+  target.pixels.resize(static_cast<size_t>(target.width) * target.height * 4);
+
+  for (int y = 0; y < target.height; y++)
+  {
+    const auto y0 = static_cast<size_t>(std::min(y * 2, height - 1));
+    const auto y1 = static_cast<size_t>(std::min(y * 2 + 1, height - 1));
+    const auto row0 = &pixels[y0 * width * 4];
+    const auto row1 = &pixels[y1 * width * 4];
+    auto output = &target.pixels[static_cast<size_t>(y) * target.width * 4];
+
+    for (int x = 0; x < target.width; x++)
+    {
+      const auto x0 = std::min(x * 2, width - 1) * 4;
+      const auto x1 = std::min(x * 2 + 1, width - 1) * 4;
+
+      for (int c = 0; c < 4; c++)
+      {
+        const auto sum = row0[x0 + c] + row0[x1 + c] + row1[x0 + c] + row1[x1 + c];
+        output[x * 4 + c] = static_cast<uint8_t>((sum + 2) / 4);
+      }
+    }
+  }
+
+  return target;
+}
+
+/**
+ * @brief Zeroth order modified Bessel function of the first kind (for the
+ *        Kaiser window)
+ */
+double bessel_i0(const double x)
+{
+  double sum = 1.0;
+  double term = 1.0;
+
+  for (int k = 1; k < 32; k++)
+  {
+    term *= (x / (2.0 * k)) * (x / (2.0 * k));
+    sum += term;
+  }
+
+  return sum;
+}
+
+/**
+ * @brief Calculates the normalised weights of the Kaiser filter taps
+ *
+ * Output pixel x is centred between source pixels 2x and 2x + 1, so the taps
+ * sit at distances of 0.5, 1.5 and 2.5 pixels either side of it.
+ */
+std::vector<float> kaiser_weights()
+{
+  const double alpha = 4.0;
+  const double radius = kKaiserTaps / 2.0;
+  const double pi = 3.14159265358979323846;
+
+  std::vector<float> weights(kKaiserTaps);
+  double total = 0.0;
+
+  for (int i = 0; i < kKaiserTaps; i++)
+  {
+    const auto distance = i - radius + 0.5;
+    // A sinc scaled for halving, windowed so that it tapers off to the radius
+    const auto t = distance / 2.0;
+    const auto sinc = std::sin(pi * t) / (pi * t);
+    const auto ratio = distance / radius;
+    const auto window = bessel_i0(alpha * std::sqrt(1.0 - ratio * ratio)) / bessel_i0(alpha);
+
+    weights[i] = static_cast<float>(sinc * window);
+    total += weights[i];
+  }
+
+  for (auto& weight : weights)
+  {
+    weight = static_cast<float>(weight / total);
+  }
+
+  return weights;
+}
+
+/**
+ * @brief Halves a level with the Kaiser filter, one axis at a time. Pixels
+ *        beyond the edges are clamped to the edges.
+ */
+MipLevel kaiser_filter(const uint8_t* pixels, const int width, const int height,
+                       const std::vector<float>& weights)
+{
+  MipLevel target{std::max(1, width / 2), std::max(1, height / 2), {}};
+  target.pixels.resize(static_cast<size_t>(target.width) * target.height * 4);
+
+  const auto halve_x = width > 1;
+  const auto halve_y = height > 1;
+
+  // Filter horizontally into a buffer of full height
+  std::vector<float> horizontal(static_cast<size_t>(target.width) * height * 4);
+
+  for (int y = 0; y < height; y++)
+  {
+    const auto row = &pixels[static_cast<size_t>(y) * width * 4];
+    auto output = &horizontal[static_cast<size_t>(y) * target.width * 4];
+
+    for (int x = 0; x < target.width; x++)
+    {
+      for (int tap = 0; tap < kKaiserTaps; tap++)
+      {
+        const auto source_x = halve_x ? x * 2 - kKaiserTaps / 2 + 1 + tap : x;
+        const auto clamped_x = std::min(std::max(source_x, 0), width - 1) * 4;
+        const auto weight = halve_x ? weights[tap] : 1.0f / kKaiserTaps;
+
+        for (int c = 0; c < 4; c++)
+        {
+          output[x * 4 + c] += row[clamped_x + c] * weight;
+        }
+      }
+    }
+  }
+
+  // Then filter vertically into the target
+  for (int y = 0; y < target.height; y++)
+  {
+    auto output = &target.pixels[static_cast<size_t>(y) * target.width * 4];
+
+    for (int x = 0; x < target.width * 4; x++)
+    {
+      float value = 0.0f;
+
+      for (int tap = 0; tap < kKaiserTaps; tap++)
+      {
+        const auto source_y = halve_y ? y * 2 - kKaiserTaps / 2 + 1 + tap : y;
+        const auto clamped_y = std::min(std::max(source_y, 0), height - 1);
+        const auto weight = halve_y ? weights[tap] : 1.0f / kKaiserTaps;
+
+        value += horizontal[static_cast<size_t>(clamped_y) * target.width * 4 + x] * weight;
+      }
+
+      // The negative lobes can overshoot, so clamp back into range
+      output[x] = static_cast<uint8_t>(std::min(std::max(value + 0.5f, 0.0f), 255.0f));
+    }
+  }
+
+  return target;
+}
+} // end of anonymous namespace
+
+std::vector<MipLevel> generate(const uint8_t* pixels, const int width, const int height,
+                               const MipFilter filter)
+{
+  std::vector<MipLevel> levels;
+
+  if (width <= 1 && height <= 1)
+  {
+    return levels;
+  }
+
+  const auto weights = filter == MipFilter::KAISER ? kaiser_weights() : std::vector<float>();
+
+  levels.reserve(static_cast<size_t>(level_count(width, height) - 1));
+
+  // Each level is filtered from the one above it
+  auto source = pixels;
+  auto source_width = width;
+  auto source_height = height;
+
+  while (source_width > 1 || source_height > 1)
+  {
+    if (filter == MipFilter::KAISER)
+    {
+      levels.push_back(kaiser_filter(source, source_width, source_height, weights));
+    }
+    else
+    {
+      levels.push_back(box_filter(source, source_width, source_height));
+    }
+
+    source = levels.back().pixels.data();
+    source_width = levels.back().width;
+    source_height = levels.back().height;
+  }
+
+  return levels;
+}
+
+int level_count(int width, int height)
+{
+  int count = 1;
+
+  while (width > 1 || height > 1)
+  {
+    width = std::max(1, width / 2);
+    height = std::max(1, height / 2);
+    count++;
+  }
+
+  return count;
+}
+} // end of namespace MipChain
+} // end of namespace BarelyEngine
@@ -0,0 +1,284 @@
+//
+// gfx/pixel_convert.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <cstring>
+#include <utility>
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSSE3__)
+#include <tmmintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include "pixel_convert.h"
+
+namespace BarelyEngine {
+namespace PixelConvert {
+namespace {
+/*
+ * Scalar versions of each kernel. These handle the whole run when SIMD isn't
+ * available, and the leftover pixels at the end of a run when it is.
+ */
+
+uint32_t load_pixel(const uint8_t* pixel)
+{
+  uint32_t value;
+  std::memcpy(&value, pixel, 4);
+  return value;
+}
+
+void store_pixel(uint8_t* pixel, const uint32_t value)
+{
+  std::memcpy(pixel, &value, 4);
+}
+
+void swap_red_blue_scalar(uint8_t* pixels, const size_t count)
+{
+  for (size_t i = 0; i < count; i++)
+  {
+    std::swap(pixels[i * 4], pixels[i * 4 + 2]);
+  }
+}
+
+void move_alpha_last_scalar(uint8_t* pixels, const size_t count)
+{
+  for (size_t i = 0; i < count; i++)
+  {
+    const auto value = load_pixel(&pixels[i * 4]);
+    // On little-endian machines the first byte is the lowest one, so rotate it
+    // round to the top
+    store_pixel(&pixels[i * 4], (value >> 8) | (value << 24));
+  }
+}
+
+/*
+ * Rounded division by 255 which is exact for every product of two bytes:
+ *
+ *    x / 255 = (x + 128 + ((x + 128) >> 8)) >> 8
+ *
+ * The SIMD versions use exactly the same arithmetic.
+ */
+uint8_t multiply(const uint32_t color, const uint32_t alpha)
+{
+  const uint32_t product = color * alpha + 128;
+  return static_cast<uint8_t>((product + (product >> 8)) >> 8);
+}
+
+void premultiply_alpha_scalar(uint8_t* pixels, const size_t count)
+{
+  for (size_t i = 0; i < count; i++)
+  {
+    auto pixel = &pixels[i * 4];
+    const auto alpha = pixel[3];
+
+    pixel[0] = multiply(pixel[0], alpha);
+    pixel[1] = multiply(pixel[1], alpha);
+    pixel[2] = multiply(pixel[2], alpha);
+  }
+}
+
+void expand_rgb_scalar(const uint8_t* source, uint8_t* target, const size_t count)
+{
+  for (size_t i = 0; i < count; i++)
+  {
+    target[i * 4] = source[i * 3];
+    target[i * 4 + 1] = source[i * 3 + 1];
+    target[i * 4 + 2] = source[i * 3 + 2];
+    target[i * 4 + 3] = 0xFF;
+  }
+}
+
+#if defined(__SSE2__)
+/*
+ * SSE2 helpers, working on 4 pixels at a time
+ */
+
+__m128i swap_red_blue_x4(const __m128i pixels)
+{
+  const auto green_alpha = _mm_set1_epi32(0xFF00FF00);
+  const auto low_byte = _mm_set1_epi32(0x000000FF);
+
+  const auto red_blue = _mm_andnot_si128(green_alpha, pixels);
+  const auto first = _mm_slli_epi32(_mm_and_si128(red_blue, low_byte), 16);
+  const auto third = _mm_srli_epi32(red_blue, 16);
+
+  return _mm_or_si128(_mm_and_si128(pixels, green_alpha), _mm_or_si128(first, third));
+}
+
+__m128i move_alpha_last_x4(const __m128i pixels)
+{
+  return _mm_or_si128(_mm_srli_epi32(pixels, 8), _mm_slli_epi32(pixels, 24));
+}
+
+/*
+ * Multiplies 2 pixels (widened to 16 bits per channel) by their alpha
+ */
+__m128i premultiply_x2(const __m128i pixels)
+{
+  // Broadcast each pixel's alpha across its 4 channels
+  auto alpha = _mm_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3));
+  alpha = _mm_shufflehi_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 3));
+
+  auto product = _mm_add_epi16(_mm_mullo_epi16(pixels, alpha), _mm_set1_epi16(128));
+  return _mm_srli_epi16(_mm_add_epi16(product, _mm_srli_epi16(product, 8)), 8);
+}
+
+__m128i premultiply_x4(const __m128i pixels)
+{
+  const auto zero = _mm_setzero_si128();
+  const auto alpha_mask = _mm_set1_epi32(0xFF000000);
+
+  const auto low = premultiply_x2(_mm_unpacklo_epi8(pixels, zero));
+  const auto high = premultiply_x2(_mm_unpackhi_epi8(pixels, zero));
+  const auto multiplied = _mm_packus_epi16(low, high);
+
+  // Keep the original alpha (multiplying it by itself would change it)
+  return _mm_or_si128(_mm_andnot_si128(alpha_mask, multiplied), _mm_and_si128(pixels, alpha_mask));
+}
+#endif
+
+#if defined(__AVX2__)
+/*
+ * AVX2 versions of the helpers above, working on 8 pixels at a time
+ */
+
+__m256i swap_red_blue_x8(const __m256i pixels)
+{
+  const auto mask = _mm256_setr_epi8(2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15,
+                                     2, 1, 0, 3, 6, 5, 4, 7, 10, 9, 8, 11, 14, 13, 12, 15);
+  return _mm256_shuffle_epi8(pixels, mask);
+}
+
+__m256i move_alpha_last_x8(const __m256i pixels)
+{
+  return _mm256_or_si256(_mm256_srli_epi32(pixels, 8), _mm256_slli_epi32(pixels, 24));
+}
+
+__m256i premultiply_x4_wide(const __m256i pixels)
+{
+  auto alpha = _mm256_shufflelo_epi16(pixels, _MM_SHUFFLE(3, 3, 3, 3));
+  alpha = _mm256_shufflehi_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 3));
+
+  auto product = _mm256_add_epi16(_mm256_mullo_epi16(pixels, alpha), _mm256_set1_epi16(128));
+  return _mm256_srli_epi16(_mm256_add_epi16(product, _mm256_srli_epi16(product, 8)), 8);
+}
+
+__m256i premultiply_x8(const __m256i pixels)
+{
+  const auto zero = _mm256_setzero_si256();
+  const auto alpha_mask = _mm256_set1_epi32(0xFF000000);
+
+  // Unpacking and packing both work within 128-bit lanes, so the pixels end
+  // up back where they started
+  const auto low = premultiply_x4_wide(_mm256_unpacklo_epi8(pixels, zero));
+  const auto high = premultiply_x4_wide(_mm256_unpackhi_epi8(pixels, zero));
+  const auto multiplied = _mm256_packus_epi16(low, high);
+
+  return _mm256_or_si256(_mm256_andnot_si256(alpha_mask, multiplied),
+                         _mm256_and_si256(pixels, alpha_mask));
+}
+#endif
+} // end of anonymous namespace
+
+void expand_rgb(const uint8_t* source, uint8_t* target, const size_t count)
+{
+  size_t i = 0;
+
+#if defined(__SSSE3__)
+  // Spread 4 pixels (12 bytes) out to 16 bytes, filling the gaps with alpha.
+  // Each load reads 16 bytes, so stop while there's still 4 bytes to spare.
+  const auto spread = _mm_setr_epi8(0, 1, 2, -1, 3, 4, 5, -1, 6, 7, 8, -1, 9, 10, 11, -1);
+  const auto alpha = _mm_set1_epi32(0xFF000000);
+
+  for (; i + 6 <= count; i += 4)
+  {
+    const auto pixels = _mm_loadu_si128(reinterpret_cast<const __m128i*>(&source[i * 3]));
+    const auto expanded = _mm_or_si128(_mm_shuffle_epi8(pixels, spread), alpha);
+
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&target[i * 4]), expanded);
+  }
+#endif
+
+  expand_rgb_scalar(&source[i * 3], &target[i * 4], count - i);
+}
+
+void expand_palette(const uint8_t* source, uint8_t* target, const size_t count,
+                    const uint32_t* palette)
+{
+  // A table lookup per pixel is already about as quick as it gets; gathers
+  // don't beat it for a 1KB table sitting in L1
+  for (size_t i = 0; i < count; i++)
+  {
+    store_pixel(&target[i * 4], palette[source[i]]);
+  }
+}
+
+void swap_red_blue(uint8_t* pixels, const size_t count)
+{
+  size_t i = 0;
+
+#if defined(__AVX2__)
+  for (; i + 8 <= count; i += 8)
+  {
+    auto address = reinterpret_cast<__m256i*>(&pixels[i * 4]);
+    _mm256_storeu_si256(address, swap_red_blue_x8(_mm256_loadu_si256(address)));
+  }
+#endif
+#if defined(__SSE2__)
+  for (; i + 4 <= count; i += 4)
+  {
+    auto address = reinterpret_cast<__m128i*>(&pixels[i * 4]);
+    _mm_storeu_si128(address, swap_red_blue_x4(_mm_loadu_si128(address)));
+  }
+#endif
+
+  swap_red_blue_scalar(&pixels[i * 4], count - i);
+}
+
+void move_alpha_last(uint8_t* pixels, const size_t count)
+{
+  size_t i = 0;
+
+#if defined(__AVX2__)
+  for (; i + 8 <= count; i += 8)
+  {
+    auto address = reinterpret_cast<__m256i*>(&pixels[i * 4]);
+    _mm256_storeu_si256(address, move_alpha_last_x8(_mm256_loadu_si256(address)));
+  }
+#endif
+#if defined(__SSE2__)
+  for (; i + 4 <= count; i += 4)
+  {
+    auto address = reinterpret_cast<__m128i*>(&pixels[i * 4]);
+    _mm_storeu_si128(address, move_alpha_last_x4(_mm_loadu_si128(address)));
+  }
+#endif
+
+  move_alpha_last_scalar(&pixels[i * 4], count - i);
+}
+
+void premultiply_alpha(uint8_t* pixels, const size_t count)
+{
+  size_t i = 0;
+
+#if defined(__AVX2__)
+  for (; i + 8 <= count; i += 8)
+  {
+    auto address = reinterpret_cast<__m256i*>(&pixels[i * 4]);
+    _mm256_storeu_si256(address, premultiply_x8(_mm256_loadu_si256(address)));
+  }
+#endif
+#if defined(__SSE2__)
+  for (; i + 4 <= count; i += 4)
+  {
+    auto address = reinterpret_cast<__m128i*>(&pixels[i * 4]);
+    _mm_storeu_si128(address, premultiply_x4(_mm_loadu_si128(address)));
+  }
+#endif
+
+  premultiply_alpha_scalar(&pixels[i * 4], count - i);
+}
+} // end of namespace PixelConvert
+} // end of namespace BarelyEngine
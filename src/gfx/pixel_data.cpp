@@ -3,10 +3,12 @@
 // Copyright (c) 2015 Adam Ransom
 //
 
+#include <cstring>
 #include <string>
 #include <SDL2/SDL.h>
 #include <OpenGL/gl3.h>
 #include "pixel_data.h"
+#include "pixel_convert.h"
 #include "logging.h"
 #include "exception.h"
 
@@ -22,27 +24,72 @@ PixelData::PixelData(SDL_Surface* surface)
   }
 }
 
-void PixelData::prepare()
+void PixelData::prepare(const bool premultiply_alpha)
 {
-  // Only perform conversion if necessary
-  if (format() == GL_FALSE)
+  if (prepared_)
   {
-    // Convert surface to ARGB format, so that we upload to OpenGL as BGRA
-    // (which is the 'optimal' upload format).
-    // See: https://www.opengl.org/wiki/Common_Mistakes#Texture_upload_and_pixel_reads
+    return;
+  }
+
+  prepared_ = true;
 
-    converted_surface_ = SDL_ConvertSurfaceFormat(surface_, SDL_PIXELFORMAT_ARGB8888, 0);
+  const auto pixel_format = surface_->format;
+  auto has_alpha = pixel_format->Amask != 0;
 
-    if (converted_surface_ == nullptr)
+  if (pixel_format->BitsPerPixel == 24)
+  {
+    // 3-byte pixels could be uploaded directly, but the driver would only end
+    // up expanding them itself (and more slowly)
+    converted_format_ = expand_rgb();
+  }
+  // Otherwise, only perform conversion if necessary
+  else if (format() == GL_FALSE)
+  {
+    if (pixel_format->BitsPerPixel == 32 && pixel_format->Amask == 0xFF)
+    {
+      converted_format_ = move_alpha_last();
+    }
+    else if (pixel_format->BitsPerPixel == 8 && pixel_format->palette != nullptr)
     {
-      BE_LOG_WARN("Texture couldn't be converted to usuable format and may appear incorrect"s +
-                  SDL_GetError());
+      converted_format_ = expand_palette();
+      has_alpha = true;
     }
+    else
+    {
+      // Convert surface to ARGB format, so that we upload to OpenGL as BGRA
+      // (which is the 'optimal' upload format).
+      // See: https://www.opengl.org/wiki/Common_Mistakes#Texture_upload_and_pixel_reads
+
+      converted_surface_ = SDL_ConvertSurfaceFormat(surface_, SDL_PIXELFORMAT_ARGB8888, 0);
+
+      if (converted_surface_ == nullptr)
+      {
+        BE_LOG_WARN("Texture couldn't be converted to usuable format and may appear incorrect"s +
+                    SDL_GetError());
+        return;
+      }
+
+      has_alpha = true;
+    }
+  }
+
+  if (premultiply_alpha && has_alpha)
+  {
+    const auto count = static_cast<size_t>(surface_->w) * static_cast<size_t>(surface_->h);
+
+    // Every prepared format with alpha has it as the last of 4 bytes, and
+    // 4-byte pixels never need padding at the end of a row
+    PixelConvert::premultiply_alpha(static_cast<uint8_t*>(pixels()), count);
   }
 }
 
 GLenum PixelData::format() const
 {
+  if (converted_format_ != GL_FALSE)
+  {
+    return converted_format_;
+  }
+
   SDL_PixelFormat* pixel_format;
 
   if (converted_surface_ != nullptr)
@@ -111,7 +158,11 @@ GLenum PixelData::format() const
 
 void* PixelData::pixels() const
 {
-  if (converted_surface_ != nullptr)
+  if (!buffer_.empty())
+  {
+    return const_cast<uint8_t*>(buffer_.data());
+  }
+  else if (converted_surface_ != nullptr)
   {
     return converted_surface_->pixels;
   }
@@ -125,4 +176,74 @@ PixelData::~PixelData()
 {
   SDL_FreeSurface(converted_surface_);
 }
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+GLenum PixelData::move_alpha_last()
+{
+  const auto width = static_cast<size_t>(surface_->w);
+  auto row = static_cast<uint8_t*>(surface_->pixels);
+
+  for (int y = 0; y < surface_->h; y++, row += surface_->pitch)
+  {
+    PixelConvert::move_alpha_last(row, width);
+  }
+
+  // SDL_PIXELFORMAT_RGBA8888 is stored as the bytes A, B, G, R, so becomes
+  // B, G, R, A (and SDL_PIXELFORMAT_BGRA8888 becomes R, G, B, A)
+  return surface_->format->Rmask > surface_->format->Bmask ? GL_BGRA : GL_RGBA;
+}
+
+GLenum PixelData::expand_rgb()
+{
+  const auto width = static_cast<size_t>(surface_->w);
+  const auto row = static_cast<const uint8_t*>(surface_->pixels);
+
+  buffer_.resize(width * static_cast<size_t>(surface_->h) * 4);
+
+  for (int y = 0; y < surface_->h; y++)
+  {
+    PixelConvert::expand_rgb(&row[y * surface_->pitch], &buffer_[y * width * 4], width);
+  }
+
+  return surface_->format->Rmask < surface_->format->Bmask ? GL_RGBA : GL_BGRA;
+}
+
+GLenum PixelData::expand_palette()
+{
+  const auto palette = surface_->format->palette;
+  const auto width = static_cast<size_t>(surface_->w);
+  const auto row = static_cast<const uint8_t*>(surface_->pixels);
+
+  // Build the palette as RGBA bytes, with unused entries transparent black
+  uint32_t colors[256] = {};
+
+  for (int i = 0; i < palette->ncolors && i < 256; i++)
+  {
+    const auto& color = palette->colors[i];
+    const uint8_t rgba[] = {color.r, color.g, color.b, color.a};
+
+    std::memcpy(&colors[i], rgba, sizeof(rgba));
+  }
+
+  uint32_t color_key;
+
+  if (SDL_GetColorKey(surface_, &color_key) == 0 && color_key < 256)
+  {
+    colors[color_key] = 0;
+  }
+
+  buffer_.resize(width * static_cast<size_t>(surface_->h) * 4);
+
+  for (int y = 0; y < surface_->h; y++)
+  {
+    PixelConvert::expand_palette(&row[y * surface_->pitch], &buffer_[y * width * 4], width, colors);
+  }
+
+  return GL_RGBA;
+}
 } // end of namespace BarleyEngine
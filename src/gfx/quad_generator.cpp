@@ -0,0 +1,227 @@
+//
+// gfx/quad_generator.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <cstring>
+#if defined(__AVX__)
+#include <immintrin.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#include "quad_generator.h"
+
+namespace BarelyEngine {
+namespace QuadGenerator {
+namespace {
+/*
+ * The values which make up a quad's vertices. Each is calculated once, with
+ * the same arithmetic as TexturedQuad (so the results are bit-identical), and
+ * the SIMD version below does the same operations 4 quads at a time.
+ */
+struct Corners
+{
+  float x1, y1, x2, y2, z, u1, v1, u2, v2, r, g, b;
+};
+
+Corners corners(const QuadArrays& quads, const size_t i)
+{
+  Corners c;
+
+  c.x1 = quads.x[i];
+  c.y1 = quads.y[i];
+  c.x2 = quads.x[i] + quads.w[i];
+  c.y2 = quads.y[i] + quads.h[i];
+  c.z = quads.layer != nullptr ? quads.layer[i] : 0;
+
+  if (quads.clip_x != nullptr)
+  {
+    c.u1 = quads.clip_x[i] / quads.texture_w[i];
+    c.v1 = quads.clip_y[i] / quads.texture_h[i];
+    c.u2 = (quads.clip_x[i] + quads.clip_w[i]) / quads.texture_w[i];
+    c.v2 = (quads.clip_y[i] + quads.clip_h[i]) / quads.texture_h[i];
+  }
+  else
+  {
+    c.u1 = 0;
+    c.v1 = 0;
+    c.u2 = 1;
+    c.v2 = 1;
+  }
+
+  if (quads.r != nullptr)
+  {
+    c.r = quads.r[i] / 255.0f;
+    c.g = quads.g[i] / 255.0f;
+    c.b = quads.b[i] / 255.0f;
+  }
+  else
+  {
+    c.r = 1;
+    c.g = 1;
+    c.b = 1;
+  }
+
+  return c;
+}
+
+void write_vertex(float* vertex, const float x, const float y, const Corners& c, const float u,
+                  const float v)
+{
+  const float values[] = {x, y, c.z, u, v, c.r, c.g, c.b};
+  std::memcpy(vertex, values, sizeof(values));
+}
+
+void generate_scalar(const QuadArrays& quads, const size_t first, float* vertices)
+{
+  for (auto i = first; i < quads.count; i++)
+  {
+    const auto c = corners(quads, i);
+    auto quad = &vertices[i * kFloatsPerQuad];
+
+    write_vertex(&quad[0], c.x1, c.y1, c, c.u1, c.v1);  // Top-Left
+    write_vertex(&quad[8], c.x2, c.y1, c, c.u2, c.v1);  // Top-Right
+    write_vertex(&quad[16], c.x1, c.y2, c, c.u1, c.v2); // Bottom-Left
+    write_vertex(&quad[24], c.x2, c.y1, c, c.u2, c.v1); // Top-Right
+    write_vertex(&quad[32], c.x1, c.y2, c, c.u1, c.v2); // Bottom-Left
+    write_vertex(&quad[40], c.x2, c.y2, c, c.u2, c.v2); // Bottom-Right
+  }
+}
+
+#if defined(__SSE2__)
+/*
+ * SSE2 helpers, working on 4 quads at a time
+ */
+
+/*
+ * Converts 4 bytes to 4 floats divided by 255
+ */
+__m128 unit_x4(const uint8_t* bytes)
+{
+  int32_t packed;
+  std::memcpy(&packed, bytes, sizeof(packed));
+
+  const auto zero = _mm_setzero_si128();
+  const auto widened = _mm_unpacklo_epi16(_mm_unpacklo_epi8(_mm_cvtsi32_si128(packed), zero),
+                                          zero);
+
+  return _mm_div_ps(_mm_cvtepi32_ps(widened), _mm_set1_ps(255.0f));
+}
+
+__m128i load_x4(const int32_t* values)
+{
+  return _mm_loadu_si128(reinterpret_cast<const __m128i*>(values));
+}
+
+/*
+ * Stores the two halves of a vertex ([x, y, z, u] and [v, r, g, b])
+ */
+void store_vertex(float* vertex, const __m128 low, const __m128 high)
+{
+#if defined(__AVX__)
+  _mm256_storeu_ps(vertex, _mm256_insertf128_ps(_mm256_castps128_ps256(low), high, 1));
+#else
+  _mm_storeu_ps(vertex, low);
+  _mm_storeu_ps(vertex + 4, high);
+#endif
+}
+
+size_t generate_x4(const QuadArrays& quads, float* vertices)
+{
+  size_t i = 0;
+
+  for (; i + 4 <= quads.count; i += 4)
+  {
+    const auto x1 = _mm_loadu_ps(&quads.x[i]);
+    const auto y1 = _mm_loadu_ps(&quads.y[i]);
+    const auto x2 = _mm_add_ps(x1, _mm_loadu_ps(&quads.w[i]));
+    const auto y2 = _mm_add_ps(y1, _mm_loadu_ps(&quads.h[i]));
+    const auto z = quads.layer != nullptr ? _mm_loadu_ps(&quads.layer[i]) : _mm_setzero_ps();
+
+    __m128 u1, v1, u2, v2;
+
+    if (quads.clip_x != nullptr)
+    {
+      const auto clip_x = load_x4(&quads.clip_x[i]);
+      const auto clip_y = load_x4(&quads.clip_y[i]);
+      const auto texture_w = _mm_loadu_ps(&quads.texture_w[i]);
+      const auto texture_h = _mm_loadu_ps(&quads.texture_h[i]);
+
+      u1 = _mm_div_ps(_mm_cvtepi32_ps(clip_x), texture_w);
+      v1 = _mm_div_ps(_mm_cvtepi32_ps(clip_y), texture_h);
+      u2 = _mm_div_ps(_mm_cvtepi32_ps(_mm_add_epi32(clip_x, load_x4(&quads.clip_w[i]))),
+                      texture_w);
+      v2 = _mm_div_ps(_mm_cvtepi32_ps(_mm_add_epi32(clip_y, load_x4(&quads.clip_h[i]))),
+                      texture_h);
+    }
+    else
+    {
+      u1 = v1 = _mm_setzero_ps();
+      u2 = v2 = _mm_set1_ps(1);
+    }
+
+    __m128 r, g, b;
+
+    if (quads.r != nullptr)
+    {
+      r = unit_x4(&quads.r[i]);
+      g = unit_x4(&quads.g[i]);
+      b = unit_x4(&quads.b[i]);
+    }
+    else
+    {
+      r = g = b = _mm_set1_ps(1);
+    }
+
+    // Transpose each set of 4 values into the halves of each quad's vertices
+    auto top_left = x1, top_left_y = y1, top_left_z = z, top_left_u = u1;
+    auto top_right = x2, top_right_y = y1, top_right_z = z, top_right_u = u2;
+    auto bottom_left = x1, bottom_left_y = y2, bottom_left_z = z, bottom_left_u = u1;
+    auto bottom_right = x2, bottom_right_y = y2, bottom_right_z = z, bottom_right_u = u2;
+    auto top = v1, top_r = r, top_g = g, top_b = b;
+    auto bottom = v2, bottom_r = r, bottom_g = g, bottom_b = b;
+
+    _MM_TRANSPOSE4_PS(top_left, top_left_y, top_left_z, top_left_u);
+    _MM_TRANSPOSE4_PS(top_right, top_right_y, top_right_z, top_right_u);
+    _MM_TRANSPOSE4_PS(bottom_left, bottom_left_y, bottom_left_z, bottom_left_u);
+    _MM_TRANSPOSE4_PS(bottom_right, bottom_right_y, bottom_right_z, bottom_right_u);
+    _MM_TRANSPOSE4_PS(top, top_r, top_g, top_b);
+    _MM_TRANSPOSE4_PS(bottom, bottom_r, bottom_g, bottom_b);
+
+    const __m128 top_lefts[] = {top_left, top_left_y, top_left_z, top_left_u};
+    const __m128 top_rights[] = {top_right, top_right_y, top_right_z, top_right_u};
+    const __m128 bottom_lefts[] = {bottom_left, bottom_left_y, bottom_left_z, bottom_left_u};
+    const __m128 bottom_rights[] = {bottom_right, bottom_right_y, bottom_right_z, bottom_right_u};
+    const __m128 tops[] = {top, top_r, top_g, top_b};
+    const __m128 bottoms[] = {bottom, bottom_r, bottom_g, bottom_b};
+
+    for (size_t quad = 0; quad < 4; quad++)
+    {
+      auto vertex = &vertices[(i + quad) * kFloatsPerQuad];
+
+      store_vertex(&vertex[0], top_lefts[quad], tops[quad]);
+      store_vertex(&vertex[8], top_rights[quad], tops[quad]);
+      store_vertex(&vertex[16], bottom_lefts[quad], bottoms[quad]);
+      store_vertex(&vertex[24], top_rights[quad], tops[quad]);
+      store_vertex(&vertex[32], bottom_lefts[quad], bottoms[quad]);
+      store_vertex(&vertex[40], bottom_rights[quad], bottoms[quad]);
+    }
+  }
+
+  return i;
+}
+#endif
+} // end of anonymous namespace
+
+void generate(const QuadArrays& quads, float* vertices)
+{
+  size_t i = 0;
+
+#if defined(__SSE2__)
+  i = generate_x4(quads, vertices);
+#endif
+
+  generate_scalar(quads, i, vertices);
+}
+} // end of namespace QuadGenerator
+} // end of namespace BarelyEngine
@@ -0,0 +1,225 @@
+//
+// gfx/render_command_list.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <algorithm>
+#include "render_command_list.h"
+#include "render_element.h"
+#include "render_stats.h"
+#include "vertex_batcher.h"
+
+namespace BarelyEngine {
+void RenderBucket::clear()
+{
+  commands_.clear();
+  vertices_.clear();
+  sorted_ = true;
+  culled_count_ = 0;
+}
+
+void RenderBucket::set_viewport(const Rect& viewport)
+{
+  viewport_ = viewport;
+  cull_ = true;
+}
+
+void RenderBucket::draw(const RenderElement* render_element)
+{
+  if (!visible(render_element->bounds()))
+  {
+    return;
+  }
+
+  const auto& vertices = render_element->vertices();
+
+  draw(render_element->texture(), render_element->id(), vertices.data(), vertices.size());
+}
+
+void RenderBucket::draw(const Texture* texture, const uint64_t key, const float* vertices,
+                        const size_t count)
+{
+  if (count == 0)
+  {
+    return;
+  }
+
+  if (!commands_.empty() && key < commands_.back().key)
+  {
+    sorted_ = false;
+  }
+
+  commands_.push_back({key, texture, vertices_.size(), count});
+  vertices_.insert(vertices_.end(), vertices, vertices + count);
+}
+
+void RenderBucket::draw_quads(const Texture* texture, const uint64_t key, const QuadArrays& quads)
+{
+  const auto first = vertices_.size();
+
+  // Room for every quad, shrunk back to those which were generated
+  vertices_.resize(first + quads.count * QuadGenerator::kFloatsPerQuad);
+
+  const auto generated = QuadGenerator::generate_visible(
+    quads, &vertices_[first], [this](const Rect& bounds) { return visible(bounds); });
+  const auto count = generated * QuadGenerator::kFloatsPerQuad;
+
+  vertices_.resize(first + count);
+
+  if (count == 0)
+  {
+    return;
+  }
+
+  if (!commands_.empty() && key < commands_.back().key)
+  {
+    sorted_ = false;
+  }
+
+  commands_.push_back({key, texture, first, count});
+}
+
+void RenderBucket::sort()
+{
+  if (sorted_)
+  {
+    return;
+  }
+
+  std::stable_sort(commands_.begin(), commands_.end(),
+                   [](const RenderCommand& a, const RenderCommand& b) { return a.key < b.key; });
+  sorted_ = true;
+}
+
+RenderCommandList::RenderCommandList(const size_t bucket_count)
+{
+  for (size_t i = 0; i < bucket_count; i++)
+  {
+    buckets_.push_back(std::make_unique<RenderBucket>());
+  }
+}
+
+void RenderCommandList::clear()
+{
+  for (auto& bucket : buckets_)
+  {
+    bucket->clear();
+  }
+
+  merged_.clear();
+}
+
+void RenderCommandList::set_viewport(const Rect& viewport)
+{
+  for (auto& bucket : buckets_)
+  {
+    bucket->set_viewport(viewport);
+  }
+}
+
+void RenderCommandList::clear_viewport()
+{
+  for (auto& bucket : buckets_)
+  {
+    bucket->clear_viewport();
+  }
+}
+
+void RenderCommandList::merge()
+{
+  merged_.clear();
+  heap_.clear();
+
+  size_t total = 0;
+
+  for (uint32_t i = 0; i < buckets_.size(); i++)
+  {
+    buckets_[i]->sort();
+    total += buckets_[i]->size();
+
+    if (buckets_[i]->size() > 0)
+    {
+      heap_.push_back({i, 0});
+    }
+  }
+
+  merged_.reserve(total);
+
+  // A min-heap on the key of each bucket's next command, with ties going to
+  // the lower bucket
+  const auto later = [this](const Entry& a, const Entry& b)
+  {
+    const auto a_key = buckets_[a.bucket]->command(a.command).key;
+    const auto b_key = buckets_[b.bucket]->command(b.command).key;
+
+    return a_key > b_key || (a_key == b_key && a.bucket > b.bucket);
+  };
+
+  std::make_heap(heap_.begin(), heap_.end(), later);
+
+  while (!heap_.empty())
+  {
+    std::pop_heap(heap_.begin(), heap_.end(), later);
+    auto& next = heap_.back();
+    merged_.push_back(next);
+
+    if (++next.command < buckets_[next.bucket]->size())
+    {
+      std::push_heap(heap_.begin(), heap_.end(), later);
+    }
+    else
+    {
+      heap_.pop_back();
+    }
+  }
+}
+
+void RenderCommandList::submit(VertexBatcher& batcher)
+{
+  merge();
+
+  // The buckets count their own, as RenderStats is only safe on this thread
+  for (const auto& bucket : buckets_)
+  {
+    RenderStats::frame().culled += static_cast<uint32_t>(bucket->culled_count());
+  }
+
+  for (size_t i = 0; i < merged_.size(); i++)
+  {
+    const auto& command = this->command(i);
+    batcher.draw(command.texture, command.key, vertices(i), command.count);
+  }
+}
+
+const RenderCommand& RenderCommandList::command(const size_t index) const
+{
+  const auto& entry = merged_[index];
+  return buckets_[entry.bucket]->command(entry.command);
+}
+
+const float* RenderCommandList::vertices(const size_t index) const
+{
+  const auto& entry = merged_[index];
+  const auto& bucket = *buckets_[entry.bucket];
+
+  return bucket.vertices(bucket.command(entry.command));
+}
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+bool RenderBucket::visible(const Rect& bounds)
+{
+  if (!cull_ || bounds.intersects(viewport_))
+  {
+    return true;
+  }
+
+  culled_count_++;
+
+  return false;
+}
+} // end of namespace BarelyEngine
@@ -0,0 +1,33 @@
+//
+// gfx/render_stats.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include "render_stats.h"
+#include "frame_profiler.h"
+
+namespace BarelyEngine {
+RenderStats RenderStats::frame_;
+
+void RenderStats::report(FrameProfiler& profiler) const
+{
+  // The profiler keys samples by the name's pointer, so the names must always
+  // be these same literals
+  profiler.add_sample("Draw calls", draw_calls);
+  profiler.add_sample("Vertices", vertices);
+  profiler.add_sample("Flushes (texture change)", flush_count(FlushReason::TEXTURE_CHANGE));
+  profiler.add_sample("Flushes (batch full)", flush_count(FlushReason::BATCH_FULL));
+  profiler.add_sample("Flushes (end)", flush_count(FlushReason::END));
+  profiler.add_sample("Vertex KB uploaded", vertex_bytes / 1024.0f);
+  profiler.add_sample("Texture KB uploaded", texture_bytes / 1024.0f);
+  profiler.add_sample("Texture binds", texture_binds);
+  profiler.add_sample("Texture binds skipped", texture_binds_skipped);
+  profiler.add_sample("Culled", culled);
+}
+
+void RenderStats::end_frame(FrameProfiler& profiler)
+{
+  report(profiler);
+  reset();
+}
+} // end of namespace BarelyEngine
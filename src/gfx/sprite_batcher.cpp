@@ -0,0 +1,191 @@
+//
+// gfx/sprite_batcher.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <cmath>
+#include <cstddef>
+#include "sprite_batcher.h"
+#include "texture.h"
+
+namespace BarelyEngine {
+namespace {
+/// The corners of the unit quad, drawn as a triangle strip
+const float kQuadCorners[] = {0, 0, 1, 0, 0, 1, 1, 1};
+
+/**
+ * @brief Converts a texture coordinate (0 - 1) to 16 bits
+ */
+uint16_t normalise(const float coordinate)
+{
+  return static_cast<uint16_t>(std::lround(std::fmin(std::fmax(coordinate, 0.0f), 1.0f) * 65535));
+}
+
+/**
+ * @brief Sets up an instance attribute which advances once per sprite
+ */
+void instance_attribute(const GLuint location, const GLint size, const GLenum type,
+                        const GLboolean normalised, const size_t offset)
+{
+  glEnableVertexAttribArray(location);
+  glVertexAttribPointer(location, size, type, normalised, sizeof(SpriteInstance),
+                        reinterpret_cast<const void*>(offset));
+  glVertexAttribDivisor(location, 1);
+}
+} // end of anonymous namespace
+
+SpriteInstance make_sprite(const float x, const float y, const float w, const float h,
+                           const uint16_t depth, const Texture* texture, const Color color)
+{
+  SpriteInstance sprite;
+
+  sprite.x = x;
+  sprite.y = y;
+  sprite.w = w;
+  sprite.h = h;
+  sprite.u0 = 0;
+  sprite.v0 = 0;
+  sprite.u1 = 65535;
+  sprite.v1 = 65535;
+  sprite.r = color.r();
+  sprite.g = color.g();
+  sprite.b = color.b();
+  sprite.a = 255; // TexturedQuad doesn't tint with alpha either
+  sprite.texture_layer = static_cast<uint16_t>(texture != nullptr ? texture->layer() : 0);
+  sprite.depth = depth;
+
+  return sprite;
+}
+
+SpriteInstance make_sprite(const float x, const float y, const float w, const float h,
+                           const int clip_x, const int clip_y, const int clip_w, const int clip_h,
+                           const uint16_t depth, const Texture* texture, const Color color)
+{
+  const float texture_w = static_cast<float>(texture->width());
+  const float texture_h = static_cast<float>(texture->height());
+
+  auto sprite = make_sprite(x, y, w, h, depth, texture, color);
+  sprite.u0 = normalise(clip_x / texture_w);
+  sprite.v0 = normalise(clip_y / texture_h);
+  sprite.u1 = normalise((clip_x + clip_w) / texture_w);
+  sprite.v1 = normalise((clip_y + clip_h) / texture_h);
+
+  return sprite;
+}
+
+SpriteBatcher::SpriteBatcher(const size_t max_sprites)
+  : max_sprites_(max_sprites)
+{
+  sprites_.reserve(max_sprites_);
+
+  glGenVertexArrays(1, &vao_);
+  glBindVertexArray(vao_);
+
+  // The unit quad, shared by every sprite
+  glGenBuffers(1, &quad_vbo_);
+  glBindBuffer(GL_ARRAY_BUFFER, quad_vbo_);
+  glBufferData(GL_ARRAY_BUFFER, sizeof(kQuadCorners), kQuadCorners, GL_STATIC_DRAW);
+  glEnableVertexAttribArray(0);
+  glVertexAttribPointer(0, 2, GL_FLOAT, GL_FALSE, 0, nullptr);
+
+  // The instance attributes, refilled every batch
+  glGenBuffers(1, &instance_vbo_);
+  glBindBuffer(GL_ARRAY_BUFFER, instance_vbo_);
+  glBufferData(GL_ARRAY_BUFFER, max_sprites_ * sizeof(SpriteInstance), nullptr, GL_STREAM_DRAW);
+
+  instance_attribute(1, 4, GL_FLOAT, GL_FALSE, offsetof(SpriteInstance, x));
+  instance_attribute(2, 4, GL_UNSIGNED_SHORT, GL_TRUE, offsetof(SpriteInstance, u0));
+  instance_attribute(3, 4, GL_UNSIGNED_BYTE, GL_TRUE, offsetof(SpriteInstance, r));
+  instance_attribute(4, 2, GL_UNSIGNED_SHORT, GL_FALSE, offsetof(SpriteInstance, texture_layer));
+
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+  glBindVertexArray(0);
+}
+
+SpriteBatcher::~SpriteBatcher()
+{
+  glDeleteBuffers(1, &instance_vbo_);
+  glDeleteBuffers(1, &quad_vbo_);
+  glDeleteVertexArrays(1, &vao_);
+}
+
+void SpriteBatcher::begin()
+{
+  draw_count_ = 0;
+}
+
+void SpriteBatcher::draw(const Texture* texture, const SpriteInstance& sprite)
+{
+  // Layers of the same texture array can share a batch
+  const auto new_texture = !sprites_.empty() && !Texture::same(texture, current_texture_);
+
+  if (new_texture)
+  {
+    flush(FlushReason::TEXTURE_CHANGE);
+  }
+  else if (sprites_.size() >= max_sprites_)
+  {
+    flush(FlushReason::BATCH_FULL);
+  }
+
+  current_texture_ = texture;
+  sprites_.push_back(sprite);
+}
+
+void SpriteBatcher::end()
+{
+  flush(FlushReason::END);
+  current_texture_ = nullptr;
+  last_bound_texture_ = nullptr;
+}
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+void SpriteBatcher::flush(const FlushReason reason)
+{
+  if (sprites_.empty())
+  {
+    return;
+  }
+
+  auto& stats = RenderStats::frame();
+  const auto texture = current_texture_;
+
+  if (texture != nullptr)
+  {
+    if (Texture::same(texture, last_bound_texture_))
+    {
+      stats.texture_binds_skipped++;
+    }
+    else
+    {
+      if (last_bound_texture_ != nullptr) last_bound_texture_->unbind();
+
+      texture->bind();
+      last_bound_texture_ = texture;
+    }
+  }
+
+  // Orphan the buffer, so the driver doesn't wait for the last batch's draw
+  glBindBuffer(GL_ARRAY_BUFFER, instance_vbo_);
+  glBufferData(GL_ARRAY_BUFFER, max_sprites_ * sizeof(SpriteInstance), nullptr, GL_STREAM_DRAW);
+  glBufferSubData(GL_ARRAY_BUFFER, 0, sprites_.size() * sizeof(SpriteInstance), sprites_.data());
+  glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+  glBindVertexArray(vao_);
+  glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, static_cast<GLsizei>(sprites_.size()));
+  glBindVertexArray(0);
+
+  stats.add_flush(reason);
+  stats.draw_calls++;
+  stats.vertices += static_cast<uint32_t>(sprites_.size() * 4);
+  stats.vertex_bytes += sprites_.size() * sizeof(SpriteInstance);
+
+  sprites_.clear();
+  draw_count_++;
+}
+} // end of namespace BarelyEngine
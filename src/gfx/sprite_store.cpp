@@ -0,0 +1,382 @@
+//
+// gfx/sprite_store.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <algorithm>
+#include <functional>
+#include <numeric>
+#include "sprite_store.h"
+#include "render_element.h"
+#include "sprite_batcher.h"
+#include "texture.h"
+#include "vertex_batcher.h"
+
+namespace BarelyEngine {
+namespace {
+/**
+ * @brief Reorders an array so the element at `order[i]` ends up at `i`
+ */
+template <typename T>
+void permute(std::vector<T>& values, const std::vector<uint32_t>& order)
+{
+  std::vector<T> permuted;
+  permuted.reserve(values.size());
+
+  for (const auto index : order)
+  {
+    permuted.push_back(values[index]);
+  }
+
+  values.swap(permuted);
+}
+
+/**
+ * @brief Moves the last element of an array into an index, then removes the
+ *        last element
+ */
+template <typename T>
+void erase_unordered(std::vector<T>& values, const size_t index)
+{
+  values[index] = values.back();
+  values.pop_back();
+}
+} // end of anonymous namespace
+
+const uint32_t SpriteStore::kRemoved;
+
+SpriteStore::Id SpriteStore::add(const Sprite& sprite)
+{
+  const auto id = next_id();
+  push_back(id, sprite);
+  sorted_ = false;
+
+  return id;
+}
+
+void SpriteStore::add(const std::vector<Sprite>& sprites, std::vector<Id>& ids)
+{
+  const auto total = size() + sprites.size();
+
+  for (auto array : {&x_, &y_, &w_, &h_, &texture_w_, &texture_h_, &texture_layer_})
+  {
+    array->reserve(total);
+  }
+
+  for (auto array : {&clip_x_, &clip_y_, &clip_w_, &clip_h_})
+  {
+    array->reserve(total);
+  }
+
+  for (auto array : {&r_, &g_, &b_, &depth_})
+  {
+    array->reserve(total);
+  }
+
+  textures_.reserve(total);
+  sort_keys_.reserve(total);
+  ids_.reserve(total);
+  ids.reserve(ids.size() + sprites.size());
+
+  for (const auto& sprite : sprites)
+  {
+    const auto id = next_id();
+    push_back(id, sprite);
+    ids.push_back(id);
+  }
+
+  sorted_ = false;
+}
+
+void SpriteStore::remove(const Id id)
+{
+  if (!contains(id))
+  {
+    return;
+  }
+
+  swap_and_pop(indices_[id]);
+  indices_[id] = kRemoved;
+  free_ids_.push_back(id);
+  sorted_ = false;
+}
+
+void SpriteStore::remove(const std::vector<Id>& ids)
+{
+  std::vector<uint32_t> indices;
+  indices.reserve(ids.size());
+
+  for (const auto id : ids)
+  {
+    // Marking each id as removed straight away also skips repeats
+    if (contains(id))
+    {
+      indices.push_back(indices_[id]);
+      indices_[id] = kRemoved;
+      free_ids_.push_back(id);
+    }
+  }
+
+  // Removing from the back first means the sprites swapped into the gaps are
+  // never ones which are still to be removed
+  std::sort(indices.begin(), indices.end(), std::greater<uint32_t>());
+
+  for (const auto index : indices)
+  {
+    swap_and_pop(index);
+  }
+
+  sorted_ = false;
+}
+
+void SpriteStore::clear()
+{
+  x_.clear();
+  y_.clear();
+  w_.clear();
+  h_.clear();
+  clip_x_.clear();
+  clip_y_.clear();
+  clip_w_.clear();
+  clip_h_.clear();
+  texture_w_.clear();
+  texture_h_.clear();
+  r_.clear();
+  g_.clear();
+  b_.clear();
+  texture_layer_.clear();
+  depth_.clear();
+  textures_.clear();
+  sort_keys_.clear();
+  ids_.clear();
+  indices_.clear();
+  free_ids_.clear();
+  sorted_ = true;
+}
+
+void SpriteStore::set_position(const Id id, const float x, const float y)
+{
+  if (!contains(id))
+  {
+    return;
+  }
+
+  const auto index = indices_[id];
+
+  x_[index] = x;
+  y_[index] = y;
+}
+
+void SpriteStore::set_color(const Id id, const Color color)
+{
+  if (!contains(id))
+  {
+    return;
+  }
+
+  const auto index = indices_[id];
+
+  r_[index] = color.r();
+  g_[index] = color.g();
+  b_[index] = color.b();
+}
+
+void SpriteStore::sort()
+{
+  if (sorted_)
+  {
+    return;
+  }
+
+  std::vector<uint32_t> order(size());
+  std::iota(order.begin(), order.end(), 0);
+  std::stable_sort(order.begin(), order.end(), [this](const uint32_t a, const uint32_t b)
+  {
+    return sort_keys_[a] < sort_keys_[b];
+  });
+
+  permute(x_, order);
+  permute(y_, order);
+  permute(w_, order);
+  permute(h_, order);
+  permute(clip_x_, order);
+  permute(clip_y_, order);
+  permute(clip_w_, order);
+  permute(clip_h_, order);
+  permute(texture_w_, order);
+  permute(texture_h_, order);
+  permute(r_, order);
+  permute(g_, order);
+  permute(b_, order);
+  permute(texture_layer_, order);
+  permute(depth_, order);
+  permute(textures_, order);
+  permute(sort_keys_, order);
+  permute(ids_, order);
+
+  for (uint32_t index = 0; index < ids_.size(); index++)
+  {
+    indices_[ids_[index]] = index;
+  }
+
+  sorted_ = true;
+}
+
+void SpriteStore::draw(VertexBatcher& batcher)
+{
+  sort();
+
+  const auto batch_quads =
+    std::max<size_t>(batcher.capacity() / QuadGenerator::kFloatsPerQuad, 1);
+
+  for (size_t first = 0; first < size();)
+  {
+    // Generate each run of sprites with the same key (in batch-sized chunks)
+    auto end = first + 1;
+
+    while (end < size() && end - first < batch_quads && sort_keys_[end] == sort_keys_[first])
+    {
+      end++;
+    }
+
+    vertices_.resize((end - first) * QuadGenerator::kFloatsPerQuad);
+
+    const auto generated = QuadGenerator::generate_visible(
+      quads(first, end - first), vertices_.data(),
+      [&batcher](const Rect& bounds) { return batcher.visible(bounds); });
+
+    if (generated > 0)
+    {
+      batcher.draw(textures_[first], sort_keys_[first], vertices_.data(),
+                   generated * QuadGenerator::kFloatsPerQuad);
+    }
+
+    first = end;
+  }
+}
+
+void SpriteStore::draw(SpriteBatcher& batcher)
+{
+  sort();
+
+  for (size_t i = 0; i < size(); i++)
+  {
+    const auto texture = textures_[i];
+    const Color color{r_[i], g_[i], b_[i]};
+
+    if (texture != nullptr)
+    {
+      batcher.draw(texture, make_sprite(x_[i], y_[i], w_[i], h_[i], clip_x_[i], clip_y_[i],
+                                        clip_w_[i], clip_h_[i], depth_[i], texture, color));
+    }
+    else
+    {
+      batcher.draw(texture, make_sprite(x_[i], y_[i], w_[i], h_[i], depth_[i], texture, color));
+    }
+  }
+}
+
+QuadArrays SpriteStore::quads(const size_t first, const size_t count) const
+{
+  QuadArrays quads;
+
+  quads.count = count;
+  quads.x = &x_[first];
+  quads.y = &y_[first];
+  quads.w = &w_[first];
+  quads.h = &h_[first];
+  quads.clip_x = &clip_x_[first];
+  quads.clip_y = &clip_y_[first];
+  quads.clip_w = &clip_w_[first];
+  quads.clip_h = &clip_h_[first];
+  quads.texture_w = &texture_w_[first];
+  quads.texture_h = &texture_h_[first];
+  quads.r = &r_[first];
+  quads.g = &g_[first];
+  quads.b = &b_[first];
+  quads.layer = &texture_layer_[first];
+
+  return quads;
+}
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+void SpriteStore::push_back(const Id id, const Sprite& sprite)
+{
+  const auto texture = sprite.texture;
+  const auto texture_w = texture != nullptr ? static_cast<float>(texture->width()) : 1.0f;
+  const auto texture_h = texture != nullptr ? static_cast<float>(texture->height()) : 1.0f;
+  const auto whole = sprite.clip_w == 0 || sprite.clip_h == 0;
+
+  x_.push_back(sprite.x);
+  y_.push_back(sprite.y);
+  w_.push_back(sprite.w);
+  h_.push_back(sprite.h);
+
+  // A clip of the whole texture gives exactly the same UVs (0 and 1) as
+  // TexturedQuad's whole texture constructor
+  clip_x_.push_back(whole ? 0 : sprite.clip_x);
+  clip_y_.push_back(whole ? 0 : sprite.clip_y);
+  clip_w_.push_back(whole ? static_cast<int32_t>(texture_w) : sprite.clip_w);
+  clip_h_.push_back(whole ? static_cast<int32_t>(texture_h) : sprite.clip_h);
+  texture_w_.push_back(texture_w);
+  texture_h_.push_back(texture_h);
+
+  r_.push_back(sprite.color.r());
+  g_.push_back(sprite.color.g());
+  b_.push_back(sprite.color.b());
+  texture_layer_.push_back(texture != nullptr ? static_cast<float>(texture->layer()) : 0);
+  depth_.push_back(sprite.depth);
+  textures_.push_back(texture);
+  sort_keys_.push_back(RenderElement::sort_key(sprite.layer, sprite.depth, texture));
+
+  indices_[id] = static_cast<uint32_t>(ids_.size());
+  ids_.push_back(id);
+}
+
+void SpriteStore::swap_and_pop(const size_t index)
+{
+  // Point the last sprite's id at the index it's moving to (unless it's the
+  // one being removed)
+  if (index + 1 < ids_.size())
+  {
+    indices_[ids_.back()] = static_cast<uint32_t>(index);
+  }
+
+  erase_unordered(x_, index);
+  erase_unordered(y_, index);
+  erase_unordered(w_, index);
+  erase_unordered(h_, index);
+  erase_unordered(clip_x_, index);
+  erase_unordered(clip_y_, index);
+  erase_unordered(clip_w_, index);
+  erase_unordered(clip_h_, index);
+  erase_unordered(texture_w_, index);
+  erase_unordered(texture_h_, index);
+  erase_unordered(r_, index);
+  erase_unordered(g_, index);
+  erase_unordered(b_, index);
+  erase_unordered(texture_layer_, index);
+  erase_unordered(depth_, index);
+  erase_unordered(textures_, index);
+  erase_unordered(sort_keys_, index);
+  erase_unordered(ids_, index);
+}
+
+SpriteStore::Id SpriteStore::next_id()
+{
+  if (!free_ids_.empty())
+  {
+    const auto id = free_ids_.back();
+    free_ids_.pop_back();
+    return id;
+  }
+
+  indices_.push_back(0);
+  return static_cast<Id>(indices_.size() - 1);
+}
+} // end of namespace BarelyEngine
@@ -0,0 +1,163 @@
+//
+// gfx/static_batch.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <algorithm>
+#include "static_batch.h"
+#include "content_hash.h"
+#include "render_element.h"
+#include "render_stats.h"
+#include "texture.h"
+
+namespace BarelyEngine {
+StaticBatch::StaticBatch(const GLuint draw_mode, const BarelyGL::VertexAttributeArray attributes)
+  : draw_mode_(draw_mode)
+  , attributes_(std::move(attributes))
+{
+  // Set up the VAO's state once, as with VertexBatcher
+  vao_.bind();
+  vbo_.bind();
+  attributes_.enable();
+  vbo_.unbind();
+  vao_.unbind();
+}
+
+void StaticBatch::add(const RenderElement* render_element)
+{
+  elements_.push_back(render_element);
+  dirty_ = true;
+}
+
+void StaticBatch::remove(const RenderElement* render_element)
+{
+  const auto end = std::remove(elements_.begin(), elements_.end(), render_element);
+
+  if (end != elements_.end())
+  {
+    elements_.erase(end, elements_.end());
+    dirty_ = true;
+  }
+}
+
+void StaticBatch::clear()
+{
+  elements_.clear();
+  dirty_ = true;
+}
+
+void StaticBatch::draw()
+{
+  if (dirty_)
+  {
+    bake();
+  }
+
+  draw_count_ = 0;
+
+  if (ranges_.empty())
+  {
+    return;
+  }
+
+  const Texture* last_bound_texture = nullptr;
+
+  vao_.bind();
+
+  for (const auto& range : ranges_)
+  {
+    const auto texture = range.texture;
+
+    if (texture != nullptr && !Texture::same(texture, last_bound_texture))
+    {
+      if (last_bound_texture != nullptr) last_bound_texture->unbind();
+
+      texture->bind();
+      last_bound_texture = texture;
+    }
+
+    glDrawArrays(draw_mode_, range.first, range.count);
+    draw_count_++;
+    RenderStats::frame().draw_calls++;
+    RenderStats::frame().vertices += static_cast<uint32_t>(range.count);
+  }
+
+  vao_.unbind();
+}
+
+uint64_t StaticBatch::hash(const std::vector<const RenderElement*>& elements)
+{
+  uint64_t hash = ContentHash::combine(0, elements.size());
+
+  for (const auto element : elements)
+  {
+    hash = ContentHash::combine(hash, element->id());
+    hash = ContentHash::hash(element->vertices().data(),
+                             element->vertices().size() * sizeof(float), hash);
+  }
+
+  return hash;
+}
+
+void StaticBatch::build_ranges(const std::vector<const RenderElement*>& elements,
+                               const size_t stride, std::vector<float>& vertices,
+                               std::vector<Range>& ranges)
+{
+  vertices.clear();
+  ranges.clear();
+
+  for (const auto element : elements)
+  {
+    const auto first = static_cast<GLint>(vertices.size() / stride);
+    const auto count = static_cast<GLsizei>(element->vertices().size() / stride);
+
+    if (!ranges.empty() && Texture::same(ranges.back().texture, element->texture()))
+    {
+      ranges.back().count += count;
+    }
+    else if (count > 0)
+    {
+      ranges.push_back({element->texture(), first, count});
+    }
+
+    vertices.insert(vertices.end(), element->vertices().begin(), element->vertices().end());
+  }
+}
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+void StaticBatch::bake()
+{
+  dirty_ = false;
+
+  // Draw in the same order a VertexBatcher would (back to front, grouped by
+  // texture)
+  std::stable_sort(elements_.begin(), elements_.end(),
+                   [](const RenderElement* a, const RenderElement* b) { return *a < *b; });
+
+  const auto elements_hash = hash(elements_);
+
+  // Nothing has changed since the last bake (e.g. an element was removed and
+  // added again), so the buffer can be drawn as it is
+  if (bake_count_ > 0 && elements_hash == baked_hash_)
+  {
+    return;
+  }
+
+  std::vector<float> vertices;
+  build_ranges(elements_, attributes_.size(), vertices, ranges_);
+
+  vbo_.bind();
+  vbo_.init_buffer(vertices.size());
+  vbo_.sub_vertices(vertices);
+  vbo_.unbind();
+
+  RenderStats::frame().vertex_bytes += vertices.size() * sizeof(float);
+  baked_hash_ = elements_hash;
+  bake_count_++;
+}
+} // end of namespace BarelyEngine
@@ -3,15 +3,23 @@
 // Copyright (c) 2015 Adam Ransom
 //
 
+#include <algorithm>
+#include <vector>
 #include <OpenGL/gl3.h>
 #include "texture.h"
+#include "compressed_image.h"
+#include "exception.h"
+#include "render_stats.h"
+#include "texture_array.h"
 
 namespace BarelyEngine {
 Texture::Texture(const int width, const int height, const GLenum format,
                  const GLenum internal_format, const uint8_t unpack_alignment, const void* pixels)
+  : internal_format_(internal_format)
 {
   texture_ = std::make_unique<BarelyGL::Texture>(width, height, format, internal_format,
                                                  unpack_alignment, pixels);
+  gpu_size_ = static_cast<size_t>(width) * height * bytes_per_pixel(internal_format);
 }
 
 // Construct and default to an unpack alignment of 4 bytes, which is the most usual
@@ -22,33 +30,316 @@ Texture::Texture(int width, int height, GLenum format, GLenum internal_format, c
 Texture::Texture(int width, int height, GLenum format, const void* pixels)
   : Texture(width, height, format, GL_RGBA8, pixels) {};
 
+Texture::Texture(const CompressedImage& image)
+  : Texture(image.gl_format(), image.levels(), image.data()) {};
+
+Texture::Texture(const GLenum compressed_format, const std::vector<CompressedLevel>& levels,
+                 const uint8_t* data)
+  : compressed_width_(levels.front().width)
+  , compressed_height_(levels.front().height)
+{
+  glGenTextures(1, &compressed_id_);
+  glBindTexture(GL_TEXTURE_2D, compressed_id_);
+
+  for (size_t i = 0; i < levels.size(); i++)
+  {
+    glCompressedTexImage2D(GL_TEXTURE_2D, static_cast<GLint>(i), compressed_format,
+                           levels[i].width, levels[i].height, 0,
+                           static_cast<GLsizei>(levels[i].size), &data[levels[i].offset]);
+    gpu_size_ += levels[i].size;
+  }
+
+  const auto has_mipmaps = levels.size() > 1;
+
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, static_cast<GLint>(levels.size() - 1));
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER,
+                  has_mipmaps ? GL_LINEAR_MIPMAP_LINEAR : GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+  glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+Texture::Texture(const TextureArray& array, const int layer)
+  : array_(&array)
+  , layer_(layer)
+{
+  // The layer's memory is counted by the array
+}
+
+Texture::~Texture()
+{
+  if (compressed_id_ != 0)
+  {
+    glDeleteTextures(1, &compressed_id_);
+  }
+}
+
+bool Texture::supports(const GLenum compressed_format)
+{
+  // The formats can't change for the context, so only ask for them once
+  static const auto formats = []()
+  {
+    GLint count = 0;
+    glGetIntegerv(GL_NUM_COMPRESSED_TEXTURE_FORMATS, &count);
+
+    std::vector<GLint> formats(static_cast<size_t>(std::max(count, 0)));
+
+    if (!formats.empty())
+    {
+      glGetIntegerv(GL_COMPRESSED_TEXTURE_FORMATS, formats.data());
+    }
+
+    return formats;
+  }();
+
+  return std::find(formats.begin(), formats.end(), static_cast<GLint>(compressed_format)) !=
+         formats.end();
+}
+
+bool Texture::same(const Texture* a, const Texture* b)
+{
+  if (a == nullptr || b == nullptr)
+  {
+    return a == b;
+  }
+
+  return a->id() == b->id();
+}
+
+size_t Texture::bytes_per_pixel(const GLenum internal_format)
+{
+  switch (internal_format)
+  {
+    case GL_RED:
+    case GL_R8:
+      return 1;
+    case GL_RG:
+    case GL_RG8:
+      return 2;
+    default:
+      // Even 3-byte formats are usually padded out to 4 bytes by the driver
+      return 4;
+  }
+}
+
+void Texture::upload_mipmaps(const std::vector<MipLevel>& levels, const GLenum format)
+{
+  std::vector<const void*> pixels;
+
+  for (const auto& level : levels)
+  {
+    pixels.push_back(level.pixels.data());
+  }
+
+  upload_mipmaps(pixels, format);
+}
+
+void Texture::upload_mipmaps(const std::vector<const void*>& levels, const GLenum format)
+{
+  if (array_ != nullptr)
+  {
+    throw Exception("Array layers share the mipmaps of their array");
+  }
+
+  if (!texture_)
+  {
+    throw Exception("Compressed textures come with their own mipmaps");
+  }
+
+  bind();
+
+  for (size_t i = 0; i < levels.size(); i++)
+  {
+    const auto level = static_cast<int>(i + 1);
+
+    upload_level(level, std::max(1, width() >> level), std::max(1, height() >> level), format,
+                 levels[i]);
+  }
+
+  set_level_range(0, static_cast<int>(levels.size()));
+  unbind();
+}
+
+void Texture::stream_mipmaps(std::vector<MipLevel> levels, const GLenum format,
+                             const size_t resident_levels)
+{
+  if (array_ != nullptr)
+  {
+    throw Exception("Array layers share the mipmaps of their array");
+  }
+
+  if (!texture_)
+  {
+    throw Exception("Compressed textures come with their own mipmaps");
+  }
+
+  if (levels.empty())
+  {
+    return;
+  }
+
+  const auto max_level = static_cast<int>(levels.size() - 1);
+  const auto first_resident = levels.size() - std::min(std::max<size_t>(resident_levels, 1),
+                                                       levels.size());
+
+  bind();
+
+  for (auto i = first_resident; i < levels.size(); i++)
+  {
+    upload_level(static_cast<int>(i), levels[i].width, levels[i].height, format,
+                 levels[i].pixels.data());
+  }
+
+  set_level_range(static_cast<int>(first_resident), max_level);
+  unbind();
+
+  levels.resize(first_resident);
+  pending_levels_ = std::move(levels);
+  pending_format_ = format;
+  max_level_ = max_level;
+}
+
+bool Texture::refine()
+{
+  if (pending_levels_.empty())
+  {
+    return false;
+  }
+
+  const auto level = static_cast<int>(pending_levels_.size() - 1);
+  const auto& pixels = pending_levels_.back();
+
+  bind();
+  upload_level(level, pixels.width, pixels.height, pending_format_, pixels.pixels.data());
+  set_level_range(level, max_level_);
+  unbind();
+
+  pending_levels_.pop_back();
+
+  return !pending_levels_.empty();
+}
+
 void Texture::bind() const
 {
-  texture_->bind();
+  RenderStats::frame().texture_binds++;
+
+  if (array_ != nullptr)
+  {
+    array_->bind();
+  }
+  else if (texture_)
+  {
+    texture_->bind();
+  }
+  else
+  {
+    glBindTexture(GL_TEXTURE_2D, compressed_id_);
+  }
 }
 
 void Texture::sub_data(int x_offset, int y_offset, int width, int height, const void* data)
 {
+  if (array_ != nullptr)
+  {
+    throw Exception("Can't upload data to an array layer directly");
+  }
+
+  if (!texture_)
+  {
+    throw Exception("Can't upload uncompressed data to a compressed texture");
+  }
+
   texture_->sub_data(x_offset, y_offset, width, height, data);
+  RenderStats::frame().texture_bytes +=
+    static_cast<uint64_t>(width) * height * bytes_per_pixel(internal_format_);
 }
 
 void Texture::unbind() const
 {
-  texture_->unbind();
+  if (array_ != nullptr)
+  {
+    array_->unbind();
+  }
+  else if (texture_)
+  {
+    texture_->unbind();
+  }
+  else
+  {
+    glBindTexture(GL_TEXTURE_2D, 0);
+  }
 }
 
 int Texture::width() const
 {
-  return texture_->width();
+  if (array_ != nullptr)
+  {
+    return array_->width();
+  }
+
+  return texture_ ? texture_->width() : compressed_width_;
 }
 
 int Texture::height() const
 {
-  return texture_->height();
+  if (array_ != nullptr)
+  {
+    return array_->height();
+  }
+
+  return texture_ ? texture_->height() : compressed_height_;
 }
 
 uint32_t Texture::id() const
 {
-  return texture_->id();
+  // Every layer shares the array's id, so they sort (and batch) together
+  if (array_ != nullptr)
+  {
+    return array_->id();
+  }
+
+  return texture_ ? texture_->id() : compressed_id_;
+}
+
+size_t Texture::cpu_size() const
+{
+  size_t size = 0;
+
+  for (const auto& level : pending_levels_)
+  {
+    size += level.pixels.size();
+  }
+
+  return size;
+}
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+void Texture::upload_level(const int level, const int width, const int height,
+                           const GLenum format, const void* pixels)
+{
+  // Every level is tightly packed 4-byte pixels, so the default unpack
+  // alignment of 4 is fine
+  glTexImage2D(GL_TEXTURE_2D, level, static_cast<GLint>(internal_format_), width, height, 0,
+               format, GL_UNSIGNED_BYTE, pixels);
+
+  // The base level's storage was allocated (and counted) on construction
+  if (level > 0)
+  {
+    gpu_size_ += static_cast<size_t>(width) * height * bytes_per_pixel(internal_format_);
+  }
+}
+
+void Texture::set_level_range(const int base_level, const int max_level)
+{
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_BASE_LEVEL, base_level);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, max_level);
+  glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 }
 } // end of namespace BarelyEngine
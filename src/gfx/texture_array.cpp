@@ -0,0 +1,97 @@
+//
+// gfx/texture_array.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <OpenGL/gl3.h>
+#include "texture_array.h"
+#include "texture.h"
+#include "exception.h"
+
+namespace BarelyEngine {
+TextureArray::TextureArray(const int width, const int height, const int capacity,
+                           const GLenum internal_format)
+  : width_(width)
+  , height_(height)
+  , capacity_(capacity)
+  , internal_format_(internal_format)
+{
+  glGenTextures(1, &id_);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, id_);
+
+  // Allocate every layer up front, which are then filled in as they're added
+  glTexImage3D(GL_TEXTURE_2D_ARRAY, 0, static_cast<GLint>(internal_format), width, height,
+               capacity, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+  glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+  gpu_size_ = base_size();
+  layers_.reserve(static_cast<size_t>(capacity));
+}
+
+// Construct and default to an internal format of GL_RGBA8
+TextureArray::TextureArray(int width, int height, int capacity)
+  : TextureArray(width, height, capacity, GL_RGBA8) {};
+
+TextureArray::~TextureArray()
+{
+  glDeleteTextures(1, &id_);
+}
+
+const Texture* TextureArray::add(const GLenum format, const void* pixels)
+{
+  if (size() >= capacity_)
+  {
+    throw Exception("Texture array is full (" + std::to_string(capacity_) + " layers)");
+  }
+
+  const auto layer = size();
+
+  glBindTexture(GL_TEXTURE_2D_ARRAY, id_);
+  glTexSubImage3D(GL_TEXTURE_2D_ARRAY, 0, 0, 0, layer, width_, height_, 1, format,
+                  GL_UNSIGNED_BYTE, pixels);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+  layers_.push_back(std::make_unique<Texture>(*this, layer));
+
+  return layers_.back().get();
+}
+
+void TextureArray::generate_mipmaps()
+{
+  glBindTexture(GL_TEXTURE_2D_ARRAY, id_);
+  glGenerateMipmap(GL_TEXTURE_2D_ARRAY);
+  glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+  glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+
+  // A full chain adds about a third again
+  gpu_size_ = base_size() + base_size() / 3;
+}
+
+void TextureArray::bind() const
+{
+  glBindTexture(GL_TEXTURE_2D_ARRAY, id_);
+}
+
+void TextureArray::unbind() const
+{
+  glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+}
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+size_t TextureArray::base_size() const
+{
+  return static_cast<size_t>(width_) * height_ * capacity_ *
+         Texture::bytes_per_pixel(internal_format_);
+}
+} // end of namespace BarelyEngine
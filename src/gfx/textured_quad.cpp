@@ -4,6 +4,7 @@
 //
 
 #include "textured_quad.h"
+#include "quad_generator.h"
 #include "texture.h"
 
 namespace BarelyEngine {
@@ -24,63 +25,23 @@ TexturedQuad::TexturedQuad(const float x, const float y, const float w, const fl
                            const Color color)
   : RenderElement(layer, depth, kAttributes_, texture)
 {
-  int values_per_vertex = kAttributes_.size();
-
-  std::vector<float> vertices(kVerticesPerElement_ * values_per_vertex);
-
-  vertices[0] = x;                  // x position
-  vertices[1] = y;                  // y position
-  vertices[2] = 0;                  // z position
-  vertices[3] = 0;                  // u coordinate
-  vertices[4] = 0;                  // v coordinate
-  vertices[5] = color.r() / 255.0f; // red tint component
-  vertices[6] = color.g() / 255.0f; // green tint component
-  vertices[7] = color.b() / 255.0f; // blue tint component
-
-  vertices[8] = x + w;
-  vertices[9] = y;
-  vertices[10] = 0;
-  vertices[11] = 1;
-  vertices[12] = 0;
-  vertices[13] = color.r() / 255.0f;
-  vertices[14] = color.g() / 255.0f;
-  vertices[15] = color.b() / 255.0f;
-
-  vertices[16] = x;
-  vertices[17] = y + h;
-  vertices[18] = 0;
-  vertices[19] = 0;
-  vertices[20] = 1;
-  vertices[21] = color.r() / 255.0f;
-  vertices[22] = color.g() / 255.0f;
-  vertices[23] = color.b() / 255.0f;
-
-  vertices[24] = x + w;
-  vertices[25] = y;
-  vertices[26] = 0;
-  vertices[27] = 1;
-  vertices[28] = 0;
-  vertices[29] = color.r() / 255.0f;
-  vertices[30] = color.g() / 255.0f;
-  vertices[31] = color.b() / 255.0f;
-
-  vertices[32] = x;
-  vertices[33] = y + h;
-  vertices[34] = 0;
-  vertices[35] = 0;
-  vertices[36] = 1;
-  vertices[37] = color.r() / 255.0f;
-  vertices[38] = color.g() / 255.0f;
-  vertices[39] = color.b() / 255.0f;
-
-  vertices[40] = x + w;
-  vertices[41] = y + h;
-  vertices[42] = 0;
-  vertices[43] = 1;
-  vertices[44] = 1;
-  vertices[45] = color.r() / 255.0f;
-  vertices[46] = color.g() / 255.0f;
-  vertices[47] = color.b() / 255.0f;
+  const uint8_t r = color.r(), g = color.g(), b = color.b();
+  // The layer of a texture array goes in the (otherwise unused) z component
+  const float z = texture != nullptr ? static_cast<float>(texture->layer()) : 0;
+
+  QuadArrays quad;
+  quad.count = 1;
+  quad.x = &x;
+  quad.y = &y;
+  quad.w = &w;
+  quad.h = &h;
+  quad.r = &r;
+  quad.g = &g;
+  quad.b = &b;
+  quad.layer = &z;
+
+  std::vector<float> vertices(QuadGenerator::kFloatsPerQuad);
+  QuadGenerator::generate(quad, vertices.data());
 
   set_vertices(vertices);
 }
@@ -100,64 +61,29 @@ TexturedQuad::TexturedQuad(const float x, const float y, const float w, const fl
 {
   const float texture_w = static_cast<float>(texture->width());
   const float texture_h = static_cast<float>(texture->height());
-
-  auto values_per_vertex = kAttributes_.size();
-
-  std::vector<float> vertices(kVerticesPerElement_ * values_per_vertex);
-
-  vertices[0] = x;                  // x position
-  vertices[1] = y;                  // y position
-  vertices[2] = 0;                  // z position
-  vertices[3] = clip_x / texture_w; // u coordinate
-  vertices[4] = clip_y / texture_h; // v coordinate
-  vertices[5] = color.r() / 255.0f; // red tint component
-  vertices[6] = color.g() / 255.0f; // green tint component
-  vertices[7] = color.b() / 255.0f; // blue tint component
-
-  vertices[8] = x + w;
-  vertices[9] = y;
-  vertices[10] = 0;
-  vertices[11] = (clip_x + clip_w) / texture_w;
-  vertices[12] = clip_y / texture_h;
-  vertices[13] = color.r() / 255.0f;
-  vertices[14] = color.g() / 255.0f;
-  vertices[15] = color.b() / 255.0f;
-
-  vertices[16] = x;
-  vertices[17] = y + h;
-  vertices[18] = 0;
-  vertices[19] = clip_x / texture_w;
-  vertices[20] = (clip_y + clip_h) / texture_h;
-  vertices[21] = color.r() / 255.0f;
-  vertices[22] = color.g() / 255.0f;
-  vertices[23] = color.b() / 255.0f;
-
-  vertices[24] = x + w;
-  vertices[25] = y;
-  vertices[26] = 0;
-  vertices[27] = (clip_x + clip_w) / texture_w;
-  vertices[28] = clip_y / texture_h;
-  vertices[29] = color.r() / 255.0f;
-  vertices[30] = color.g() / 255.0f;
-  vertices[31] = color.b() / 255.0f;
-
-  vertices[32] = x;
-  vertices[33] = y + h;
-  vertices[34] = 0;
-  vertices[35] = clip_x / texture_w;
-  vertices[36] = (clip_y + clip_h) / texture_h;
-  vertices[37] = color.r() / 255.0f;
-  vertices[38] = color.g() / 255.0f;
-  vertices[39] = color.b() / 255.0f;
-
-  vertices[40] = x + w;
-  vertices[41] = y + h;
-  vertices[42] = 0;
-  vertices[43] = (clip_x + clip_w) / texture_w;
-  vertices[44] = (clip_y + clip_h) / texture_h;
-  vertices[45] = color.r() / 255.0f;
-  vertices[46] = color.g() / 255.0f;
-  vertices[47] = color.b() / 255.0f;
+  const int32_t clip[] = {clip_x, clip_y, clip_w, clip_h};
+  const uint8_t r = color.r(), g = color.g(), b = color.b();
+  const float z = static_cast<float>(texture->layer());
+
+  QuadArrays quad;
+  quad.count = 1;
+  quad.x = &x;
+  quad.y = &y;
+  quad.w = &w;
+  quad.h = &h;
+  quad.clip_x = &clip[0];
+  quad.clip_y = &clip[1];
+  quad.clip_w = &clip[2];
+  quad.clip_h = &clip[3];
+  quad.texture_w = &texture_w;
+  quad.texture_h = &texture_h;
+  quad.r = &r;
+  quad.g = &g;
+  quad.b = &b;
+  quad.layer = &z;
+
+  std::vector<float> vertices(QuadGenerator::kFloatsPerQuad);
+  QuadGenerator::generate(quad, vertices.data());
 
   set_vertices(vertices);
 }
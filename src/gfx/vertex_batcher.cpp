@@ -3,17 +3,54 @@
 // Copyright (c) 2015 Adam Ransom
 //
 
+#include <algorithm>
 #include "vertex_batcher.h"
 #include "render_element.h"
 #include "texture.h"
+#include "exception.h"
 
 namespace BarelyEngine {
+namespace {
+/**
+ * @brief Gets the number of vertices which make up each primitive, so batches
+ *        are only ever split between primitives
+ *
+ * @return the number of vertices, or 0 if the primitives share vertices (as
+ *         in strips, fans and loops) so can't be split
+ */
+size_t vertices_per_primitive(const GLuint draw_mode)
+{
+  switch (draw_mode)
+  {
+    case GL_TRIANGLES:
+      return 3;
+    case GL_LINES:
+      return 2;
+    case GL_TRIANGLE_STRIP:
+    case GL_TRIANGLE_FAN:
+    case GL_LINE_STRIP:
+    case GL_LINE_LOOP:
+      return 0;
+    default:
+      return 1;
+  }
+}
+} // end of anonymous namespace
+
 VertexBatcher::VertexBatcher(const GLuint draw_mode,
                              const BarelyGL::VertexAttributeArray attributes,
-                             const int max_vertices)
+                             const int max_vertices,
+                             const SubmitMode submit_mode)
   : draw_mode_(draw_mode)
+  , submit_mode_(submit_mode)
   , attributes_(std::move(attributes))
 {
+  // Splitting a draw which doesn't fit would never make progress
+  if (max_vertices < static_cast<int>(std::max<size_t>(vertices_per_primitive(draw_mode_), 1)))
+  {
+    throw Exception("A vertex batch must hold at least one whole primitive");
+  }
+
   max_size_ = attributes_.size() * max_vertices;
   vertices_.reserve(max_size_);
 
@@ -30,38 +67,108 @@ VertexBatcher::VertexBatcher(const GLuint draw_mode,
   // Unbind the VBO and VAO so as not to overwrite the state by mistake
   vbo_.unbind();
   vao_.unbind();
+
+  if (submit_mode_ == SubmitMode::FRAME)
+  {
+    frame_capacity_ = max_size_;
+
+#if defined(GL_VERSION_4_3)
+    if (supports_multi_draw_indirect())
+    {
+      glGenBuffers(1, &indirect_buffer_);
+    }
+#endif
+  }
+}
+
+VertexBatcher::~VertexBatcher()
+{
+  if (indirect_buffer_ != 0)
+  {
+    glDeleteBuffers(1, &indirect_buffer_);
+  }
+}
+
+void VertexBatcher::set_viewport(const Rect& viewport)
+{
+  viewport_ = viewport;
+  cull_ = true;
 }
 
 /*
  * 'Draws' a RenderElement
  *
- * 1. Checks if the batcher needs to be flushed based on the new RenderElement.
- * 2. Sets the current properties from the new RenderElement.
- * 3. Adds the RenderElements vertices to the current collection
+ * 1. Skips the RenderElement if it's outside of the viewport.
+ * 2. Checks if the batcher needs to be flushed based on the new RenderElement.
+ * 3. Sets the current properties from the new RenderElement.
+ * 4. Adds the RenderElements vertices to the current collection
  *    vertices since the last flush.
  */
 void VertexBatcher::draw(const RenderElement* render_element)
 {
-  if (needs_flush(render_element))
+  if (!visible(render_element->bounds()))
+  {
+    return;
+  }
+
+  draw(render_element->texture(), render_element->id(), render_element->vertices().data(),
+       render_element->vertices().size());
+}
+
+void VertexBatcher::draw(const Texture* texture, const uint64_t id, const float* vertices,
+                         const size_t count)
+{
+  // Too many vertices for a single batch, so split them on whole primitives
+  if (submit_mode_ == SubmitMode::BATCH && count > max_size_)
+  {
+    const auto primitive = attributes_.size() * vertices_per_primitive(draw_mode_);
+
+    if (primitive == 0)
+    {
+      throw Exception("Strips, fans and loops can't be split between batches");
+    }
+
+    const auto chunk = max_size_ / primitive * primitive;
+
+    for (size_t offset = 0; offset < count; offset += chunk)
+    {
+      draw(texture, id, vertices + offset, std::min(chunk, count - offset));
+    }
+
+    return;
+  }
+
+  FlushReason reason;
+
+  if (needs_flush(id, count, reason))
   {
-    flush();
+    flush(reason);
   }
 
-  current_element_ = render_element;
+  current_texture_ = texture;
+  current_id_ = id;
+  has_current_ = true;
 
-  vertices_.insert(vertices_.end(), render_element->vertices().begin(),
-                   render_element->vertices().end());
+  vertices_.insert(vertices_.end(), vertices, vertices + count);
 }
 
 void VertexBatcher::begin()
 {
   draw_count_ = 0;
+  culled_count_ = 0;
 }
 
 void VertexBatcher::end()
 {
-  flush();
-  current_element_ = nullptr;
+  flush(FlushReason::END);
+
+  if (submit_mode_ == SubmitMode::FRAME)
+  {
+    submit_frame();
+  }
+
+  current_texture_ = nullptr;
+  has_current_ = false;
   last_bound_texture_ = nullptr;
 }
 
@@ -71,22 +178,36 @@ void VertexBatcher::end()
 // =============================
 //
 
-void VertexBatcher::flush()
+void VertexBatcher::flush(const FlushReason reason)
 {
-  if (vertices_.size() > 0)
-  {
-    const auto texture = current_element_->texture();
+  auto& stats = RenderStats::frame();
 
-    // Only bind the texture if the current element needs a different a texture
-    // than the one that was bound last
-    if (texture != nullptr && texture != last_bound_texture_)
+  if (submit_mode_ == SubmitMode::FRAME)
+  {
+    // The vertices stay in the frame's buffer, so just note where they are
+    if (vertices_.size() > batch_start_)
     {
-      if (last_bound_texture_ != nullptr) last_bound_texture_->unbind();
+      stats.add_flush(reason);
 
-      texture->bind();
-      last_bound_texture_ = texture;
+      const auto stride = attributes_.size();
+      commands_.push_back({static_cast<GLuint>((vertices_.size() - batch_start_) / stride), 1,
+                           static_cast<GLuint>(batch_start_ / stride), 0});
+      command_textures_.push_back(current_texture_);
+      batch_start_ = vertices_.size();
     }
 
+    return;
+  }
+
+  if (vertices_.size() > 0)
+  {
+    stats.add_flush(reason);
+    stats.draw_calls++;
+    stats.vertices += static_cast<uint32_t>(vertices_.size() / attributes_.size());
+    stats.vertex_bytes += vertices_.size() * sizeof(float);
+
+    bind_texture(current_texture_);
+
     // Update the vertices in the buffer
     vbo_.bind();
     vbo_.sub_vertices(vertices_);
@@ -102,17 +223,147 @@ void VertexBatcher::flush()
   }
 }
 
-bool VertexBatcher::needs_flush(const RenderElement* render_element) const
+void VertexBatcher::submit_frame()
+{
+  if (commands_.empty())
+  {
+    return;
+  }
+
+  // Upload the whole frame at once, orphaning the old buffer (so the driver
+  // doesn't wait for last frame's draws) and growing it if the frame is bigger
+  vbo_.bind();
+
+  if (vertices_.size() > frame_capacity_)
+  {
+    frame_capacity_ = std::max(vertices_.size(), frame_capacity_ * 2);
+  }
+
+  vbo_.init_buffer(frame_capacity_);
+  vbo_.sub_vertices(vertices_);
+  vbo_.unbind();
+
+  auto& stats = RenderStats::frame();
+  stats.vertices += static_cast<uint32_t>(vertices_.size() / attributes_.size());
+  stats.vertex_bytes += vertices_.size() * sizeof(float);
+
+  const auto indirect = indirect_buffer_ != 0;
+
+#if defined(GL_VERSION_4_3)
+  if (indirect)
+  {
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, indirect_buffer_);
+    glBufferData(GL_DRAW_INDIRECT_BUFFER, commands_.size() * sizeof(DrawArraysIndirectCommand),
+                 commands_.data(), GL_STREAM_DRAW);
+  }
+#endif
+
+  vao_.bind();
+
+  // Draw each run of commands using the same texture with one call, which
+  // only differs from the last in the texture it needs
+  for (size_t start = 0; start < commands_.size();)
+  {
+    const auto texture = command_textures_[start];
+    auto end = start + 1;
+
+    while (end < commands_.size() && Texture::same(command_textures_[end], texture))
+    {
+      end++;
+    }
+
+    bind_texture(texture);
+
+    const auto count = static_cast<GLsizei>(end - start);
+
+#if defined(GL_VERSION_4_3)
+    if (indirect)
+    {
+      const auto offset = start * sizeof(DrawArraysIndirectCommand);
+      glMultiDrawArraysIndirect(draw_mode_, reinterpret_cast<const void*>(offset), count, 0);
+    }
+    else
+#endif
+    {
+      firsts_.clear();
+      counts_.clear();
+
+      for (auto i = start; i < end; i++)
+      {
+        firsts_.push_back(static_cast<GLint>(commands_[i].first));
+        counts_.push_back(static_cast<GLsizei>(commands_[i].count));
+      }
+
+      glMultiDrawArrays(draw_mode_, firsts_.data(), counts_.data(), count);
+    }
+
+    draw_count_++;
+    stats.draw_calls++;
+    start = end;
+  }
+
+  vao_.unbind();
+
+#if defined(GL_VERSION_4_3)
+  if (indirect)
+  {
+    glBindBuffer(GL_DRAW_INDIRECT_BUFFER, 0);
+  }
+#endif
+
+  vertices_.clear();
+  commands_.clear();
+  command_textures_.clear();
+  batch_start_ = 0;
+}
+
+void VertexBatcher::bind_texture(const Texture* texture)
+{
+  // Only bind the texture if the current element needs a different a texture
+  // than the one that was bound last (layers of a texture array are all the
+  // same texture as far as OpenGL is concerned)
+  if (texture == nullptr)
+  {
+    return;
+  }
+
+  if (Texture::same(texture, last_bound_texture_))
+  {
+    RenderStats::frame().texture_binds_skipped++;
+    return;
+  }
+
+  if (last_bound_texture_ != nullptr) last_bound_texture_->unbind();
+
+  texture->bind();
+  last_bound_texture_ = texture;
+}
+
+bool VertexBatcher::supports_multi_draw_indirect()
+{
+  GLint major = 0;
+  GLint minor = 0;
+  glGetIntegerv(GL_MAJOR_VERSION, &major);
+  glGetIntegerv(GL_MINOR_VERSION, &minor);
+
+  return major > 4 || (major == 4 && minor >= 3);
+}
+
+bool VertexBatcher::needs_flush(const uint64_t id, const size_t count, FlushReason& reason) const
 {
   // If it's a new texture, we need to flush
-  if (current_element_ != nullptr && current_element_->id() != render_element->id())
+  if (has_current_ && current_id_ != id)
   {
+    reason = FlushReason::TEXTURE_CHANGE;
     return true;
   }
 
-  // If we have too many vertices in the batch, we need to flush
-  if (vertices_.size() + render_element->vertices().size() > max_size_)
+  // If we have too many vertices in the batch, we need to flush (the frame's
+  // buffer grows instead when submitting a frame at a time)
+  if (submit_mode_ == SubmitMode::BATCH &&
+      vertices_.size() + count > max_size_)
   {
+    reason = FlushReason::BATCH_FULL;
     return true;
   }
 
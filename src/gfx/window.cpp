@@ -8,6 +8,7 @@
 #include <SDL2/SDL.h>
 #include "window.h"
 #include "exception.h"
+#include "gpu_profiler.h"
 
 using namespace std::literals;
 
@@ -34,6 +35,9 @@ Window::Window(const std::string& title, const int width, const int height, cons
 
 Window::~Window()
 {
+  // The GPU profiler's queries go with the context, so delete them first
+  GpuProfiler::instance().release();
+
   SDL_DestroyWindow(window_);
   SDL_GL_DeleteContext(context_);
 }
@@ -48,6 +52,15 @@ void Window::swap_buffer()
   SDL_GL_SwapWindow(window_);
 }
 
+Rect Window::viewport(const float x, const float y) const
+{
+  int width = 0;
+  int height = 0;
+  SDL_GetWindowSize(window_, &width, &height);
+
+  return {x, y, static_cast<float>(width), static_cast<float>(height)};
+}
+
 //
 // =============================
 //        Private Methods
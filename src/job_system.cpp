@@ -0,0 +1,263 @@
+//
+// job_system.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <algorithm>
+#include "job_system.h"
+
+namespace BarelyEngine {
+namespace {
+/// The JobSystem the calling thread is a worker of (if any)
+thread_local const JobSystem* current_system = nullptr;
+/// The index of the calling worker's queue
+thread_local size_t current_queue = 0;
+} // end of anonymous namespace
+
+JobSystem::JobSystem(size_t worker_count)
+  : queued_(0)
+  , stopping_(false)
+{
+  if (worker_count == 0)
+  {
+    worker_count = std::max(std::thread::hardware_concurrency(), 2u) - 1;
+  }
+
+  for (size_t i = 0; i <= worker_count; i++)
+  {
+    queues_.push_back(std::make_unique<Queue>());
+  }
+
+  // Start the threads last, once everything they touch has been constructed
+  for (size_t i = 1; i <= worker_count; i++)
+  {
+    workers_.emplace_back(&JobSystem::work, this, i);
+  }
+}
+
+JobSystem::~JobSystem()
+{
+  {
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+    stopping_ = true;
+  }
+
+  wake_.notify_all();
+
+  for (auto& worker : workers_)
+  {
+    worker.join();
+  }
+}
+
+void JobSystem::run(std::function<void()> function, JobCounter* const counter)
+{
+  if (counter != nullptr)
+  {
+    counter->count_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  schedule({std::move(function), counter});
+}
+
+void JobSystem::run_after(JobCounter& dependency, std::function<void()> function,
+                          JobCounter* const counter)
+{
+  if (counter != nullptr)
+  {
+    counter->count_.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  {
+    // The dependency's last job takes the waiting jobs under this lock, after
+    // the count has reached zero, so the job is either seen done here or
+    // picked up by that job
+    std::lock_guard<std::mutex> lock(dependency.mutex_);
+
+    if (!dependency.done())
+    {
+      dependency.waiting_.push_back({std::move(function), counter});
+      return;
+    }
+  }
+
+  schedule({std::move(function), counter});
+}
+
+void JobSystem::wait(JobCounter& counter)
+{
+  Job job;
+
+  while (!counter.done())
+  {
+    if (take(job))
+    {
+      execute(job);
+    }
+    else
+    {
+      // The remaining jobs are running on other threads
+      std::this_thread::yield();
+    }
+  }
+}
+
+void JobSystem::parallel_for(const size_t count, size_t grain,
+                             const std::function<void(size_t begin, size_t end)>& function)
+{
+  if (count == 0)
+  {
+    return;
+  }
+
+  if (grain == 0)
+  {
+    const auto threads = workers_.size() + 1;
+    grain = (count + threads - 1) / threads;
+  }
+
+  JobCounter counter;
+
+  for (size_t begin = 0; begin < count; begin += grain)
+  {
+    const auto end = std::min(begin + grain, count);
+    run([&function, begin, end]() { function(begin, end); }, &counter);
+  }
+
+  wait(counter);
+}
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+void JobSystem::work(const size_t index)
+{
+  current_system = this;
+  current_queue = index;
+
+  Job job;
+
+  while (true)
+  {
+    if (take(job))
+    {
+      execute(job);
+      continue;
+    }
+
+    std::unique_lock<std::mutex> lock(sleep_mutex_);
+
+    // Only stop once every queue is empty, so no job is left unrun
+    if (stopping_ && queued_.load() == 0)
+    {
+      return;
+    }
+
+    wake_.wait(lock, [this]() { return stopping_ || queued_.load() > 0; });
+  }
+}
+
+void JobSystem::schedule(Job job)
+{
+  auto& queue = *queues_[queue_index()];
+
+  {
+    std::lock_guard<std::mutex> lock(queue.mutex);
+    queue.jobs.push_back(std::move(job));
+  }
+
+  queued_.fetch_add(1);
+
+  {
+    // Taking the lock means a worker can't be between checking `queued_` and
+    // going to sleep, so the wake-up isn't missed
+    std::lock_guard<std::mutex> lock(sleep_mutex_);
+  }
+
+  wake_.notify_one();
+}
+
+bool JobSystem::take(Job& job)
+{
+  const auto own = queue_index();
+
+  // Newest first from the thread's own queue, then oldest first from the rest
+  for (size_t i = 0; i < queues_.size(); i++)
+  {
+    const auto index = (own + i) % queues_.size();
+    auto& queue = *queues_[index];
+    std::lock_guard<std::mutex> lock(queue.mutex);
+
+    if (queue.jobs.empty())
+    {
+      continue;
+    }
+
+    if (index == own && own != 0)
+    {
+      job = std::move(queue.jobs.back());
+      queue.jobs.pop_back();
+    }
+    else
+    {
+      job = std::move(queue.jobs.front());
+      queue.jobs.pop_front();
+    }
+
+    queued_.fetch_sub(1);
+    return true;
+  }
+
+  return false;
+}
+
+void JobSystem::execute(Job& job)
+{
+  job.function();
+
+  const auto counter = job.counter;
+  job = {};
+
+  if (counter == nullptr)
+  {
+    return;
+  }
+
+  // Jobs which can't be the last one just decrement the count
+  auto count = counter->count_.load(std::memory_order_relaxed);
+
+  while (count > 1)
+  {
+    if (counter->count_.compare_exchange_weak(count, count - 1, std::memory_order_acq_rel))
+    {
+      return;
+    }
+  }
+
+  // The last job decrements under the lock, so the counter (which may be
+  // destroyed as soon as it's done) waits for the lock to be released
+  std::vector<Job> waiting;
+
+  {
+    std::lock_guard<std::mutex> lock(counter->mutex_);
+
+    if (counter->count_.fetch_sub(1, std::memory_order_acq_rel) == 1)
+    {
+      waiting.swap(counter->waiting_);
+    }
+  }
+
+  for (auto& dependent : waiting)
+  {
+    schedule(std::move(dependent));
+  }
+}
+
+size_t JobSystem::queue_index() const
+{
+  return current_system == this ? current_queue : 0;
+}
+} // end of namespace BarelyEngine
@@ -0,0 +1,54 @@
+//
+// resource_inventory.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <cstdio>
+#include "resource_inventory.h"
+
+namespace BarelyEngine {
+namespace {
+/**
+ * @brief Formats a number of bytes in KiB, which is readable for anything from
+ *        small icons to large atlases
+ */
+std::string kibibytes(const size_t bytes)
+{
+  char buffer[32];
+  std::snprintf(buffer, sizeof(buffer), "%.1f KiB", bytes / 1024.0);
+
+  return buffer;
+}
+} // end of anonymous namespace
+
+std::string format_inventory(const std::string& title, const std::vector<ResourceInfo>& inventory)
+{
+  ResourceMemory total;
+
+  for (const auto& info : inventory)
+  {
+    total.cpu += info.memory.cpu;
+    total.gpu += info.memory.gpu;
+  }
+
+  char line[512];
+  std::string table = title + ": " + std::to_string(inventory.size()) + " resources, " +
+                      kibibytes(total.total()) + " (CPU " + kibibytes(total.cpu) + ", GPU " +
+                      kibibytes(total.gpu) + ")\n";
+
+  std::snprintf(line, sizeof(line), "  %-32s %14s %14s %10s %10s %5s\n", "name", "CPU", "GPU",
+                "load ms", "last used", "refs");
+  table += line;
+
+  for (const auto& info : inventory)
+  {
+    std::snprintf(line, sizeof(line), "  %-32s %14s %14s %10.2f %10llu %5ld\n",
+                  info.name.c_str(), kibibytes(info.memory.cpu).c_str(),
+                  kibibytes(info.memory.gpu).c_str(), info.load_time,
+                  static_cast<unsigned long long>(info.last_used_frame), info.references);
+    table += line;
+  }
+
+  return table;
+}
+} // end of namespace BarelyEngine
@@ -0,0 +1,289 @@
+//
+// resource_watcher.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <algorithm>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#if defined(__linux__)
+#include <poll.h>
+#include <sys/inotify.h>
+#endif
+#include "resource_watcher.h"
+#include "exception.h"
+
+using namespace std::literals;
+
+namespace BarelyEngine {
+namespace {
+/// How long the watching thread waits for changes before checking if it
+/// should stop
+const int kWaitMilliseconds = 10;
+/// How often the directory is scanned when inotify isn't available
+const auto kPollInterval = std::chrono::milliseconds(250);
+} // end of anonymous namespace
+
+ResourceWatcher::ResourceWatcher(const std::string& directory, const clock::duration debounce)
+  : directory_(directory), debounce_(debounce)
+{
+  if (directory_.empty() || directory_.back() != '/')
+  {
+    directory_ += '/';
+  }
+
+  struct stat info;
+
+  if (stat(directory_.c_str(), &info) != 0 || !S_ISDIR(info.st_mode))
+  {
+    throw Exception("Can't watch '"s + directory + "', it isn't a directory");
+  }
+
+#if defined(__linux__)
+  inotify_ = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+  if (inotify_ < 0)
+  {
+    throw Exception("Can't watch '"s + directory + "', couldn't start inotify");
+  }
+
+  watch("", false);
+#else
+  std::vector<std::string> directories;
+
+  scan("", files_, directories);
+#endif
+
+  // Start the thread last, once everything it touches has been constructed
+  thread_ = std::thread(&ResourceWatcher::run, this);
+}
+
+ResourceWatcher::~ResourceWatcher()
+{
+  running_ = false;
+  thread_.join();
+
+  if (inotify_ >= 0)
+  {
+    close(inotify_);
+  }
+}
+
+std::vector<std::string> ResourceWatcher::changed()
+{
+  std::lock_guard<std::mutex> lock(changed_mutex_);
+  std::vector<std::string> changed;
+
+  changed.swap(changed_);
+
+  return changed;
+}
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+void ResourceWatcher::run()
+{
+#if defined(__linux__)
+  alignas(inotify_event) char buffer[4096];
+
+  while (running_)
+  {
+    pollfd descriptor = {inotify_, POLLIN, 0};
+
+    if (poll(&descriptor, 1, kWaitMilliseconds) > 0)
+    {
+      ssize_t length;
+
+      while ((length = read(inotify_, buffer, sizeof(buffer))) > 0)
+      {
+        for (auto next = buffer; next < buffer + length;)
+        {
+          const auto event = reinterpret_cast<const inotify_event*>(next);
+          next += sizeof(inotify_event) + event->len;
+
+          const auto search = watches_.find(event->wd);
+
+          if (search == watches_.end())
+          {
+            continue;
+          }
+          else if (event->mask & IN_IGNORED)
+          {
+            // The directory was deleted (or moved away)
+            watches_.erase(search);
+          }
+          else if (event->len > 0)
+          {
+            const auto filename = search->second + event->name;
+
+            if (event->mask & IN_ISDIR)
+            {
+              // Anything copied in before the watch was added would be missed
+              watch(filename + "/", true);
+            }
+            else
+            {
+              touch(filename);
+            }
+          }
+        }
+      }
+    }
+
+    settle();
+  }
+#else
+  std::vector<std::string> directories;
+  auto last_scan = clock::now();
+
+  while (running_)
+  {
+    std::this_thread::sleep_for(std::chrono::milliseconds(kWaitMilliseconds));
+
+    if (clock::now() - last_scan >= kPollInterval)
+    {
+      std::unordered_map<std::string, Stamp> current;
+
+      directories.clear();
+      scan("", current, directories);
+      last_scan = clock::now();
+
+      for (const auto& file : current)
+      {
+        const auto search = files_.find(file.first);
+
+        if (search == files_.end() || search->second != file.second)
+        {
+          touch(file.first);
+        }
+      }
+
+      files_.swap(current);
+    }
+
+    settle();
+  }
+#endif
+}
+
+void ResourceWatcher::touch(const std::string& filename)
+{
+  pending_[filename] = clock::now();
+}
+
+void ResourceWatcher::settle()
+{
+  if (pending_.empty())
+  {
+    return;
+  }
+
+  const auto now = clock::now();
+  std::lock_guard<std::mutex> lock(changed_mutex_);
+
+  for (auto file = pending_.begin(); file != pending_.end();)
+  {
+    if (now - file->second >= debounce_)
+    {
+      // Still there if the owner hasn't taken the changes since it last settled
+      if (std::find(changed_.begin(), changed_.end(), file->first) == changed_.end())
+      {
+        changed_.push_back(file->first);
+      }
+
+      file = pending_.erase(file);
+    }
+    else
+    {
+      ++file;
+    }
+  }
+}
+
+void ResourceWatcher::scan(const std::string& relative,
+                           std::unordered_map<std::string, Stamp>& files,
+                           std::vector<std::string>& directories) const
+{
+  const auto dir = opendir((directory_ + relative).c_str());
+
+  if (dir == nullptr)
+  {
+    return;
+  }
+
+  while (const auto entry = readdir(dir))
+  {
+    const std::string name = entry->d_name;
+
+    if (name == "." || name == "..")
+    {
+      continue;
+    }
+
+    const auto filename = relative + name;
+    struct stat info;
+
+    if (stat((directory_ + filename).c_str(), &info) != 0)
+    {
+      continue;
+    }
+
+    if (S_ISDIR(info.st_mode))
+    {
+      directories.push_back(filename + "/");
+      scan(filename + "/", files, directories);
+    }
+    else
+    {
+      files[filename] = {info.st_mtime, info.st_size};
+    }
+  }
+
+  closedir(dir);
+}
+
+void ResourceWatcher::watch(const std::string& relative, const bool existing_changed)
+{
+#if defined(__linux__)
+  // Only react to finished writes and files moved in (which is how a lot of
+  // editors save), rather than every partial write. Creations are only needed
+  // to spot new subdirectories
+  const auto mask = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE | IN_ONLYDIR;
+  const auto add = [&](const std::string& directory) {
+    const auto wd = inotify_add_watch(inotify_, (directory_ + directory).c_str(), mask);
+
+    if (wd >= 0)
+    {
+      watches_[wd] = directory;
+    }
+  };
+
+  std::unordered_map<std::string, Stamp> files;
+  std::vector<std::string> directories;
+
+  add(relative);
+  scan(relative, files, directories);
+
+  for (const auto& directory : directories)
+  {
+    add(directory);
+  }
+
+  if (existing_changed)
+  {
+    for (const auto& file : files)
+    {
+      touch(file.first);
+    }
+  }
+#else
+  (void)relative;
+  (void)existing_changed;
+#endif
+}
+} // end of namespace BarelyEngine
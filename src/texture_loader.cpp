@@ -3,46 +3,418 @@
 // Copyright (c) 2015 Adam Ransom
 //
 
+#include <algorithm>
 #include <string>
+#include <sys/stat.h>
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_image.h>
 #include <OpenGL/gl3.h>
 #include "texture_loader.h"
 #include "texture.h"
 #include "pixel_data.h"
+#include "compressed_image.h"
+#include "content_hash.h"
 #include "logging.h"
+#include "exception.h"
 
 using namespace std::literals;
 
 namespace BarelyEngine {
+namespace {
+/**
+ * @brief Reads a true/false option value
+ */
+bool read_bool(const std::string& value, bool& result)
+{
+  if (value == "true" || value == "1")
+  {
+    result = true;
+  }
+  else if (value == "false" || value == "0")
+  {
+    result = false;
+  }
+  else
+  {
+    return false;
+  }
+
+  return true;
+}
+} // end of anonymous namespace
+
+bool read_option(LoaderOptions<TextureLoader>& options, const std::string& key,
+                 const std::string& value)
+{
+  if (key == "premultiply_alpha")
+  {
+    return read_bool(value, options.premultiply_alpha);
+  }
+  else if (key == "mipmaps")
+  {
+    return read_bool(value, options.mipmaps);
+  }
+  else if (key == "mip_filter" && (value == "box" || value == "kaiser"))
+  {
+    options.mip_filter = value == "box" ? MipFilter::BOX : MipFilter::KAISER;
+    return true;
+  }
+  else if (key == "resident_mip_levels" && !value.empty() && value.size() < 4 &&
+           value.find_first_not_of("0123456789") == std::string::npos)
+  {
+    options.resident_mip_levels = std::stoul(value);
+    return true;
+  }
+
+  return false;
+}
+
+DecodedTexture::DecodedTexture(const std::string& path, SDL_Surface* surface)
+  : path(path)
+  , surface(surface)
+{
+  if (surface != nullptr)
+  {
+    pixel_data = std::make_unique<PixelData>(surface);
+  }
+}
+
+DecodedTexture::DecodedTexture(const std::string& path,
+                               std::unique_ptr<CompressedImage> compressed)
+  : path(path)
+  , compressed(std::move(compressed))
+{
+}
+
+DecodedTexture::DecodedTexture(const std::string& path,
+                               std::shared_ptr<const TexturePack> pack,
+                               const TexturePack::Entry* packed)
+  : path(path)
+  , pack(std::move(pack))
+  , packed(packed)
+{
+}
+
+DecodedTexture::~DecodedTexture()
+{
+  // The pixel data may refer to the surface, so make sure it goes first
+  pixel_data.reset();
+  SDL_FreeSurface(surface);
+}
+
+void TextureLoader::add_pack(std::shared_ptr<const TexturePack> pack)
+{
+  packs_.push_back(std::move(pack));
+}
+
 std::unique_ptr<Texture> TextureLoader::load(const std::string& filename,
-                                             const LoaderOptions<TextureLoader>& /* options */)
+                                             const LoaderOptions<TextureLoader>& options)
+{
+  auto decoded = take_prefetched(filename, options);
+
+  if (decoded == nullptr)
+  {
+    decoded = decode(filename, options);
+  }
+
+  return upload(*decoded);
+}
+
+void TextureLoader::prefetch(const std::string& filename,
+                             const LoaderOptions<TextureLoader>& options)
+{
+  auto decoded = decode(filename, options);
+  std::lock_guard<std::mutex> lock(prefetched_mutex_);
+
+  prefetched_.emplace(filename, Prefetched{options, std::move(decoded)});
+}
+
+void TextureLoader::discard_prefetched(const std::string& filename,
+                                       const LoaderOptions<TextureLoader>& options)
+{
+  take_prefetched(filename, options);
+}
+
+uint64_t TextureLoader::prefetch_order(const std::string& filename)
+{
+  // Packed textures take the lower half of the order, by pack (in the top
+  // bits) then by offset, and loose files the upper half, largest first
+  const uint64_t kLooseFiles = uint64_t(1) << 63;
+  const uint64_t kMaxOffset = (uint64_t(1) << 48) - 1;
+
+  for (size_t i = 0; i < packs_.size(); i++)
+  {
+    if (const auto entry = packs_[i]->find(filename))
+    {
+      return (static_cast<uint64_t>(i) << 48) +
+             std::min<uint64_t>(entry->levels.front().offset, kMaxOffset);
+    }
+  }
+
+  struct stat info;
+  const auto path = "resources/textures/" + filename;
+  const auto size = stat(path.c_str(), &info) == 0 ? static_cast<uint64_t>(info.st_size) : 0;
+
+  return kLooseFiles + (kLooseFiles - 1 - std::min(size, kLooseFiles - 1));
+}
+
+std::unique_ptr<DecodedTexture> TextureLoader::decode(const std::string& filename,
+                                                      const LoaderOptions<TextureLoader>& options)
 {
   const auto path = "resources/textures/" + filename;
 
   loading(path);
 
-  const auto surface = IMG_Load(path.c_str());
+  for (const auto& pack : packs_)
+  {
+    if (const auto entry = pack->find(filename))
+    {
+      // Fault the pages in here, rather than when uploading (which is usually
+      // on another thread)
+      pack->prefetch(*entry);
 
-  if (surface != nullptr)
+      return std::make_unique<DecodedTexture>(path, pack, entry);
+    }
+  }
+
+  if (is_compressed(filename))
   {
-    BE_LOG_DEBUG("Pixel format = "s + SDL_GetPixelFormatName(surface->format->format));
+    try
+    {
+      return std::make_unique<DecodedTexture>(path, CompressedImage::load(path));
+    }
+    catch (Exception& e)
+    {
+      failed(path, e.what());
 
-    PixelData pixel_data{surface};
-    pixel_data.prepare();
+      return std::make_unique<DecodedTexture>(path, std::unique_ptr<CompressedImage>());
+    }
+  }
 
-    auto texture =
-      std::make_unique<Texture>(surface->w, surface->h, pixel_data.format(), pixel_data.pixels());
-    SDL_FreeSurface(surface);
-    loaded(path);
+  auto decoded = std::make_unique<DecodedTexture>(path, IMG_Load(path.c_str()));
 
-    return texture;
+  if (decoded->surface != nullptr)
+  {
+    BE_LOG_DEBUG("Pixel format = "s + SDL_GetPixelFormatName(decoded->surface->format->format));
+
+    decoded->pixel_data->prepare(options.premultiply_alpha);
+
+    if (options.mipmaps)
+    {
+      generate_mipmaps(*decoded, options);
+    }
   }
   else
   {
     failed(path, IMG_GetError());
   }
 
+  return decoded;
+}
+
+std::unique_ptr<Texture> TextureLoader::upload(DecodedTexture& decoded)
+{
+  if (decoded.packed != nullptr)
+  {
+    return upload_packed(decoded);
+  }
+
+  if (decoded.compressed != nullptr)
+  {
+    if (!Texture::supports(decoded.compressed->gl_format()))
+    {
+      failed(decoded.path, "compressed format isn't supported by the GPU");
+
+      return nullptr;
+    }
+
+    auto texture = std::make_unique<Texture>(*decoded.compressed);
+    loaded(decoded.path);
+
+    return texture;
+  }
+
+  if (decoded.surface == nullptr)
+  {
+    return nullptr;
+  }
+
+  const auto format = decoded.pixel_data->format();
+  const auto streaming = decoded.resident_mip_levels > 0 && !decoded.mip_levels.empty();
+
+  // A streaming texture's base level is only allocated for now, and filled in
+  // when it is refined
+  auto texture = std::make_unique<Texture>(decoded.surface->w, decoded.surface->h, format,
+                                           streaming ? nullptr : decoded.pixel_data->pixels());
+
+  if (streaming)
+  {
+    texture->stream_mipmaps(std::move(decoded.mip_levels), format, decoded.resident_mip_levels);
+  }
+  else if (!decoded.mip_levels.empty())
+  {
+    texture->upload_mipmaps(decoded.mip_levels, format);
+  }
+
+  loaded(decoded.path);
+
+  return texture;
+}
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+void TextureLoader::generate_mipmaps(DecodedTexture& decoded,
+                                     const LoaderOptions<TextureLoader>& options)
+{
+  const auto surface = decoded.surface;
+  const auto pixels = static_cast<const uint8_t*>(decoded.pixel_data->pixels());
+
+  // Mipmaps can only be generated from the 4-byte pixels every prepared
+  // format ends up with
+  if (decoded.pixel_data->format() != GL_RGBA && decoded.pixel_data->format() != GL_BGRA)
+  {
+    BE_LOG_WARN("Can't generate mipmaps for '" + decoded.path + "' in its pixel format");
+    return;
+  }
+
+  decoded.mip_levels = MipChain::generate(pixels, surface->w, surface->h, options.mip_filter);
+
+  if (options.resident_mip_levels > 0)
+  {
+    // Streamed textures need their base level kept around too, since the
+    // surface will be long gone by the time it gets uploaded
+    const auto size = static_cast<size_t>(surface->w) * surface->h * 4;
+    decoded.mip_levels.insert(decoded.mip_levels.begin(),
+                              {surface->w, surface->h, std::vector<uint8_t>(pixels, pixels + size)});
+    decoded.resident_mip_levels = options.resident_mip_levels;
+  }
+}
+
+std::unique_ptr<Texture> TextureLoader::upload_packed(const DecodedTexture& decoded)
+{
+  const auto& entry = *decoded.packed;
+  const auto data = decoded.pack->data();
+  std::unique_ptr<Texture> texture;
+
+  if (entry.compressed)
+  {
+    const auto format = CompressedImage::gl_format(entry.compressed_format);
+
+    if (!Texture::supports(format))
+    {
+      failed(decoded.path, "compressed format isn't supported by the GPU");
+
+      return nullptr;
+    }
+
+    texture = std::make_unique<Texture>(format, entry.levels, data);
+  }
+  else
+  {
+    texture = std::make_unique<Texture>(entry.width, entry.height, entry.format,
+                                        &data[entry.levels.front().offset]);
+
+    if (entry.levels.size() > 1)
+    {
+      std::vector<const void*> mip_levels;
+
+      for (size_t i = 1; i < entry.levels.size(); i++)
+      {
+        mip_levels.push_back(&data[entry.levels[i].offset]);
+      }
+
+      texture->upload_mipmaps(mip_levels, entry.format);
+    }
+  }
+
+  loaded(decoded.path + " (packed)");
+
+  return texture;
+}
+
+uint64_t TextureLoader::content_hash(const std::string& filename,
+                                    const LoaderOptions<TextureLoader>& options)
+{
+  uint64_t hash = 0;
+  bool found = false;
+
+  for (const auto& pack : packs_)
+  {
+    if (const auto entry = pack->find(filename))
+    {
+      std::lock_guard<std::mutex> lock(pack_hashes_mutex_);
+      const auto cached = pack_hashes_.find(entry);
+
+      if (cached != pack_hashes_.end())
+      {
+        hash = cached->second;
+      }
+      else
+      {
+        // The levels are stored back to back
+        const auto& last = entry->levels.back();
+        const auto start = entry->levels.front().offset;
+
+        hash = ContentHash::hash(&pack->data()[start], last.offset + last.size - start);
+        hash = ContentHash::combine(hash, static_cast<uint64_t>(entry->width) << 32 | entry->height);
+        hash = ContentHash::combine(hash, entry->compressed
+                                            ? static_cast<uint64_t>(entry->compressed_format)
+                                            : static_cast<uint64_t>(entry->format) << 32);
+        pack_hashes_[entry] = hash;
+      }
+
+      found = true;
+      break;
+    }
+  }
+
+  if (!found && !ContentHash::hash_file("resources/textures/" + filename, hash))
+  {
+    return 0;
+  }
+
+  // Packed textures ignore the options, but hashing them anyway does no harm
+  hash = ContentHash::combine(hash, options.premultiply_alpha);
+  hash = ContentHash::combine(hash, options.mipmaps);
+  hash = ContentHash::combine(hash, static_cast<uint64_t>(options.mip_filter));
+  hash = ContentHash::combine(hash, options.resident_mip_levels);
+
+  // 0 means unknown, so nudge the (very unlikely) real one
+  return hash != 0 ? hash : 1;
+}
+
+std::unique_ptr<DecodedTexture> TextureLoader::take_prefetched(
+  const std::string& filename, const LoaderOptions<TextureLoader>& options)
+{
+  std::lock_guard<std::mutex> lock(prefetched_mutex_);
+  const auto range = prefetched_.equal_range(filename);
+
+  for (auto prefetched = range.first; prefetched != range.second; ++prefetched)
+  {
+    const auto& decoded_with = prefetched->second.options;
+
+    if (decoded_with.premultiply_alpha == options.premultiply_alpha &&
+        decoded_with.mipmaps == options.mipmaps && decoded_with.mip_filter == options.mip_filter &&
+        decoded_with.resident_mip_levels == options.resident_mip_levels)
+    {
+      auto decoded = std::move(prefetched->second.decoded);
+      prefetched_.erase(prefetched);
+
+      return decoded;
+    }
+  }
+
   return nullptr;
 }
+
+bool TextureLoader::is_compressed(const std::string& filename)
+{
+  const auto extension = filename.substr(filename.find_last_of('.') + 1);
+
+  return extension == "dds" || extension == "ktx2";
+}
 } // end of namespace BarelyEngine
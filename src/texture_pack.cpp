@@ -0,0 +1,295 @@
+//
+// texture_pack.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <OpenGL/gl3.h>
+#include "texture_pack.h"
+#include "exception.h"
+
+using namespace std::literals;
+
+namespace BarelyEngine {
+namespace {
+const uint32_t kMagic = 0x50544542; // "BETP"
+const uint32_t kVersion = 1;
+const size_t kHeaderSize = 16;
+const size_t kRecordSize = 48;
+const uint32_t kCompressedFlag = 0x1;
+
+/**
+ * @struct Record
+ * @brief An entry in the table of contents, as it is stored in the file
+ */
+struct Record
+{
+  uint64_t offset;
+  uint64_t size;
+  uint32_t name_offset;
+  uint32_t name_length;
+  uint32_t flags;
+  uint32_t format;
+  uint32_t width;
+  uint32_t height;
+  uint32_t level_count;
+  uint32_t reserved;
+};
+
+static_assert(sizeof(Record) == kRecordSize, "Texture pack records must be 48 bytes");
+
+/**
+ * @brief Lays out the levels of an entry back to back, starting at an offset
+ *
+ * @return the total size of the levels
+ */
+size_t layout_levels(TexturePack::Entry& entry, const size_t level_count, const size_t offset)
+{
+  size_t size = 0;
+
+  entry.levels.clear();
+
+  for (size_t i = 0; i < level_count; i++)
+  {
+    const auto width = std::max(1, entry.width >> i);
+    const auto height = std::max(1, entry.height >> i);
+    const auto level_size =
+      entry.compressed ? CompressedImage::level_size(entry.compressed_format, width, height)
+                       : static_cast<size_t>(width) * height * 4;
+
+    entry.levels.push_back({width, height, offset + size, level_size});
+    size += level_size;
+  }
+
+  return size;
+}
+} // end of anonymous namespace
+
+TexturePack::TexturePack(const std::string& path)
+  : path_(path)
+{
+  const auto file = open(path.c_str(), O_RDONLY);
+
+  if (file < 0)
+  {
+    throw Exception("Couldn't open texture pack '"s + path + "'");
+  }
+
+  struct stat info;
+
+  if (fstat(file, &info) != 0 || info.st_size < static_cast<off_t>(kHeaderSize))
+  {
+    close(file);
+    throw Exception("Texture pack '"s + path + "' is too small");
+  }
+
+  size_ = static_cast<size_t>(info.st_size);
+  const auto mapping = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, file, 0);
+
+  // The mapping keeps the file open on its own
+  close(file);
+
+  if (mapping == MAP_FAILED)
+  {
+    throw Exception("Couldn't map texture pack '"s + path + "'");
+  }
+
+  data_ = static_cast<const uint8_t*>(mapping);
+
+  try
+  {
+    read_contents();
+  }
+  catch (Exception&)
+  {
+    munmap(const_cast<uint8_t*>(data_), size_);
+    throw;
+  }
+}
+
+TexturePack::~TexturePack()
+{
+  munmap(const_cast<uint8_t*>(data_), size_);
+}
+
+const TexturePack::Entry* TexturePack::find(const std::string& name) const
+{
+  const auto entry = entries_.find(name);
+
+  return entry != entries_.end() ? &entry->second : nullptr;
+}
+
+void TexturePack::prefetch(const Entry& entry) const
+{
+  // madvise() needs a page aligned address
+  const auto page_size = static_cast<size_t>(sysconf(_SC_PAGESIZE));
+  const auto start = entry.levels.front().offset / page_size * page_size;
+  const auto end = entry.levels.back().offset + entry.levels.back().size;
+
+  madvise(const_cast<uint8_t*>(&data_[start]), end - start, MADV_WILLNEED);
+}
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+void TexturePack::read_contents()
+{
+  uint32_t header[4];
+  std::memcpy(header, data_, sizeof(header));
+
+  if (header[0] != kMagic || header[1] != kVersion)
+  {
+    throw Exception("'"s + path_ + "' isn't a texture pack (or is an unsupported version)");
+  }
+
+  const auto count = static_cast<size_t>(header[2]);
+
+  if (count > (size_ - kHeaderSize) / kRecordSize)
+  {
+    throw Exception("Texture pack '"s + path_ + "' has a truncated table of contents");
+  }
+
+  entries_.reserve(count);
+
+  for (size_t i = 0; i < count; i++)
+  {
+    Record record;
+    std::memcpy(&record, &data_[kHeaderSize + i * kRecordSize], sizeof(record));
+
+    Entry entry;
+    entry.compressed = (record.flags & kCompressedFlag) != 0;
+    entry.format = entry.compressed ? GL_FALSE : static_cast<GLenum>(record.format);
+    entry.compressed_format = static_cast<CompressedFormat>(record.format);
+    entry.width = static_cast<int>(record.width);
+    entry.height = static_cast<int>(record.height);
+
+    const auto valid_format =
+      entry.compressed ? record.format <= static_cast<uint32_t>(CompressedFormat::ETC2_RGBA)
+                       : (record.format == GL_RGBA || record.format == GL_BGRA);
+
+    if (!valid_format || entry.width <= 0 || entry.height <= 0 || record.level_count == 0 ||
+        record.level_count > 32 || record.offset % kAlignment != 0 ||
+        record.name_offset > size_ || record.name_length > size_ - record.name_offset ||
+        record.offset > size_ || record.size > size_ - record.offset ||
+        layout_levels(entry, record.level_count, record.offset) != record.size)
+    {
+      throw Exception("Texture pack '"s + path_ + "' has an invalid entry");
+    }
+
+    std::string name(reinterpret_cast<const char*>(&data_[record.name_offset]),
+                     record.name_length);
+    entries_.emplace(std::move(name), std::move(entry));
+  }
+}
+
+void TexturePackWriter::add(const std::string& name, const int width, const int height,
+                            const GLenum format, const uint8_t* pixels,
+                            const std::vector<MipLevel>& mip_levels)
+{
+  PendingEntry pending{name, {false, format, CompressedFormat::BC1, width, height, {}}, {}};
+  const auto size = static_cast<size_t>(width) * height * 4;
+
+  pending.data.assign(pixels, pixels + size);
+
+  for (const auto& level : mip_levels)
+  {
+    pending.data.insert(pending.data.end(), level.pixels.begin(), level.pixels.end());
+  }
+
+  layout_levels(pending.entry, mip_levels.size() + 1, 0);
+  entries_.push_back(std::move(pending));
+}
+
+void TexturePackWriter::add(const std::string& name, const CompressedImage& image)
+{
+  PendingEntry pending{name,
+                       {true, GL_FALSE, image.format(), image.width(), image.height(), {}},
+                       {}};
+
+  for (size_t i = 0; i < image.levels().size(); i++)
+  {
+    const auto data = image.level_data(i);
+    pending.data.insert(pending.data.end(), data, data + image.levels()[i].size);
+  }
+
+  layout_levels(pending.entry, image.levels().size(), 0);
+  entries_.push_back(std::move(pending));
+}
+
+std::vector<uint8_t> TexturePackWriter::contents() const
+{
+  const auto align = [](const size_t offset) {
+    return (offset + TexturePack::kAlignment - 1) / TexturePack::kAlignment *
+           TexturePack::kAlignment;
+  };
+
+  // Names follow the table of contents, then the (aligned) data follows them
+  auto offset = kHeaderSize + entries_.size() * kRecordSize;
+  std::vector<Record> records;
+
+  for (const auto& pending : entries_)
+  {
+    Record record = {};
+    record.name_offset = static_cast<uint32_t>(offset);
+    record.name_length = static_cast<uint32_t>(pending.name.size());
+    offset += pending.name.size();
+    records.push_back(record);
+  }
+
+  for (size_t i = 0; i < entries_.size(); i++)
+  {
+    const auto& entry = entries_[i].entry;
+    auto& record = records[i];
+
+    offset = align(offset);
+    record.offset = offset;
+    record.size = entries_[i].data.size();
+    record.flags = entry.compressed ? kCompressedFlag : 0;
+    record.format = entry.compressed ? static_cast<uint32_t>(entry.compressed_format)
+                                     : static_cast<uint32_t>(entry.format);
+    record.width = static_cast<uint32_t>(entry.width);
+    record.height = static_cast<uint32_t>(entry.height);
+    record.level_count = static_cast<uint32_t>(entry.levels.size());
+    offset += record.size;
+  }
+
+  std::vector<uint8_t> file(offset, 0);
+  const uint32_t header[4] = {kMagic, kVersion, static_cast<uint32_t>(entries_.size()), 0};
+
+  std::memcpy(file.data(), header, sizeof(header));
+
+  for (size_t i = 0; i < entries_.size(); i++)
+  {
+    const auto& pending = entries_[i];
+    const auto& record = records[i];
+
+    std::memcpy(&file[kHeaderSize + i * kRecordSize], &record, sizeof(record));
+    std::copy(pending.name.begin(), pending.name.end(), &file[record.name_offset]);
+    std::copy(pending.data.begin(), pending.data.end(), &file[record.offset]);
+  }
+
+  return file;
+}
+
+void TexturePackWriter::save(const std::string& path) const
+{
+  const auto file = contents();
+  std::ofstream stream(path, std::ios::binary);
+
+  stream.write(reinterpret_cast<const char*>(file.data()), file.size());
+
+  if (!stream)
+  {
+    throw Exception("Couldn't write texture pack '"s + path + "'");
+  }
+}
+} // end of namespace BarelyEngine
@@ -0,0 +1,80 @@
+//
+// texture_stream.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <chrono>
+#include "texture_stream.h"
+#include "texture_loader.h"
+#include "texture.h"
+
+namespace BarelyEngine {
+TextureStream::TextureStream(std::shared_ptr<TextureLoader> loader)
+  : loader_(std::move(loader))
+{
+  // Start the thread last, once everything it touches has been constructed
+  thread_ = std::thread(&TextureStream::run, this);
+}
+
+TextureStream::~TextureStream()
+{
+  running_ = false;
+  thread_.join();
+}
+
+bool TextureStream::request(const std::string& filename)
+{
+  if (requests_.push_back(filename))
+  {
+    pending_++;
+    return true;
+  }
+
+  return false;
+}
+
+bool TextureStream::receive(std::string& path, std::unique_ptr<Texture>& texture)
+{
+  std::unique_ptr<DecodedTexture> decoded;
+
+  if (!decoded_.pop_front(decoded))
+  {
+    return false;
+  }
+
+  path = decoded->path;
+  texture = loader_->upload(*decoded);
+  pending_--;
+
+  return true;
+}
+
+//
+// =============================
+//        Private Methods
+// =============================
+//
+
+void TextureStream::run()
+{
+  std::string filename;
+
+  while (running_)
+  {
+    if (requests_.pop_front(filename))
+    {
+      auto decoded = loader_->decode(filename);
+
+      // Wait for the render thread to make room, unless we're shutting down
+      while (!decoded_.push_back(std::move(decoded)) && running_)
+      {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+      }
+    }
+    else
+    {
+      std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+  }
+}
+} // end of namespace BarelyEngine
@@ -0,0 +1,78 @@
+//
+// content_hash_tests.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <cstdio>
+#include <fstream>
+#include <vector>
+#include "catch.hpp"
+#include "content_hash.h"
+
+using namespace BarelyEngine;
+
+TEST_CASE("ContentHash", "[content_hash]")
+{
+  SECTION("Matches the reference XXH64 hashes")
+  {
+    std::vector<uint8_t> counting(100);
+
+    for (size_t i = 0; i < counting.size(); i++)
+    {
+      counting[i] = static_cast<uint8_t>(i);
+    }
+
+    REQUIRE(ContentHash::hash("", 0) == 0xEF46DB3751D8E999ULL);
+    REQUIRE(ContentHash::hash("a", 1) == 0xD24EC4F1A98C6E5BULL);
+    REQUIRE(ContentHash::hash("abc", 3) == 0x44BC2CF5AD770999ULL);
+    REQUIRE(ContentHash::hash(counting.data(), counting.size()) == 0x6AC1E58032166597ULL);
+  }
+
+  SECTION("Seeds give different hashes")
+  {
+    REQUIRE(ContentHash::hash("abc", 3, 1) != ContentHash::hash("abc", 3, 2));
+  }
+
+  SECTION("Combining values changes the hash")
+  {
+    const auto hash = ContentHash::hash("abc", 3);
+
+    REQUIRE(ContentHash::combine(hash, 1) != hash);
+    REQUIRE(ContentHash::combine(hash, 1) != ContentHash::combine(hash, 2));
+  }
+
+  SECTION("Hashes the contents of files")
+  {
+    const std::string path = "content_hash_test.bin";
+    std::ofstream(path, std::ios::binary) << "abc";
+    uint64_t hash = 0;
+
+    REQUIRE(ContentHash::hash_file(path, hash));
+    REQUIRE(hash == ContentHash::hash("abc", 3));
+
+    std::remove(path.c_str());
+  }
+
+  SECTION("Hashes a file again once it changes")
+  {
+    const std::string path = "content_hash_test.bin";
+    std::ofstream(path, std::ios::binary) << "abc";
+    uint64_t hash = 0;
+
+    REQUIRE(ContentHash::hash_file(path, hash));
+
+    std::ofstream(path, std::ios::binary) << "abcd";
+
+    REQUIRE(ContentHash::hash_file(path, hash));
+    REQUIRE(hash == ContentHash::hash("abcd", 4));
+
+    std::remove(path.c_str());
+  }
+
+  SECTION("Fails for missing files")
+  {
+    uint64_t hash = 0;
+
+    REQUIRE_FALSE(ContentHash::hash_file("missing_file.bin", hash));
+  }
+}
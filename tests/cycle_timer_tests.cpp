@@ -0,0 +1,40 @@
+//
+// cycle_timer_tests.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <thread>
+#include <chrono>
+#include "catch.hpp"
+#include "cycle_timer.h"
+
+using namespace BarelyEngine;
+
+TEST_CASE("CycleTimer", "[timer]")
+{
+  CycleTimer timer;
+
+  SECTION("Ticks never go backwards")
+  {
+    const auto first = CycleClock::now();
+    const auto second = CycleClock::now_serialized();
+
+    REQUIRE(second >= first);
+  }
+
+  SECTION("Calibrates a positive rate")
+  {
+    REQUIRE(CycleClock::ticks_per_millisecond() > 0);
+    REQUIRE(CycleClock::to_milliseconds(0) == 0);
+  }
+
+  SECTION("Timer times correctly")
+  {
+    timer.touch();
+    std::this_thread::sleep_for(std::chrono::milliseconds(200));
+    auto duration = timer.peek();
+
+    REQUIRE(duration >= 195);
+    REQUIRE(duration < 400);
+  }
+}
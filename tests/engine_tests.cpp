@@ -6,6 +6,8 @@
 #include "catch.hpp"
 #include "fakeit.hpp"
 #include "engine.h"
+#include "exception.h"
+#include "job_system.h"
 #include "logger.h"
 
 using namespace BarelyEngine;
@@ -63,3 +65,39 @@ TEST_CASE("Engine Logging", "[engine]")
   // Remove logger after each section as Engine is static
   Engine::unregister_logger(&logger);
 }
+
+TEST_CASE("Engine job system", "[engine]")
+{
+  // Engine is static, so start from a stopped job system whatever ran before
+  Engine::stop_jobs();
+
+  SECTION("Throws if the job system is used before it starts")
+  {
+    REQUIRE_THROWS_AS(Engine::jobs(), Exception);
+  }
+
+  SECTION("Starts the job system with the workers asked for")
+  {
+    Engine::start_jobs(1);
+
+    REQUIRE(Engine::jobs().worker_count() == 1);
+  }
+
+  SECTION("Keeps the running job system when started again")
+  {
+    Engine::start_jobs(1);
+    Engine::start_jobs(2);
+
+    REQUIRE(Engine::jobs().worker_count() == 1);
+  }
+
+  SECTION("Throws once the job system stops")
+  {
+    Engine::start_jobs(1);
+    Engine::stop_jobs();
+
+    REQUIRE_THROWS_AS(Engine::jobs(), Exception);
+  }
+
+  Engine::stop_jobs();
+}
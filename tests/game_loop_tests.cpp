@@ -0,0 +1,75 @@
+//
+// game_loop_tests.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <vector>
+#include "catch.hpp"
+#include "game_loop.h"
+#include "exception.h"
+
+using namespace BarelyEngine;
+
+TEST_CASE("GameLoop", "[game_loop]")
+{
+  GameLoop loop{100};
+  std::vector<double> steps;
+  const auto update = [&steps](const double dt) { steps.push_back(dt); };
+
+  REQUIRE(loop.step() == 10);
+
+  SECTION("Runs an update for each whole step")
+  {
+    REQUIRE(loop.advance(25, update) == 2);
+    REQUIRE((steps == std::vector<double>{10, 10}));
+    REQUIRE(loop.alpha() == Approx(0.5));
+
+    REQUIRE(loop.advance(5, update) == 1);
+    REQUIRE(loop.alpha() == Approx(0));
+  }
+
+  SECTION("Drops time beyond the maximum updates")
+  {
+    loop.set_max_updates(3);
+
+    REQUIRE(loop.advance(1000, update) == 3);
+    REQUIRE(loop.alpha() == Approx(0));
+  }
+
+  SECTION("Rejects update rates which aren't positive")
+  {
+    REQUIRE_THROWS_AS(loop.set_update_rate(0), Exception);
+    REQUIRE_THROWS_AS(loop.set_update_rate(-60), Exception);
+    REQUIRE_THROWS_AS(GameLoop{0}, Exception);
+    REQUIRE(loop.step() == 10);
+  }
+
+  SECTION("Waits until the deadline")
+  {
+    const auto deadline = GameLoop::clock::now() + std::chrono::milliseconds(20);
+    loop.wait_until(deadline);
+
+    REQUIRE(GameLoop::clock::now() >= deadline);
+    REQUIRE(loop.sleep_estimate() > 0);
+  }
+
+  SECTION("Runs until stopped, pacing the frames")
+  {
+    int frames = 0;
+
+    loop.set_frame_rate(200);
+
+    Timer timer;
+    loop.run([&loop, &frames](double) { if (frames >= 10) loop.stop(); },
+             [&frames](const double alpha)
+             {
+               REQUIRE(alpha >= 0);
+               REQUIRE(alpha < 1);
+               frames++;
+             });
+
+    REQUIRE_FALSE(loop.running());
+    REQUIRE(frames >= 10);
+    REQUIRE(timer.peek() >= 45);
+  }
+}
@@ -0,0 +1,82 @@
+//
+// block_compressor_tests.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <vector>
+#include "catch.hpp"
+#include "block_compressor.h"
+
+using namespace BarelyEngine;
+
+/// Builds a 4x4 block of RGBA pixels, alternating between two colors
+std::vector<uint8_t> create_block(uint32_t even, uint32_t odd)
+{
+  std::vector<uint8_t> pixels;
+
+  for (int i = 0; i < 16; i++)
+  {
+    const auto color = i % 2 == 0 ? even : odd;
+
+    for (int c = 0; c < 4; c++)
+    {
+      pixels.push_back(static_cast<uint8_t>(color >> (24 - c * 8)));
+    }
+  }
+
+  return pixels;
+}
+
+TEST_CASE("BlockCompressor", "[block_compressor]")
+{
+  SECTION("Compresses a solid BC1 block to a single color")
+  {
+    const auto pixels = create_block(0xFF0000FF, 0xFF0000FF);
+    std::vector<uint8_t> block(8);
+
+    BlockCompressor::compress_bc1_block(pixels.data(), block.data());
+
+    const std::vector<uint8_t> expected = {0x00, 0xF8, 0x00, 0xF8, 0, 0, 0, 0};
+    REQUIRE(block == expected);
+  }
+
+  SECTION("Compresses a two color BC1 block to its endpoints")
+  {
+    const auto pixels = create_block(0xFFFFFFFF, 0x000000FF);
+    std::vector<uint8_t> block(8);
+
+    BlockCompressor::compress_bc1_block(pixels.data(), block.data());
+
+    // White is color0 (index 0) and black is color1 (index 1)
+    const std::vector<uint8_t> expected = {0xFF, 0xFF, 0x00, 0x00, 0x44, 0x44, 0x44, 0x44};
+    REQUIRE(block == expected);
+  }
+
+  SECTION("Compresses BC3 alpha to its endpoints")
+  {
+    const auto pixels = create_block(0xFFFFFFFF, 0xFFFFFF00);
+    std::vector<uint8_t> block(16);
+
+    BlockCompressor::compress_bc3_block(pixels.data(), block.data());
+
+    // Opaque is alpha0 (index 0) and transparent is alpha1 (index 1)
+    const std::vector<uint8_t> expected = {0xFF, 0x00, 0x08, 0x82, 0x20, 0x08, 0x82, 0x20};
+    REQUIRE(std::vector<uint8_t>(block.begin(), block.begin() + 8) == expected);
+  }
+
+  SECTION("Compresses whole images, padding partial blocks")
+  {
+    const std::vector<uint8_t> pixels(6 * 5 * 4, 0x80);
+
+    REQUIRE(BlockCompressor::compress(pixels.data(), 6, 5, CompressedFormat::BC1).size() == 32);
+    REQUIRE(BlockCompressor::compress(pixels.data(), 6, 5, CompressedFormat::BC3).size() == 64);
+  }
+
+  SECTION("Throws exception for formats it can't encode")
+  {
+    const std::vector<uint8_t> pixels(4 * 4 * 4, 0);
+
+    REQUIRE_THROWS(BlockCompressor::compress(pixels.data(), 4, 4, CompressedFormat::BC7));
+    REQUIRE_THROWS(BlockCompressor::compress(pixels.data(), 4, 4, CompressedFormat::ETC2_RGB));
+  }
+}
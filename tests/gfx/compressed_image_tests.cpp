@@ -0,0 +1,97 @@
+//
+// compressed_image_tests.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+#include "catch.hpp"
+#include "compressed_image.h"
+
+using namespace BarelyEngine;
+
+/// Builds an image with a full mipmap chain, filling each level with its index
+std::unique_ptr<CompressedImage> create_image(CompressedFormat format, int width, int height,
+                                              size_t level_count)
+{
+  std::vector<uint8_t> data;
+  std::vector<CompressedLevel> levels;
+
+  for (size_t i = 0; i < level_count; i++)
+  {
+    const auto level_width = std::max(1, width >> i);
+    const auto level_height = std::max(1, height >> i);
+    const auto size = CompressedImage::level_size(format, level_width, level_height);
+
+    levels.push_back({level_width, level_height, data.size(), size});
+    data.insert(data.end(), size, static_cast<uint8_t>(i + 1));
+  }
+
+  return std::make_unique<CompressedImage>(format, std::move(data), std::move(levels));
+}
+
+void REQUIRE_SAME_IMAGE(const CompressedImage& a, const CompressedImage& b)
+{
+  REQUIRE(a.format() == b.format());
+  REQUIRE(a.width() == b.width());
+  REQUIRE(a.height() == b.height());
+  REQUIRE(a.levels().size() == b.levels().size());
+
+  for (size_t i = 0; i < a.levels().size(); i++)
+  {
+    REQUIRE(a.levels()[i].width == b.levels()[i].width);
+    REQUIRE(a.levels()[i].height == b.levels()[i].height);
+    REQUIRE(a.levels()[i].size == b.levels()[i].size);
+    REQUIRE(std::memcmp(a.level_data(i), b.level_data(i), a.levels()[i].size) == 0);
+  }
+}
+
+TEST_CASE("CompressedImage", "[compressed_image]")
+{
+  SECTION("Calculates level sizes in whole blocks")
+  {
+    REQUIRE(CompressedImage::level_size(CompressedFormat::BC1, 16, 16) == 128);
+    REQUIRE(CompressedImage::level_size(CompressedFormat::BC3, 16, 16) == 256);
+    REQUIRE(CompressedImage::level_size(CompressedFormat::BC1, 5, 1) == 16);
+    REQUIRE(CompressedImage::level_size(CompressedFormat::ETC2_RGBA, 1, 1) == 16);
+  }
+
+  SECTION("Round trips through DDS")
+  {
+    const auto bc1 = create_image(CompressedFormat::BC1, 32, 16, 6);
+    REQUIRE_SAME_IMAGE(*bc1, *CompressedImage::read(bc1->to_dds()));
+
+    const auto bc7 = create_image(CompressedFormat::BC7, 8, 8, 1);
+    REQUIRE_SAME_IMAGE(*bc7, *CompressedImage::read(bc7->to_dds()));
+  }
+
+  SECTION("Round trips through KTX2")
+  {
+    const auto bc3 = create_image(CompressedFormat::BC3, 16, 32, 6);
+    REQUIRE_SAME_IMAGE(*bc3, *CompressedImage::read(bc3->to_ktx2()));
+
+    const auto etc2 = create_image(CompressedFormat::ETC2_RGB, 12, 4, 3);
+    REQUIRE_SAME_IMAGE(*etc2, *CompressedImage::read(etc2->to_ktx2()));
+  }
+
+  SECTION("Throws exception for invalid files")
+  {
+    REQUIRE_THROWS(CompressedImage::read({}));
+    REQUIRE_THROWS(CompressedImage::read({'P', 'N', 'G', ' ', 0, 0, 0, 0}));
+
+    // Cut off part of the last level
+    auto dds = create_image(CompressedFormat::BC1, 8, 8, 1)->to_dds();
+    dds.pop_back();
+    REQUIRE_THROWS(CompressedImage::read(dds));
+
+    auto ktx2 = create_image(CompressedFormat::BC1, 8, 8, 2)->to_ktx2();
+    ktx2.resize(ktx2.size() - 4);
+    REQUIRE_THROWS(CompressedImage::read(ktx2));
+  }
+
+  SECTION("Throws exception writing ETC2 to DDS")
+  {
+    REQUIRE_THROWS(create_image(CompressedFormat::ETC2_RGBA, 4, 4, 1)->to_dds());
+  }
+}
@@ -0,0 +1,124 @@
+//
+// culling_grid_tests.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <algorithm>
+#include <cmath>
+#include "catch.hpp"
+#include "culling_grid.h"
+#include "textured_quad.h"
+#include "exception.h"
+
+using namespace BarelyEngine;
+
+TEST_CASE("Culling grid", "[culling_grid]")
+{
+  CullingGrid grid{100};
+  std::vector<const RenderElement*> visible;
+
+  TexturedQuad inside{10, 10, 20, 20, 0, 0, nullptr};
+  TexturedQuad outside{500, 500, 20, 20, 0, 0, nullptr};
+  TexturedQuad spanning{-50, 50, 400, 20, 0, 0, nullptr};
+
+  const auto inside_handle = grid.insert(&inside);
+  grid.insert(&outside);
+  grid.insert(&spanning);
+
+  SECTION("Finds only the elements overlapping the viewport")
+  {
+    grid.query({0, 0, 200, 200}, visible);
+
+    REQUIRE(visible.size() == 2);
+    REQUIRE(visible[0] == &inside);
+    REQUIRE(visible[1] == &spanning);
+  }
+
+  SECTION("Rejects elements in overlapping cells that are outside of the viewport")
+  {
+    grid.query({450, 0, 40, 40}, visible);
+
+    REQUIRE(visible.empty());
+  }
+
+  SECTION("Finds elements at negative positions")
+  {
+    grid.query({-40, 55, 5, 5}, visible);
+
+    REQUIRE(visible.size() == 1);
+    REQUIRE(visible[0] == &spanning);
+  }
+
+  SECTION("Returns the elements in sort key order")
+  {
+    TexturedQuad above{20, 20, 20, 20, 1, 0, nullptr};
+    TexturedQuad below{20, 20, 20, 20, 0, 0, nullptr};
+    grid.clear();
+    grid.insert(&above);
+    grid.insert(&below);
+
+    grid.query({0, 0, 200, 200}, visible);
+
+    REQUIRE(visible.size() == 2);
+    REQUIRE(visible[0] == &below);
+    REQUIRE(visible[1] == &above);
+  }
+
+  SECTION("Finds elements where they were moved to once updated")
+  {
+    inside = TexturedQuad{600, 600, 20, 20, 0, 0, nullptr};
+    grid.update(inside_handle);
+
+    grid.query({0, 0, 200, 200}, visible);
+
+    REQUIRE(visible.size() == 1);
+    REQUIRE(visible[0] == &spanning);
+
+    grid.query({550, 550, 100, 100}, visible);
+
+    REQUIRE(visible.size() == 1);
+    REQUIRE(visible[0] == &inside);
+  }
+
+  SECTION("Finds nothing of removed elements")
+  {
+    grid.remove(inside_handle);
+    grid.query({0, 0, 200, 200}, visible);
+
+    REQUIRE(grid.size() == 2);
+    REQUIRE(visible.size() == 1);
+    REQUIRE(visible[0] == &spanning);
+  }
+
+  SECTION("Finds nothing once cleared")
+  {
+    grid.clear();
+    grid.query({0, 0, 1000, 1000}, visible);
+
+    REQUIRE(grid.size() == 0);
+    REQUIRE(visible.empty());
+  }
+
+  SECTION("Never finds elements whose bounds aren't finite")
+  {
+    TexturedQuad broken{NAN, 10, 20, 20, 0, 0, nullptr};
+    const auto handle = grid.insert(&broken);
+
+    grid.query({-1000, -1000, 2000, 2000}, visible);
+
+    REQUIRE(visible.size() == 3);
+    REQUIRE(std::find(visible.begin(), visible.end(), &broken) == visible.end());
+
+    broken = TexturedQuad{10, 10, 20, 20, 0, 0, nullptr};
+    grid.update(handle);
+    grid.query({0, 0, 40, 40}, visible);
+
+    REQUIRE(visible.size() == 2);
+    REQUIRE(visible[1] == &broken);
+  }
+
+  SECTION("Rejects cells without a positive size")
+  {
+    REQUIRE_THROWS_AS(CullingGrid(0), Exception);
+  }
+}
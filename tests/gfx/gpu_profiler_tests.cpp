@@ -0,0 +1,164 @@
+//
+// gpu_profiler_tests.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <cstring>
+#include <map>
+#include "catch.hpp"
+#include "frame_profiler.h"
+#include "gpu_profiler.h"
+
+using namespace BarelyEngine;
+
+namespace {
+/// Queries whose timestamps are a millisecond apart, in the order written
+class FakeQueryBackend : public GpuQueryBackend
+{
+public:
+  void generate(const size_t count, GLuint* const queries) override
+  {
+    for (size_t i = 0; i < count; i++)
+    {
+      queries[i] = ++generated;
+    }
+  }
+
+  void destroy(const size_t count, const GLuint*) override
+  {
+    destroyed += count;
+  }
+
+  void write_timestamp(const GLuint query) override
+  {
+    time += 1000000;
+    timestamps[query] = time;
+  }
+
+  bool available(GLuint) override { return ready; }
+
+  uint64_t result(const GLuint query) override { return timestamps[query]; }
+
+  GLuint generated = 0;
+  size_t destroyed = 0;
+  bool ready = true;
+  uint64_t time = 0;
+  std::map<GLuint, uint64_t> timestamps;
+};
+
+/// Finds a profiler's latest sample by name
+float sample(const FrameProfiler& profiler, const char* name)
+{
+  for (const auto& entry : profiler.samples())
+  {
+    if (std::strcmp(entry.first, name) == 0)
+    {
+      return entry.second.front();
+    }
+  }
+
+  return -1;
+}
+} // end of anonymous namespace
+
+TEST_CASE("GpuProfiler", "[gpu_profiler]")
+{
+  FakeQueryBackend backend;
+  GpuProfiler gpu{2, backend};
+  FrameProfiler profiler;
+
+  SECTION("Reads a frame back once the latency has passed")
+  {
+    gpu.begin("Draw");
+    gpu.end();
+    gpu.end_frame(profiler);
+    gpu.end_frame(profiler);
+
+    REQUIRE(profiler.samples().empty());
+
+    gpu.end_frame(profiler);
+
+    REQUIRE(sample(profiler, "Draw") == Approx(1));
+  }
+
+  SECTION("Times nested scopes")
+  {
+    gpu.begin("Outer");
+    gpu.begin("Inner");
+    gpu.end();
+    gpu.end();
+
+    for (int i = 0; i < 3; i++)
+    {
+      gpu.end_frame(profiler);
+    }
+
+    REQUIRE(sample(profiler, "Outer") == Approx(3));
+    REQUIRE(sample(profiler, "Inner") == Approx(1));
+  }
+
+  SECTION("Ends the scopes left open with the frame")
+  {
+    gpu.begin("Draw");
+
+    for (int i = 0; i < 3; i++)
+    {
+      gpu.end_frame(profiler);
+    }
+
+    REQUIRE(sample(profiler, "Draw") == Approx(1));
+  }
+
+  SECTION("Drops frames whose results aren't ready")
+  {
+    backend.ready = false;
+
+    gpu.begin("Draw");
+    gpu.end();
+
+    for (int i = 0; i < 3; i++)
+    {
+      gpu.end_frame(profiler);
+    }
+
+    REQUIRE(gpu.dropped_frames() == 1);
+    REQUIRE(profiler.samples().empty());
+  }
+
+  SECTION("Reuses the queries of frames read back")
+  {
+    for (int i = 0; i < 100; i++)
+    {
+      gpu.begin("Draw");
+      gpu.end();
+      gpu.end_frame(profiler);
+    }
+
+    REQUIRE(backend.generated == 32);
+  }
+
+  SECTION("Only deletes the queries when released")
+  {
+    {
+      GpuProfiler other{2, backend};
+      other.begin("Draw");
+      other.end();
+    }
+
+    REQUIRE(backend.destroyed == 0);
+
+    gpu.begin("Draw");
+    gpu.end();
+    gpu.release();
+
+    REQUIRE(backend.destroyed == 32);
+
+    // The frame in flight went with the queries
+    for (int i = 0; i < 3; i++)
+    {
+      gpu.end_frame(profiler);
+    }
+
+    REQUIRE(profiler.samples().empty());
+  }
+}
@@ -0,0 +1,74 @@
+//
+// mip_chain_tests.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <vector>
+#include "catch.hpp"
+#include "mip_chain.h"
+
+using namespace BarelyEngine;
+
+TEST_CASE("MipChain", "[mip_chain]")
+{
+  SECTION("Counts the levels of a full chain")
+  {
+    REQUIRE(MipChain::level_count(1, 1) == 1);
+    REQUIRE(MipChain::level_count(256, 256) == 9);
+    REQUIRE(MipChain::level_count(256, 16) == 9);
+    REQUIRE(MipChain::level_count(5, 3) == 3);
+  }
+
+  SECTION("Generates every level down to 1x1")
+  {
+    const std::vector<uint8_t> pixels(16 * 4 * 4, 0);
+    const auto levels = MipChain::generate(pixels.data(), 16, 4);
+
+    REQUIRE(levels.size() == 4);
+    REQUIRE(levels[0].width == 8);
+    REQUIRE(levels[0].height == 2);
+    REQUIRE(levels[1].width == 4);
+    REQUIRE(levels[1].height == 1);
+    REQUIRE(levels[3].width == 1);
+    REQUIRE(levels[3].height == 1);
+    REQUIRE(levels[3].pixels.size() == 4);
+  }
+
+  SECTION("Box filter averages each 2x2 square")
+  {
+    // A 2x2 image of black, white, white, black (with varying alpha)
+    const std::vector<uint8_t> pixels = {0,   0,   0,   255, 255, 255, 255, 0,
+                                         255, 255, 255, 0,   0,   0,   0,   255};
+    const auto levels = MipChain::generate(pixels.data(), 2, 2, MipFilter::BOX);
+
+    const std::vector<uint8_t> expected = {128, 128, 128, 128};
+    REQUIRE(levels.size() == 1);
+    REQUIRE(levels[0].pixels == expected);
+  }
+
+  SECTION("Both filters keep a solid color unchanged")
+  {
+    std::vector<uint8_t> pixels;
+
+    for (int i = 0; i < 8 * 8; i++)
+    {
+      pixels.insert(pixels.end(), {10, 100, 200, 255});
+    }
+
+    for (const auto filter : {MipFilter::BOX, MipFilter::KAISER})
+    {
+      const auto levels = MipChain::generate(pixels.data(), 8, 8, filter);
+
+      for (const auto& level : levels)
+      {
+        for (size_t i = 0; i < level.pixels.size(); i += 4)
+        {
+          REQUIRE(level.pixels[i] == 10);
+          REQUIRE(level.pixels[i + 1] == 100);
+          REQUIRE(level.pixels[i + 2] == 200);
+          REQUIRE(level.pixels[i + 3] == 255);
+        }
+      }
+    }
+  }
+}
@@ -0,0 +1,130 @@
+//
+// pixel_convert_tests.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <stdint.h>
+#include <cstring>
+#include <vector>
+#include "catch.hpp"
+#include "pixel_convert.h"
+
+using namespace BarelyEngine;
+
+/// Enough pixels to go through the vectorised loops and the leftovers
+static const size_t kPixelCount = 37;
+
+std::vector<uint8_t> make_pixels(size_t bytes_per_pixel)
+{
+  std::vector<uint8_t> pixels(kPixelCount * bytes_per_pixel);
+
+  for (size_t i = 0; i < pixels.size(); i++)
+  {
+    pixels[i] = static_cast<uint8_t>(i * 37 + 11);
+  }
+
+  return pixels;
+}
+
+TEST_CASE("PixelConvert", "[pixel_convert]")
+{
+  SECTION("Expands RGB to RGBA with opaque alpha")
+  {
+    const auto source = make_pixels(3);
+    std::vector<uint8_t> target(kPixelCount * 4);
+
+    PixelConvert::expand_rgb(source.data(), target.data(), kPixelCount);
+
+    bool correct = true;
+
+    for (size_t i = 0; i < kPixelCount; i++)
+    {
+      correct = correct && target[i * 4] == source[i * 3];
+      correct = correct && target[i * 4 + 1] == source[i * 3 + 1];
+      correct = correct && target[i * 4 + 2] == source[i * 3 + 2];
+      correct = correct && target[i * 4 + 3] == 0xFF;
+    }
+
+    REQUIRE(correct);
+  }
+
+  SECTION("Expands palette indices using the palette")
+  {
+    const std::vector<uint8_t> source = {0, 2, 1, 2};
+    std::vector<uint32_t> palette(256, 0);
+    const uint8_t colors[] = {1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12};
+    std::memcpy(palette.data(), colors, sizeof(colors));
+    std::vector<uint8_t> target(source.size() * 4);
+
+    PixelConvert::expand_palette(source.data(), target.data(), source.size(), palette.data());
+
+    const std::vector<uint8_t> expected = {1, 2, 3, 4, 9, 10, 11, 12, 5, 6, 7, 8, 9, 10, 11, 12};
+
+    REQUIRE(target == expected);
+  }
+
+  SECTION("Swaps red and blue in place")
+  {
+    const auto original = make_pixels(4);
+    auto pixels = original;
+
+    PixelConvert::swap_red_blue(pixels.data(), kPixelCount);
+
+    bool correct = true;
+
+    for (size_t i = 0; i < kPixelCount; i++)
+    {
+      correct = correct && pixels[i * 4] == original[i * 4 + 2];
+      correct = correct && pixels[i * 4 + 1] == original[i * 4 + 1];
+      correct = correct && pixels[i * 4 + 2] == original[i * 4];
+      correct = correct && pixels[i * 4 + 3] == original[i * 4 + 3];
+    }
+
+    REQUIRE(correct);
+  }
+
+  SECTION("Moves alpha from first to last in place")
+  {
+    const auto original = make_pixels(4);
+    auto pixels = original;
+
+    PixelConvert::move_alpha_last(pixels.data(), kPixelCount);
+
+    bool correct = true;
+
+    for (size_t i = 0; i < kPixelCount; i++)
+    {
+      correct = correct && pixels[i * 4] == original[i * 4 + 1];
+      correct = correct && pixels[i * 4 + 1] == original[i * 4 + 2];
+      correct = correct && pixels[i * 4 + 2] == original[i * 4 + 3];
+      correct = correct && pixels[i * 4 + 3] == original[i * 4];
+    }
+
+    REQUIRE(correct);
+  }
+
+  SECTION("Premultiplies alpha with correct rounding, keeping alpha")
+  {
+    const auto original = make_pixels(4);
+    auto pixels = original;
+
+    PixelConvert::premultiply_alpha(pixels.data(), kPixelCount);
+
+    bool correct = true;
+
+    for (size_t i = 0; i < kPixelCount; i++)
+    {
+      const auto alpha = original[i * 4 + 3];
+
+      for (size_t c = 0; c < 3; c++)
+      {
+        const auto expected = static_cast<uint8_t>((original[i * 4 + c] * alpha + 127) / 255);
+        correct = correct && pixels[i * 4 + c] == expected;
+      }
+
+      correct = correct && pixels[i * 4 + 3] == alpha;
+    }
+
+    REQUIRE(correct);
+  }
+}
@@ -3,7 +3,9 @@
 // Copyright (c) 2015 Adam Ransom
 //
 
+#include <cstring>
 #include <memory>
+#include <vector>
 #include <SDL2/SDL.h>
 #include <OpenGL/gl3.h>
 #include "catch.hpp"
@@ -13,11 +15,11 @@
 using namespace BarelyEngine;
 using namespace fakeit;
 
-SDL_Surface* create_surface(uint32_t format)
+SDL_Surface* create_surface(uint32_t format, int width = 0, int height = 0)
 {
   auto pixel_format = SDL_AllocFormat(format);
   auto surface =
-    SDL_CreateRGBSurface(0, 0, 0, pixel_format->BitsPerPixel, pixel_format->Rmask,
+    SDL_CreateRGBSurface(0, width, height, pixel_format->BitsPerPixel, pixel_format->Rmask,
                          pixel_format->Gmask, pixel_format->Bmask, pixel_format->Amask);
   SDL_FreeFormat(pixel_format);
 
@@ -55,6 +57,69 @@ TEST_CASE("PixelData", "[pixel_data]")
     COMPARE_FORMAT(SDL_PIXELFORMAT_BGRA8888, GL_FALSE);
   }
 
+  SECTION("Expands 24-bit pixels to 4 bytes when prepared")
+  {
+    const auto surface = create_surface(SDL_PIXELFORMAT_RGB24, 3, 2);
+    const auto pixels = static_cast<uint8_t*>(surface->pixels);
+
+    for (int y = 0; y < 2; y++)
+    {
+      for (int i = 0; i < 9; i++)
+      {
+        pixels[y * surface->pitch + i] = static_cast<uint8_t>(y * 9 + i);
+      }
+    }
+
+    PixelData pixel_data{surface};
+    pixel_data.prepare();
+
+    const std::vector<uint8_t> expected = {0,  1,  2,  255, 3,  4,  5,  255, 6,  7,  8,  255,
+                                           9,  10, 11, 255, 12, 13, 14, 255, 15, 16, 17, 255};
+    const auto prepared = static_cast<uint8_t*>(pixel_data.pixels());
+
+    REQUIRE(pixel_data.format() == GL_RGBA);
+    REQUIRE(std::vector<uint8_t>(prepared, prepared + expected.size()) == expected);
+
+    SDL_FreeSurface(surface);
+  }
+
+  SECTION("Converts formats with alpha first in place when prepared")
+  {
+    const auto surface = create_surface(SDL_PIXELFORMAT_RGBA8888, 2, 1);
+    const uint32_t colors[] = {0x11223344, 0x55667788};
+    std::memcpy(surface->pixels, colors, sizeof(colors));
+
+    PixelData pixel_data{surface};
+    pixel_data.prepare();
+
+    const std::vector<uint8_t> expected = {0x33, 0x22, 0x11, 0x44, 0x77, 0x66, 0x55, 0x88};
+    const auto prepared = static_cast<uint8_t*>(pixel_data.pixels());
+
+    REQUIRE(pixel_data.format() == GL_BGRA);
+    REQUIRE(prepared == surface->pixels);
+    REQUIRE(std::vector<uint8_t>(prepared, prepared + expected.size()) == expected);
+
+    SDL_FreeSurface(surface);
+  }
+
+  SECTION("Premultiplies alpha when requested")
+  {
+    const auto surface = create_surface(SDL_PIXELFORMAT_ARGB8888, 1, 1);
+    const uint32_t color = 0x80FF4000;
+    std::memcpy(surface->pixels, &color, sizeof(color));
+
+    PixelData pixel_data{surface};
+    pixel_data.prepare(true);
+
+    const std::vector<uint8_t> expected = {0x00, 0x20, 0x80, 0x80};
+    const auto prepared = static_cast<uint8_t*>(pixel_data.pixels());
+
+    REQUIRE(pixel_data.format() == GL_BGRA);
+    REQUIRE(std::vector<uint8_t>(prepared, prepared + expected.size()) == expected);
+
+    SDL_FreeSurface(surface);
+  }
+
   SECTION("Throws exception if given null surface")
   {
     REQUIRE_THROWS(PixelData(nullptr));
@@ -0,0 +1,147 @@
+//
+// quad_generator_tests.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <cstring>
+#include <vector>
+#include "catch.hpp"
+#include "quad_generator.h"
+#include "textured_quad.h"
+
+using namespace BarelyEngine;
+
+namespace {
+/**
+ * @brief Checks two runs of floats have exactly the same bits
+ */
+bool identical(const std::vector<float>& a, const std::vector<float>& b)
+{
+  return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(float)) == 0;
+}
+} // end of anonymous namespace
+
+TEST_CASE("Quad generation", "[quad_generator]")
+{
+  // Enough quads for the SIMD path, with some left over for the scalar path
+  const size_t count = 11;
+  std::vector<float> x, y, w, h, texture_w, texture_h;
+  std::vector<int32_t> clip_x, clip_y, clip_w, clip_h;
+  std::vector<uint8_t> r, g, b;
+
+  for (size_t i = 0; i < count; i++)
+  {
+    x.push_back(i * 13.7f - 40);
+    y.push_back(i * 0.3f);
+    w.push_back(10 + i);
+    h.push_back(7.25f * i);
+    clip_x.push_back(static_cast<int32_t>(i * 3));
+    clip_y.push_back(static_cast<int32_t>(i * 5));
+    clip_w.push_back(static_cast<int32_t>(7 + i));
+    clip_h.push_back(static_cast<int32_t>(9 + i));
+    texture_w.push_back(97.0f + i);
+    texture_h.push_back(211.0f);
+    r.push_back(static_cast<uint8_t>(i * 23));
+    g.push_back(static_cast<uint8_t>(255 - i * 7));
+    b.push_back(static_cast<uint8_t>(i * 101));
+  }
+
+  QuadArrays quads;
+  quads.count = count;
+  quads.x = x.data();
+  quads.y = y.data();
+  quads.w = w.data();
+  quads.h = h.data();
+  quads.r = r.data();
+  quads.g = g.data();
+  quads.b = b.data();
+
+  std::vector<float> vertices(count * QuadGenerator::kFloatsPerQuad);
+
+  SECTION("Matches TexturedQuad when using the whole texture")
+  {
+    QuadGenerator::generate(quads, vertices.data());
+
+    std::vector<float> expected;
+
+    for (size_t i = 0; i < count; i++)
+    {
+      TexturedQuad tq{x[i], y[i], w[i], h[i], 0, 0, nullptr, Color{r[i], g[i], b[i]}};
+      expected.insert(expected.end(), tq.vertices().begin(), tq.vertices().end());
+    }
+
+    REQUIRE(identical(vertices, expected));
+  }
+
+  SECTION("Matches the per-quad calculation when using clips")
+  {
+    quads.clip_x = clip_x.data();
+    quads.clip_y = clip_y.data();
+    quads.clip_w = clip_w.data();
+    quads.clip_h = clip_h.data();
+    quads.texture_w = texture_w.data();
+    quads.texture_h = texture_h.data();
+
+    QuadGenerator::generate(quads, vertices.data());
+
+    std::vector<float> expected;
+
+    for (size_t i = 0; i < count; i++)
+    {
+      const float u1 = clip_x[i] / texture_w[i];
+      const float v1 = clip_y[i] / texture_h[i];
+      const float u2 = (clip_x[i] + clip_w[i]) / texture_w[i];
+      const float v2 = (clip_y[i] + clip_h[i]) / texture_h[i];
+      const float red = r[i] / 255.0f;
+      const float green = g[i] / 255.0f;
+      const float blue = b[i] / 255.0f;
+
+      const std::vector<float> quad = {
+        x[i], y[i], 0, u1, v1, red, green, blue,               // Top-Left
+        x[i] + w[i], y[i], 0, u2, v1, red, green, blue,        // Top-Right
+        x[i], y[i] + h[i], 0, u1, v2, red, green, blue,        // Bottom-Left
+        x[i] + w[i], y[i], 0, u2, v1, red, green, blue,        // Top-Right
+        x[i], y[i] + h[i], 0, u1, v2, red, green, blue,        // Bottom-Left
+        x[i] + w[i], y[i] + h[i], 0, u2, v2, red, green, blue  // Bottom-Right
+      };
+
+      expected.insert(expected.end(), quad.begin(), quad.end());
+    }
+
+    REQUIRE(identical(vertices, expected));
+  }
+
+  SECTION("Puts the texture array layer in z")
+  {
+    std::vector<float> layers(count, 3.0f);
+    quads.layer = layers.data();
+
+    QuadGenerator::generate(quads, vertices.data());
+
+    for (size_t i = 2; i < vertices.size(); i += 8)
+    {
+      REQUIRE(vertices[i] == 3.0f);
+    }
+  }
+  SECTION("Only generates the quads which pass the test")
+  {
+    // Quads 1, 2 and 9 are left out, splitting the rest into runs
+    const auto generated = QuadGenerator::generate_visible(quads, vertices.data(),
+                                                           [&](const Rect& bounds) {
+      return bounds.x != x[1] && bounds.x != x[2] && bounds.x != x[9];
+    });
+
+    std::vector<float> expected;
+
+    for (const auto i : {0, 3, 4, 5, 6, 7, 8, 10})
+    {
+      TexturedQuad tq{x[i], y[i], w[i], h[i], 0, 0, nullptr, Color{r[i], g[i], b[i]}};
+      expected.insert(expected.end(), tq.vertices().begin(), tq.vertices().end());
+    }
+
+    vertices.resize(generated * QuadGenerator::kFloatsPerQuad);
+
+    REQUIRE(generated == 8);
+    REQUIRE(identical(vertices, expected));
+  }
+}
@@ -0,0 +1,174 @@
+//
+// render_command_list_tests.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "catch.hpp"
+#include "render_command_list.h"
+#include "textured_quad.h"
+
+using namespace BarelyEngine;
+
+TEST_CASE("Render command list", "[render_command_list]")
+{
+  RenderCommandList list(4);
+
+  SECTION("Puts each bucket on its own cache lines")
+  {
+    for (size_t i = 0; i < list.bucket_count(); i++)
+    {
+      REQUIRE(reinterpret_cast<uintptr_t>(&list.bucket(i)) % 64 == 0);
+    }
+
+    REQUIRE(sizeof(RenderBucket) % 64 == 0);
+  }
+
+  SECTION("Merges the buckets in key order")
+  {
+    // Each bucket records keys bucket, bucket + 4, ... backwards, on its own
+    // thread, with a single float holding the key to check the vertices follow
+    std::vector<std::thread> threads;
+
+    for (size_t i = 0; i < list.bucket_count(); i++)
+    {
+      threads.emplace_back([&list, i]()
+      {
+        auto& bucket = list.bucket(i);
+
+        for (int key = 96 + static_cast<int>(i); key >= 0; key -= 4)
+        {
+          const float vertex = static_cast<float>(key);
+          bucket.draw(nullptr, static_cast<uint64_t>(key), &vertex, 1);
+        }
+
+        bucket.sort();
+      });
+    }
+
+    for (auto& thread : threads)
+    {
+      thread.join();
+    }
+
+    list.merge();
+
+    REQUIRE(list.size() == 100);
+
+    for (size_t i = 0; i < list.size(); i++)
+    {
+      REQUIRE(list.command(i).key == i);
+      REQUIRE(*list.vertices(i) == static_cast<float>(i));
+    }
+  }
+
+  SECTION("Keeps equal keys in recording and bucket order")
+  {
+    const float vertices[] = {0, 1, 2, 3};
+
+    list.bucket(2).draw(nullptr, 5, &vertices[0], 1);
+    list.bucket(0).draw(nullptr, 5, &vertices[1], 1);
+    list.bucket(0).draw(nullptr, 1, &vertices[2], 1);
+    list.bucket(0).draw(nullptr, 5, &vertices[3], 1);
+
+    list.merge();
+
+    REQUIRE(list.size() == 4);
+    REQUIRE(*list.vertices(0) == 2);
+    REQUIRE(*list.vertices(1) == 1);
+    REQUIRE(*list.vertices(2) == 3);
+    REQUIRE(*list.vertices(3) == 0);
+  }
+
+  SECTION("Generates quads into a bucket")
+  {
+    const float x[] = {0, 10};
+    const float y[] = {0, 20};
+    const float size[] = {5, 5};
+
+    QuadArrays quads;
+    quads.count = 2;
+    quads.x = x;
+    quads.y = y;
+    quads.w = size;
+    quads.h = size;
+
+    list.bucket(1).draw_quads(nullptr, 0, quads);
+    list.merge();
+
+    std::vector<float> expected(2 * QuadGenerator::kFloatsPerQuad);
+    QuadGenerator::generate(quads, expected.data());
+
+    REQUIRE(list.size() == 1);
+    REQUIRE(list.command(0).count == expected.size());
+    REQUIRE(std::equal(expected.begin(), expected.end(), list.vertices(0)));
+  }
+
+  SECTION("Culls elements and quads outside of the viewport")
+  {
+    const float x[] = {0, 500, 10};
+    const float y[] = {0, 500, 20};
+    const float size[] = {5, 5, 5};
+
+    QuadArrays quads;
+    quads.count = 3;
+    quads.x = x;
+    quads.y = y;
+    quads.w = size;
+    quads.h = size;
+
+    TexturedQuad inside{10, 10, 20, 20, 0, 0, nullptr};
+    TexturedQuad outside{500, 500, 20, 20, 0, 0, nullptr};
+
+    list.set_viewport({0, 0, 100, 100});
+    list.bucket(0).draw_quads(nullptr, 0, quads);
+    list.bucket(0).draw(&inside);
+    list.bucket(0).draw(&outside);
+    list.merge();
+
+    std::vector<float> expected(QuadGenerator::kFloatsPerQuad);
+    QuadGenerator::generate(quads.slice(0, 1), expected.data());
+    std::vector<float> last(QuadGenerator::kFloatsPerQuad);
+    QuadGenerator::generate(quads.slice(2, 1), last.data());
+    expected.insert(expected.end(), last.begin(), last.end());
+
+    REQUIRE(list.size() == 2);
+    REQUIRE(list.command(0).count == expected.size());
+    REQUIRE(std::equal(expected.begin(), expected.end(), list.vertices(0)));
+    REQUIRE(list.bucket(0).culled_count() == 2);
+  }
+
+  SECTION("Records nothing for quads which are all culled")
+  {
+    const float position[] = {500};
+    const float size[] = {5};
+
+    QuadArrays quads;
+    quads.count = 1;
+    quads.x = position;
+    quads.y = position;
+    quads.w = size;
+    quads.h = size;
+
+    list.bucket(2).set_viewport({0, 0, 100, 100});
+    list.bucket(2).draw_quads(nullptr, 0, quads);
+
+    REQUIRE(list.bucket(2).size() == 0);
+    REQUIRE(list.bucket(2).vertex_count() == 0);
+  }
+
+  SECTION("Clearing removes every command")
+  {
+    const float vertex = 0;
+    list.bucket(3).draw(nullptr, 0, &vertex, 1);
+    list.merge();
+    list.clear();
+    list.merge();
+
+    REQUIRE(list.size() == 0);
+    REQUIRE(list.bucket(3).vertex_count() == 0);
+  }
+}
@@ -0,0 +1,65 @@
+//
+// render_stats_tests.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <cstring>
+#include "catch.hpp"
+#include "frame_profiler.h"
+#include "render_stats.h"
+
+using namespace BarelyEngine;
+
+namespace {
+/// Finds a profiler's latest sample by name
+float sample(const FrameProfiler& profiler, const char* name)
+{
+  for (const auto& entry : profiler.samples())
+  {
+    if (std::strcmp(entry.first, name) == 0)
+    {
+      return entry.second.front();
+    }
+  }
+
+  return -1;
+}
+} // end of anonymous namespace
+
+TEST_CASE("RenderStats", "[render_stats]")
+{
+  RenderStats stats;
+
+  SECTION("Counts flushes by reason")
+  {
+    stats.add_flush(FlushReason::TEXTURE_CHANGE);
+    stats.add_flush(FlushReason::TEXTURE_CHANGE);
+    stats.add_flush(FlushReason::END);
+
+    REQUIRE(stats.flush_count(FlushReason::TEXTURE_CHANGE) == 2);
+    REQUIRE(stats.flush_count(FlushReason::BATCH_FULL) == 0);
+    REQUIRE(stats.flush_count(FlushReason::END) == 1);
+  }
+
+  SECTION("Reports every counter to the profiler, then resets")
+  {
+    FrameProfiler profiler;
+
+    stats.draw_calls = 3;
+    stats.texture_binds_skipped = 7;
+    stats.vertex_bytes = 2048;
+    stats.add_flush(FlushReason::BATCH_FULL);
+
+    stats.end_frame(profiler);
+
+    REQUIRE(profiler.samples().size() == 10);
+    REQUIRE(sample(profiler, "Draw calls") == 3);
+    REQUIRE(sample(profiler, "Texture binds skipped") == 7);
+    REQUIRE(sample(profiler, "Vertex KB uploaded") == 2);
+    REQUIRE(sample(profiler, "Flushes (batch full)") == 1);
+
+    REQUIRE(stats.draw_calls == 0);
+    REQUIRE(stats.vertex_bytes == 0);
+    REQUIRE(stats.flush_count(FlushReason::BATCH_FULL) == 0);
+  }
+}
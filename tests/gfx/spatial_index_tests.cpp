@@ -0,0 +1,239 @@
+//
+// spatial_index_tests.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "catch.hpp"
+#include "loose_quadtree.h"
+#include "spatial_hash_grid.h"
+#include "exception.h"
+
+using namespace BarelyEngine;
+
+namespace {
+/**
+ * @brief Finds the items overlapping an area by testing every one
+ */
+std::vector<int> brute_force(const std::vector<Rect>& bounds, const std::vector<bool>& alive,
+                             const Rect& area)
+{
+  std::vector<int> found;
+
+  for (size_t i = 0; i < bounds.size(); i++)
+  {
+    if (alive[i] && bounds[i].intersects(area))
+    {
+      found.push_back(static_cast<int>(i));
+    }
+  }
+
+  return found;
+}
+
+/**
+ * @brief Inserts, moves and removes random items, checking every query
+ *        against a brute force search
+ */
+template <typename Index>
+void check_against_brute_force(Index& index)
+{
+  std::mt19937 random{42};
+  std::uniform_real_distribution<float> position{-200, 1200};
+  std::uniform_real_distribution<float> size{0, 40};
+  std::uniform_real_distribution<float> large_size{0, 600};
+
+  const auto random_rect = [&](const bool large)
+  {
+    return Rect{position(random), position(random), large ? large_size(random) : size(random),
+                large ? large_size(random) : size(random)};
+  };
+
+  std::vector<Rect> bounds;
+  std::vector<bool> alive;
+  std::vector<typename Index::Handle> handles;
+
+  for (int i = 0; i < 500; i++)
+  {
+    bounds.push_back(random_rect(i % 50 == 0));
+    alive.push_back(true);
+    handles.push_back(index.insert(i, bounds.back()));
+  }
+
+  for (int round = 0; round < 4; round++)
+  {
+    for (int i = 0; i < 500; i += 3)
+    {
+      if (alive[i])
+      {
+        bounds[i] = random_rect(false);
+        index.move(handles[i], bounds[i]);
+      }
+    }
+
+    for (int i = round; i < 500; i += 37)
+    {
+      if (alive[i])
+      {
+        alive[i] = false;
+        index.remove(handles[i]);
+      }
+    }
+
+    if (round == 2)
+    {
+      index.rebuild();
+    }
+
+    for (int query = 0; query < 20; query++)
+    {
+      const auto area = random_rect(query % 2 == 0);
+      std::vector<int> found;
+      index.query(area, found);
+      std::sort(found.begin(), found.end());
+
+      REQUIRE(found == brute_force(bounds, alive, area));
+    }
+  }
+}
+} // end of anonymous namespace
+
+TEST_CASE("Spatial hash grid", "[spatial_index]")
+{
+  SpatialHashGrid<int> grid{64};
+
+  SECTION("Finds the same items as testing every item")
+  {
+    check_against_brute_force(grid);
+  }
+
+  SECTION("Picks the items under a point")
+  {
+    grid.insert(1, {0, 0, 10, 10});
+    grid.insert(2, {5, 5, 100, 100});
+    std::vector<int> found;
+
+    grid.query(7, 7, found);
+    std::sort(found.begin(), found.end());
+
+    REQUIRE(found == (std::vector<int>{1, 2}));
+  }
+
+  SECTION("Reuses the handles of removed items")
+  {
+    const auto handle = grid.insert(1, {0, 0, 10, 10});
+    grid.remove(handle);
+
+    REQUIRE(grid.insert(2, {0, 0, 10, 10}) == handle);
+    REQUIRE(grid.size() == 1);
+  }
+
+  SECTION("Finds items far bigger than a cell")
+  {
+    grid.insert(1, {-1e30f, -1e30f, 2e30f, 2e30f});
+    grid.insert(2, {0, 0, 10, 10});
+    std::vector<int> found;
+
+    grid.query({100, 100, 10, 10}, found);
+    REQUIRE(found == (std::vector<int>{1}));
+
+    found.clear();
+    grid.query({-1e20f, -1e20f, 2e20f, 2e20f}, found);
+    std::sort(found.begin(), found.end());
+    REQUIRE(found == (std::vector<int>{1, 2}));
+  }
+
+  SECTION("Rejects cells without a positive size")
+  {
+    REQUIRE_THROWS_AS(SpatialHashGrid<int>(0), Exception);
+    REQUIRE_THROWS_AS(SpatialHashGrid<int>(-1), Exception);
+    REQUIRE_THROWS_AS(SpatialHashGrid<int>(NAN), Exception);
+    REQUIRE_THROWS_AS(grid.rebuild(-1), Exception);
+  }
+
+  SECTION("Rejects bounds which aren't finite")
+  {
+    REQUIRE_THROWS_AS(grid.insert(1, {NAN, 0, 10, 10}), Exception);
+    REQUIRE_THROWS_AS(grid.insert(1, {0, 0, INFINITY, 10}), Exception);
+    REQUIRE(grid.size() == 0);
+  }
+}
+
+TEST_CASE("Loose quadtree", "[spatial_index]")
+{
+  LooseQuadtree<int> tree{{0, 0, 1000, 1000}, 6};
+
+  SECTION("Finds the same items as testing every item")
+  {
+    check_against_brute_force(tree);
+  }
+
+  SECTION("Picks the items under a point")
+  {
+    tree.insert(1, {0, 0, 10, 10});
+    tree.insert(2, {5, 5, 100, 100});
+    tree.insert(3, {-500, -500, 2000, 2000});
+    std::vector<int> found;
+
+    tree.query(7, 7, found);
+    std::sort(found.begin(), found.end());
+
+    REQUIRE(found == (std::vector<int>{1, 2, 3}));
+  }
+
+  SECTION("Finds items after the area changes")
+  {
+    tree.insert(1, {1500, 1500, 10, 10});
+    tree.rebuild({1000, 1000, 1000, 1000});
+    std::vector<int> found;
+
+    tree.query({1490, 1490, 20, 20}, found);
+
+    REQUIRE(found == (std::vector<int>{1}));
+  }
+
+  SECTION("Finds nothing for areas which aren't finite")
+  {
+    tree.insert(1, {0, 0, 10, 10});
+    std::vector<int> found;
+
+    tree.query({NAN, 0, 10, 10}, found);
+    tree.query({0, 0, INFINITY, 10}, found);
+
+    REQUIRE(found.empty());
+  }
+
+  SECTION("Finds items with huge query areas")
+  {
+    tree.insert(1, {0, 0, 10, 10});
+    tree.insert(2, {900, 900, 10, 10});
+    std::vector<int> found;
+
+    tree.query({-3e38f, -3e38f, 3.4e38f, 3.4e38f}, found);
+    tree.query({1e30f, 1e30f, 10, 10}, found);
+    std::sort(found.begin(), found.end());
+
+    REQUIRE(found == (std::vector<int>{1, 2}));
+  }
+
+  SECTION("Rejects areas which can't be split into nodes")
+  {
+    REQUIRE_THROWS_AS((LooseQuadtree<int>{{0, 0, 0, 1000}, 6}), Exception);
+    REQUIRE_THROWS_AS((LooseQuadtree<int>{{0, 0, NAN, 1000}, 6}), Exception);
+    REQUIRE_THROWS_AS((LooseQuadtree<int>{{INFINITY, 0, 1000, 1000}, 6}), Exception);
+  }
+
+  SECTION("Clamps the depth")
+  {
+    LooseQuadtree<int> deep{{0, 0, 1000, 1000}, 30};
+    deep.insert(1, {500, 500, 0.001f, 0.001f});
+    std::vector<int> found;
+
+    deep.query({499, 499, 2, 2}, found);
+
+    REQUIRE(found == (std::vector<int>{1}));
+  }
+}
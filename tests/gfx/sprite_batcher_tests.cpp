@@ -0,0 +1,40 @@
+//
+// sprite_batcher_tests.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include "catch.hpp"
+#include "sprite_batcher.h"
+
+using namespace BarelyEngine;
+
+TEST_CASE("Sprite instances", "[sprite_batcher]")
+{
+  Color blue{0, 0, 255};
+
+  SECTION("Uses the whole texture")
+  {
+    const auto sprite = make_sprite(0, 1, 10, 20, 3, nullptr);
+
+    REQUIRE(sprite.x == 0);
+    REQUIRE(sprite.y == 1);
+    REQUIRE(sprite.w == 10);
+    REQUIRE(sprite.h == 20);
+    REQUIRE(sprite.u0 == 0);
+    REQUIRE(sprite.v0 == 0);
+    REQUIRE(sprite.u1 == 65535);
+    REQUIRE(sprite.v1 == 65535);
+    REQUIRE(sprite.texture_layer == 0);
+    REQUIRE(sprite.depth == 3);
+  }
+
+  SECTION("Tints with the color")
+  {
+    const auto sprite = make_sprite(0, 1, 10, 20, 0, nullptr, blue);
+
+    REQUIRE(sprite.r == 0);
+    REQUIRE(sprite.g == 0);
+    REQUIRE(sprite.b == 255);
+    REQUIRE(sprite.a == 255);
+  }
+}
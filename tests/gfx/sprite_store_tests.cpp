@@ -0,0 +1,122 @@
+//
+// sprite_store_tests.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <cstring>
+#include <vector>
+#include "catch.hpp"
+#include "sprite_store.h"
+#include "textured_quad.h"
+
+using namespace BarelyEngine;
+
+namespace {
+Sprite make(const float x, const uint8_t layer = 0, const uint8_t depth = 0)
+{
+  Sprite sprite;
+  sprite.x = x;
+  sprite.y = x / 2;
+  sprite.w = 10;
+  sprite.h = 20;
+  sprite.layer = layer;
+  sprite.depth = depth;
+
+  return sprite;
+}
+} // end of anonymous namespace
+
+TEST_CASE("Sprite store", "[sprite_store]")
+{
+  SpriteStore store;
+
+  SECTION("Keeps ids when other sprites are removed")
+  {
+    std::vector<SpriteStore::Id> ids;
+    store.add({make(0), make(1), make(2), make(3), make(4)}, ids);
+
+    store.remove(std::vector<SpriteStore::Id>{ids[0], ids[3]});
+
+    REQUIRE(store.size() == 3);
+    REQUIRE(store.x()[store.index(ids[1])] == 1);
+    REQUIRE(store.x()[store.index(ids[2])] == 2);
+    REQUIRE(store.x()[store.index(ids[4])] == 4);
+  }
+
+  SECTION("Reuses the ids of removed sprites")
+  {
+    const auto id = store.add(make(0));
+    store.remove(id);
+
+    REQUIRE(store.add(make(1)) == id);
+    REQUIRE(store.size() == 1);
+  }
+
+  SECTION("Skips ids which were already removed")
+  {
+    std::vector<SpriteStore::Id> ids;
+    store.add({make(0), make(1), make(2), make(3)}, ids);
+
+    store.remove(ids[3]);
+    store.remove(ids[3]);
+    store.remove(std::vector<SpriteStore::Id>{ids[0], ids[0], ids[3]});
+
+    REQUIRE(store.size() == 2);
+    REQUIRE_FALSE(store.contains(ids[0]));
+    REQUIRE_FALSE(store.contains(ids[3]));
+    REQUIRE(store.x()[store.index(ids[1])] == 1);
+    REQUIRE(store.x()[store.index(ids[2])] == 2);
+
+    // Each id is only freed once
+    REQUIRE(store.add(make(4)) != store.add(make(5)));
+  }
+
+  SECTION("Ignores changes to sprites which were removed")
+  {
+    const auto removed = store.add(make(0));
+    const auto kept = store.add(make(1));
+
+    store.remove(removed);
+    store.set_position(removed, 7, 8);
+    store.set_color(removed, Color{1, 2, 3});
+    store.set_position(99, 7, 8);
+
+    REQUIRE(store.size() == 1);
+    REQUIRE(store.x()[store.index(kept)] == 1);
+  }
+
+  SECTION("Sorts by layer then depth, keeping ids")
+  {
+    const auto back = store.add(make(0, 2, 0));
+    const auto front = store.add(make(1, 3, 0));
+    const auto middle = store.add(make(2, 2, 5));
+
+    store.set_position(middle, 7, 8);
+    store.sort();
+
+    REQUIRE(store.index(back) == 0);
+    REQUIRE(store.index(middle) == 1);
+    REQUIRE(store.index(front) == 2);
+    REQUIRE(store.x()[1] == 7);
+    REQUIRE(store.y()[1] == 8);
+    REQUIRE(std::is_sorted(store.sort_keys().begin(), store.sort_keys().end()));
+  }
+
+  SECTION("Generates the same vertices as TexturedQuad")
+  {
+    Color blue{0, 0, 255};
+    auto sprite = make(3);
+    sprite.color = blue;
+    store.add(sprite);
+    store.add(make(5));
+
+    std::vector<float> vertices(2 * QuadGenerator::kFloatsPerQuad);
+    QuadGenerator::generate(store.quads(0, 2), vertices.data());
+
+    std::vector<float> expected = TexturedQuad{3, 1.5f, 10, 20, 0, 0, nullptr, blue}.vertices();
+    const auto second = TexturedQuad{5, 2.5f, 10, 20, 0, 0, nullptr}.vertices();
+    expected.insert(expected.end(), second.begin(), second.end());
+
+    REQUIRE(std::memcmp(vertices.data(), expected.data(), vertices.size() * sizeof(float)) == 0);
+  }
+}
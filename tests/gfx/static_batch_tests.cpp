@@ -0,0 +1,87 @@
+//
+// static_batch_tests.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <vector>
+#include "catch.hpp"
+#include "static_batch.h"
+#include "render_element.h"
+
+using namespace BarelyEngine;
+
+TEST_CASE("Static batch baking", "[static_batch]")
+{
+  RenderElement first{{1, 2, 3}, 0, 0, {}};
+  RenderElement second{{4, 5}, 0, 1, {}};
+  RenderElement empty{{}, 0, 2, {}};
+  std::vector<const RenderElement*> elements{&first, &second};
+
+  SECTION("Hashes the same elements the same")
+  {
+    REQUIRE(StaticBatch::hash(elements) == StaticBatch::hash({&first, &second}));
+  }
+
+  SECTION("Hashes differently once the vertices change")
+  {
+    const auto before = StaticBatch::hash(elements);
+    second.set_vertices({4, 6});
+
+    REQUIRE(StaticBatch::hash(elements) != before);
+  }
+
+  SECTION("Hashes differently once the elements change")
+  {
+    const auto before = StaticBatch::hash(elements);
+
+    REQUIRE(StaticBatch::hash({&first}) != before);
+    REQUIRE(StaticBatch::hash({&second, &first}) != before);
+    REQUIRE(StaticBatch::hash({&first, &second, &empty}) != before);
+  }
+
+  SECTION("Concatenates the vertices")
+  {
+    std::vector<float> vertices;
+    std::vector<StaticBatch::Range> ranges;
+
+    StaticBatch::build_ranges(elements, 1, vertices, ranges);
+
+    REQUIRE(vertices == (std::vector<float>{1, 2, 3, 4, 5}));
+  }
+
+  SECTION("Merges elements using the same texture into one range")
+  {
+    std::vector<float> vertices;
+    std::vector<StaticBatch::Range> ranges;
+
+    StaticBatch::build_ranges(elements, 1, vertices, ranges);
+
+    REQUIRE(ranges.size() == 1);
+    REQUIRE(ranges[0].texture == nullptr);
+    REQUIRE(ranges[0].first == 0);
+    REQUIRE(ranges[0].count == 5);
+  }
+
+  SECTION("Skips elements without vertices")
+  {
+    std::vector<float> vertices;
+    std::vector<StaticBatch::Range> ranges;
+
+    StaticBatch::build_ranges({&empty}, 1, vertices, ranges);
+
+    REQUIRE(vertices.empty());
+    REQUIRE(ranges.empty());
+  }
+
+  SECTION("Replaces what was built before")
+  {
+    std::vector<float> vertices{9, 9};
+    std::vector<StaticBatch::Range> ranges{{nullptr, 0, 2}};
+
+    StaticBatch::build_ranges({&second}, 2, vertices, ranges);
+
+    REQUIRE(vertices == (std::vector<float>{4, 5}));
+    REQUIRE(ranges.size() == 1);
+    REQUIRE(ranges[0].count == 1);
+  }
+}
@@ -66,4 +66,14 @@ TEST_CASE("Vertices", "[textured_quad]")
 
     REQUIRE(tq.vertices() == expected_vertices);
   }
+
+  SECTION("Has bounds covering its vertices")
+  {
+    TexturedQuad tq{5, 1, 10, 20, 0, 0, nullptr};
+
+    REQUIRE(tq.bounds().x == 5);
+    REQUIRE(tq.bounds().y == 1);
+    REQUIRE(tq.bounds().w == 10);
+    REQUIRE(tq.bounds().h == 20);
+  }
 }
@@ -0,0 +1,140 @@
+//
+// job_system_tests.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <atomic>
+#include <numeric>
+#include <vector>
+#include "catch.hpp"
+#include "job_system.h"
+
+using namespace BarelyEngine;
+
+TEST_CASE("JobSystem", "[job_system]")
+{
+  JobSystem jobs{4};
+
+  REQUIRE(jobs.worker_count() == 4);
+
+  SECTION("Runs every job before the counter is done")
+  {
+    std::atomic<int> total{0};
+    JobCounter counter;
+
+    for (int i = 1; i <= 1000; i++)
+    {
+      jobs.run([&total, i]() { total += i; }, &counter);
+    }
+
+    jobs.wait(counter);
+
+    REQUIRE(counter.done());
+    REQUIRE(total == 500500);
+  }
+
+  SECTION("Jobs can schedule and wait on more jobs")
+  {
+    std::atomic<int> total{0};
+    JobCounter counter;
+
+    for (int i = 0; i < 8; i++)
+    {
+      jobs.run([&jobs, &total]()
+      {
+        JobCounter inner;
+
+        for (int j = 0; j < 100; j++)
+        {
+          jobs.run([&total]() { total++; }, &inner);
+        }
+
+        jobs.wait(inner);
+      }, &counter);
+    }
+
+    jobs.wait(counter);
+
+    REQUIRE(total == 800);
+  }
+
+  SECTION("Dependent jobs run once their dependency is done")
+  {
+    std::atomic<int> first_done{0};
+    std::atomic<bool> ordered{true};
+    JobCounter first, second;
+
+    for (int i = 0; i < 50; i++)
+    {
+      jobs.run([&first_done]() { first_done++; }, &first);
+    }
+
+    for (int i = 0; i < 50; i++)
+    {
+      jobs.run_after(first, [&first_done, &ordered]()
+      {
+        if (first_done != 50)
+        {
+          ordered = false;
+        }
+      }, &second);
+    }
+
+    jobs.wait(second);
+
+    REQUIRE(first.done());
+    REQUIRE(ordered);
+  }
+
+  SECTION("Dependent jobs run straight away if their dependency is done")
+  {
+    std::atomic<bool> ran{false};
+    JobCounter done, counter;
+
+    jobs.run_after(done, [&ran]() { ran = true; }, &counter);
+    jobs.wait(counter);
+
+    REQUIRE(ran);
+  }
+
+  SECTION("parallel_for covers every index exactly once")
+  {
+    std::vector<int> visits(10007, 0);
+
+    jobs.parallel_for(visits.size(), 64, [&visits](const size_t begin, const size_t end)
+    {
+      for (auto i = begin; i < end; i++)
+      {
+        visits[i]++;
+      }
+    });
+
+    REQUIRE(std::accumulate(visits.begin(), visits.end(), 0) == 10007);
+    REQUIRE(std::count(visits.begin(), visits.end(), 1) == 10007);
+  }
+
+  SECTION("parallel_for splits evenly without a grain")
+  {
+    std::atomic<int> parts{0};
+
+    jobs.parallel_for(100, 0, [&parts](size_t, size_t) { parts++; });
+
+    REQUIRE(parts == 5);
+  }
+}
+
+TEST_CASE("JobSystem runs queued jobs before stopping", "[job_system]")
+{
+  std::atomic<int> total{0};
+
+  {
+    JobSystem jobs{2};
+
+    for (int i = 0; i < 100; i++)
+    {
+      jobs.run([&total]() { total++; });
+    }
+  }
+
+  REQUIRE(total == 100);
+}
@@ -0,0 +1,74 @@
+//
+// pointer_hash_tests.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <string>
+#include <vector>
+#include "catch.hpp"
+#include "pointer_hash.h"
+
+using namespace BarelyEngine;
+
+TEST_CASE("PointerHash", "[pointer_hash]")
+{
+  PointerHash<const char*, int, 16> hash;
+  const char* key_1 = "Key 1";
+  const char* key_2 = "Key 2";
+
+  SECTION("Hash is empty on initialization")
+  {
+    REQUIRE(hash.size() == 0);
+    REQUIRE(hash.pairs().size() == 0);
+  }
+
+  SECTION("Accessing a new key inserts a default value")
+  {
+    REQUIRE(hash[key_1] == 0);
+    REQUIRE(hash.size() == 1);
+    REQUIRE(hash.pairs()[0].first == key_1);
+  }
+
+  SECTION("Accessing an existing key returns its value")
+  {
+    hash[key_1] = 1;
+    hash[key_2] = 2;
+
+    REQUIRE(hash[key_1] == 1);
+    REQUIRE(hash[key_2] == 2);
+    REQUIRE(hash.size() == 2);
+  }
+
+  SECTION("Pairs are kept in insertion order")
+  {
+    hash[key_2] = 2;
+    hash[key_1] = 1;
+
+    REQUIRE(hash.pairs()[0].first == key_2);
+    REQUIRE(hash.pairs()[1].first == key_1);
+  }
+
+  SECTION("Grows past its initial capacity, keeping every value")
+  {
+    // Closely packed, aligned keys, like string literals
+    std::vector<char> keys(1000 * 8);
+
+    for (int i = 0; i < 1000; i++)
+    {
+      hash[&keys[i * 8]] = i;
+    }
+
+    REQUIRE(hash.size() == 1000);
+    REQUIRE(hash.capacity() * 7 >= hash.size() * 8);
+
+    bool all_found = true;
+
+    for (int i = 0; i < 1000; i++)
+    {
+      all_found = all_found && hash[&keys[i * 8]] == i;
+    }
+
+    REQUIRE(all_found);
+    REQUIRE(hash.size() == 1000);
+  }
+}
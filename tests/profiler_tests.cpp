@@ -36,3 +36,68 @@ TEST_CASE("FrameProfiler::Scope", "[profiler]")
     REQUIRE(sample < 2000);
   }
 }
+
+TEST_CASE("FrameProfiler tick samples", "[profiler]")
+{
+  FrameProfiler profiler;
+  const char* key = "Test";
+
+  SECTION("Converts the tick samples when they're read")
+  {
+    profiler.add_tick_sample(key, 0);
+    profiler.add_tick_sample(key, 0);
+
+    REQUIRE(profiler.samples()[0].second.size() == 2);
+    REQUIRE(profiler.overwritten_tick_samples() == 0);
+  }
+
+  SECTION("Converts the tick samples when read through a const profiler")
+  {
+    profiler.add_tick_sample(key, 0);
+    const auto& reader = profiler;
+
+    REQUIRE(reader.samples()[0].second.size() == 1);
+    REQUIRE(profiler.samples()[0].second.size() == 1);
+  }
+
+  SECTION("Overwrites the oldest tick samples once full")
+  {
+    for (size_t i = 0; i < FrameProfiler::kMaxTickSamples + 3; i++)
+    {
+      profiler.add_tick_sample(key, 0);
+    }
+
+    REQUIRE(profiler.overwritten_tick_samples() == 3);
+
+    profiler.samples();
+    profiler.add_tick_sample(key, 0);
+
+    REQUIRE(profiler.overwritten_tick_samples() == 3);
+  }
+}
+
+TEST_CASE("FrameProfiler queued samples", "[profiler]")
+{
+  FrameProfiler profiler;
+  const char* key = "Test";
+
+  SECTION("Queued samples are only added once collected")
+  {
+    std::thread worker([&profiler, key]() { profiler.queue_sample(key, 5.0f); });
+    worker.join();
+
+    REQUIRE(profiler.samples().size() == 0);
+
+    profiler.collect_queued_samples();
+
+    REQUIRE(profiler.samples()[0].second.front() == 5.0f);
+  }
+
+  SECTION("Queued samples are collected with the frame sample")
+  {
+    profiler.queue_sample(key, 5.0f);
+    profiler.add_frame_sample(16.0f);
+
+    REQUIRE(profiler.samples()[0].second.size() == 1);
+  }
+}
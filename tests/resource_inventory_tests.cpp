@@ -0,0 +1,39 @@
+//
+// resource_inventory_tests.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <algorithm>
+#include "catch.hpp"
+#include "resource_inventory.h"
+
+using namespace BarelyEngine;
+
+TEST_CASE("ResourceInventory", "[resource_inventory]")
+{
+  SECTION("Memory adds up CPU and GPU bytes")
+  {
+    const ResourceMemory memory{1024, 2048};
+
+    REQUIRE(memory.total() == 3072);
+  }
+
+  SECTION("Formats a line of totals first")
+  {
+    const auto table = format_inventory("Textures", {{"a", "a.png", {1024, 2048}, 1.0, 3, 1},
+                                                     {"b", "b.png", {0, 1024}, 2.0, 4, 0}});
+
+    REQUIRE(table.substr(0, table.find('\n')) ==
+            "Textures: 2 resources, 4.0 KiB (CPU 1.0 KiB, GPU 3.0 KiB)");
+  }
+
+  SECTION("Formats a line for each resource, after the header")
+  {
+    const auto table = format_inventory("Textures", {{"a", "a.png", {1024, 2048}, 1.0, 3, 1},
+                                                     {"b", "b.png", {0, 1024}, 2.0, 4, 0}});
+
+    REQUIRE(std::count(table.begin(), table.end(), '\n') == 4);
+    REQUIRE(table.find("  a ") != std::string::npos);
+    REQUIRE(table.find("  b ") != std::string::npos);
+  }
+}
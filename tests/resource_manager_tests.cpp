@@ -3,9 +3,17 @@
 // Copyright (c) 2015 Adam Ransom
 //
 
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <vector>
 #include "catch.hpp"
 #include "fakeit.hpp"
 #include "resource_manager.h"
+#include "exception.h"
 
 using namespace BarelyEngine;
 using namespace fakeit;
@@ -14,6 +22,8 @@ using namespace fakeit;
  * Mock Resource, Loader and Options
  */
 struct MockResource {};
+/// Every mock resource uses 60 bytes of CPU and 40 bytes of GPU memory
+ResourceMemory resource_memory(const MockResource&) { return {60, 40}; }
 class MockResourceLoader : public ResourceLoader<MockResource, MockResourceLoader> {};
 template<> struct LoaderOptions<MockResourceLoader> { int size; };
 using MockLoaderOptions = LoaderOptions<MockResourceLoader>;
@@ -36,6 +46,9 @@ TEST_CASE("Resources", "[resource_manager]")
     .AlwaysDo([](const std::string& filename, const LoaderOptions<MockResourceLoader>& options){
       return std::make_unique<MockResource>();
     });
+  // Resources aren't shared unless a test says otherwise
+  When(Method(mock_loader, content_hash)).AlwaysReturn(0);
+  Fake(Method(mock_loader, discard_prefetched));
 
   SECTION("Loading")
   {
@@ -182,6 +195,39 @@ TEST_CASE("Resources", "[resource_manager]")
         Verify(Method(mock_loader, load).Using("test_resource", MockLoaderOptions{1})).Twice();
       }
     }
+
+    SECTION("Changed files")
+    {
+      SECTION("Calls `load` only for resources loaded from the files")
+      {
+        manager.load("test_resource_1");
+        manager.load("test_resource_2");
+        manager.load("test_resource_3");
+
+        REQUIRE(manager.reload_files({"test_resource_1", "test_resource_3"}) == 2);
+        Verify(Method(mock_loader, load).Using("test_resource_1", _)).Twice();
+        Verify(Method(mock_loader, load).Using("test_resource_2", _)).Once();
+        Verify(Method(mock_loader, load).Using("test_resource_3", _)).Twice();
+      }
+
+      SECTION("Calls `load` for every name loaded from a file, with its options")
+      {
+        manager.load("test_resource", "test_name_1", 1);
+        manager.load("test_resource", "test_name_2", 2);
+
+        REQUIRE(manager.reload_files({"test_resource"}) == 2);
+        Verify(Method(mock_loader, load).Using("test_resource", MockLoaderOptions{1})).Twice();
+        Verify(Method(mock_loader, load).Using("test_resource", MockLoaderOptions{2})).Twice();
+      }
+
+      SECTION("Doesn't call `load` for unknown files")
+      {
+        manager.load("test_resource");
+
+        REQUIRE(manager.reload_files({"other_resource"}) == 0);
+        Verify(Method(mock_loader, load)).Once();
+      }
+    }
   }
 
   SECTION("Retrieving Handle")
@@ -234,4 +280,348 @@ TEST_CASE("Resources", "[resource_manager]")
       REQUIRE(retrieved == nullptr);
     }
   }
+
+  SECTION("Budget")
+  {
+    SECTION("Counts the size of each resource")
+    {
+      manager.load("test_resource_1");
+      manager.load("test_resource_2");
+
+      REQUIRE(manager.resident_bytes() == 200);
+    }
+
+    SECTION("Unloads the least recently used resources without handles")
+    {
+      manager.set_budget(200);
+      manager.load("test_resource_1");
+      manager.load("test_resource_2");
+      manager.get("test_resource_1");
+      manager.load("test_resource_3");
+
+      REQUIRE(manager.count() == 2);
+      REQUIRE(manager.resident_bytes() == 200);
+      REQUIRE(manager.get(Resource<MockResource>("test_resource_2")) == nullptr);
+    }
+
+    SECTION("Doesn't unload resources with handles alive")
+    {
+      manager.set_budget(100);
+      const auto handle_1 = manager.load("test_resource_1");
+      const auto handle_2 = manager.load("test_resource_2");
+
+      REQUIRE(manager.count() == 2);
+      REQUIRE(manager.get(handle_1) != nullptr);
+      REQUIRE(manager.get(handle_2) != nullptr);
+    }
+
+    SECTION("Unloads resources once their handles are gone")
+    {
+      {
+        const auto handle_1 = manager.load("test_resource_1");
+        const auto handle_2 = manager.load("test_resource_2");
+        manager.set_budget(100);
+      }
+
+      manager.trim();
+
+      REQUIRE(manager.count() == 1);
+    }
+
+    SECTION("Loads unloaded resources again with their original options")
+    {
+      manager.set_budget(100);
+      manager.load("test_resource_1", "test_name_1", 1);
+      manager.load("test_resource_2", "test_name_2", 2);
+      const auto handle = manager.get("test_name_1");
+
+      REQUIRE(handle.is_null() == false);
+      REQUIRE(manager.get(handle) != nullptr);
+      Verify(Method(mock_loader, load).Using("test_resource_1", MockLoaderOptions{1})).Twice();
+    }
+  }
+
+  SECTION("Sharing identical resources")
+  {
+    When(Method(mock_loader, content_hash))
+      .AlwaysDo([](const std::string& filename, const MockLoaderOptions& options) {
+        return filename.compare(0, 4, "same") == 0 ? 42 : 0;
+      });
+
+    SECTION("Loads identical resources once, sharing them between names")
+    {
+      const auto handle_1 = manager.load("same_1");
+      const auto handle_2 = manager.load("same_2");
+
+      REQUIRE(manager.get(handle_1) == manager.get(handle_2));
+      Verify(Method(mock_loader, load)).Once();
+      Verify(Method(mock_loader, discard_prefetched).Using("same_2", _)).Once();
+    }
+
+    SECTION("Doesn't share resources which aren't identical")
+    {
+      const auto handle_1 = manager.load("same_1");
+      const auto handle_2 = manager.load("different");
+
+      REQUIRE(manager.get(handle_1) != manager.get(handle_2));
+    }
+
+    SECTION("Counts shared resources once")
+    {
+      manager.load("same_1");
+      manager.load("same_2");
+
+      REQUIRE(manager.resident_bytes() == 100);
+    }
+
+    SECTION("Keeps a shared resource while any name still has it")
+    {
+      manager.load("same_1");
+      const auto handle = manager.load("same_2");
+      manager.set_budget(0);
+
+      REQUIRE(manager.count() == 1);
+      REQUIRE(manager.get(handle) != nullptr);
+      REQUIRE(manager.resident_bytes() == 100);
+    }
+
+    SECTION("Loads a new copy when reloading")
+    {
+      const auto handle = manager.load("same_1");
+      const auto before = manager.get(handle);
+      manager.reload("same_1");
+
+      REQUIRE(manager.get(handle) != before);
+      Verify(Method(mock_loader, load)).Twice();
+    }
+  }
+
+  SECTION("Inventory")
+  {
+    SECTION("Lists every loaded resource with its memory")
+    {
+      manager.load("test_resource_1");
+      manager.load("test_resource_2", "test_name_2");
+      const auto inventory = manager.inventory();
+
+      REQUIRE(inventory.size() == 2);
+      for (const auto& info : inventory)
+      {
+        REQUIRE(info.memory.cpu == 60);
+        REQUIRE(info.memory.gpu == 40);
+      }
+    }
+
+    SECTION("Lists the filename each resource was loaded from")
+    {
+      manager.load("test_resource", "test_name");
+      const auto inventory = manager.inventory();
+
+      REQUIRE(inventory.front().name == "test_name");
+      REQUIRE(inventory.front().filename == "test_resource");
+    }
+
+    SECTION("Counts the handles alive")
+    {
+      const auto handle_1 = manager.load("test_resource");
+      const auto handle_2 = manager.get("test_resource");
+
+      REQUIRE(manager.inventory().front().references == 2);
+    }
+
+    SECTION("Records the frame each resource was last used on")
+    {
+      const auto handle = manager.load("test_resource");
+      manager.next_frame();
+      manager.next_frame();
+
+      REQUIRE(manager.inventory().front().last_used_frame == 0);
+
+      manager.get(handle);
+
+      REQUIRE(manager.frame() == 2);
+      REQUIRE(manager.inventory().front().last_used_frame == 2);
+    }
+
+    SECTION("Lists the memory of shared resources once")
+    {
+      When(Method(mock_loader, content_hash)).AlwaysReturn(42);
+      manager.load("test_resource_1");
+      manager.load("test_resource_2");
+      const auto inventory = manager.inventory();
+
+      REQUIRE(inventory[0].memory.total() == 100);
+      REQUIRE(inventory[1].memory.total() == 0);
+    }
+  }
+}
+
+/**
+ * Thread safe loader for prefetching (FakeIt mocks can't be called from
+ * several threads at once)
+ */
+class PrefetchLoader;
+template<> struct LoaderOptions<PrefetchLoader> { int size; };
+
+class PrefetchLoader : public ResourceLoader<MockResource, PrefetchLoader>
+{
+public:
+  std::unique_ptr<MockResource> load(const std::string& filename,
+                                     const LoaderOptions<PrefetchLoader>& options) override
+  {
+    loaded.push_back(filename);
+    load_count++;
+    return filename == "missing" ? nullptr : std::make_unique<MockResource>();
+  }
+
+  void prefetch(const std::string& filename, const LoaderOptions<PrefetchLoader>& options) override
+  {
+    if (filename == "broken")
+    {
+      throw Exception("Broken file");
+    }
+
+    std::this_thread::sleep_for(prefetch_time);
+
+    std::lock_guard<std::mutex> lock(mutex);
+    prefetched.push_back(filename);
+    prefetched_on[filename] = std::this_thread::get_id();
+
+    if (prefetched.size() > load_count)
+    {
+      lookahead = std::max(lookahead, prefetched.size() - load_count);
+    }
+  }
+
+  void discard_prefetched(const std::string& filename,
+                          const LoaderOptions<PrefetchLoader>& options) override
+  {
+    discarded.push_back(filename);
+  }
+
+  uint64_t content_hash(const std::string& filename,
+                        const LoaderOptions<PrefetchLoader>& options) override
+  {
+    {
+      std::lock_guard<std::mutex> lock(mutex);
+      hashed_on[filename] = std::this_thread::get_id();
+    }
+
+    // Files named "same..." are identical
+    return filename.compare(0, 4, "same") == 0 ? 1 : 0;
+  }
+
+  uint64_t prefetch_order(const std::string& filename) override
+  {
+    // Prefetch in reverse alphabetical order
+    return 255 - static_cast<uint8_t>(filename[0]);
+  }
+
+  std::vector<std::string> loaded;
+  std::vector<std::string> prefetched;
+  std::vector<std::string> discarded;
+  std::atomic<size_t> load_count{0};
+  size_t lookahead = 0;
+  std::mutex mutex;
+  std::chrono::milliseconds prefetch_time{0};
+  std::map<std::string, std::thread::id> prefetched_on;
+  std::map<std::string, std::thread::id> hashed_on;
+};
+
+TEST_CASE("Prefetching resources", "[resource_manager]")
+{
+  auto loader = std::make_shared<PrefetchLoader>();
+  ResourceManager<MockResource, PrefetchLoader> manager{loader};
+  ResourceManifest<PrefetchLoader> manifest;
+  JobSystem jobs{2};
+
+  manifest.add("a", "name_a");
+  manifest.add("c", "name_c");
+  manifest.add("b", "name_b");
+
+  SECTION("Prefetches and loads every resource")
+  {
+    REQUIRE(manager.prefetch(manifest, jobs) == 3);
+    REQUIRE(manager.count() == 3);
+    REQUIRE(loader->prefetched.size() == 3);
+    REQUIRE(manager.get("name_b").is_null() == false);
+  }
+
+  SECTION("Loads in the order the loader prefers")
+  {
+    manager.prefetch(manifest, jobs);
+
+    REQUIRE(loader->loaded == (std::vector<std::string>{"c", "b", "a"}));
+  }
+
+  SECTION("Skips resources which are already loaded")
+  {
+    manager.load("b", "name_b");
+
+    REQUIRE(manager.prefetch(manifest, jobs) == 2);
+    REQUIRE(loader->loaded.size() == 3);
+  }
+
+  SECTION("Doesn't count resources which fail to load")
+  {
+    manifest.add("missing", "name_missing");
+
+    REQUIRE(manager.prefetch(manifest, jobs) == 3);
+  }
+
+  SECTION("Reports progress")
+  {
+    std::vector<size_t> progress;
+
+    manager.prefetch(manifest, jobs, [&](size_t loaded, size_t total) {
+      REQUIRE(total == 3);
+      progress.push_back(loaded);
+    });
+
+    REQUIRE(progress == (std::vector<size_t>{1, 2, 3}));
+  }
+
+  SECTION("Rethrows exceptions from prefetching")
+  {
+    manifest.add("broken", "name_broken");
+
+    REQUIRE_THROWS_AS(manager.prefetch(manifest, jobs), Exception);
+  }
+
+  SECTION("Discards prefetched resources which are shared")
+  {
+    manifest.add("same_1", "name_same_1");
+    manifest.add("same_2", "name_same_2");
+
+    REQUIRE(manager.prefetch(manifest, jobs) == 5);
+    REQUIRE(loader->loaded.size() == 4);
+    REQUIRE(loader->discarded.size() == 1);
+  }
+
+  SECTION("Hashes each resource in the job which prefetched it")
+  {
+    // Slow enough that the workers take some of them
+    loader->prefetch_time = std::chrono::milliseconds(1);
+
+    for (int i = 0; i < 20; i++)
+    {
+      manifest.add("d" + std::to_string(i), "name_d" + std::to_string(i));
+    }
+
+    manager.prefetch(manifest, jobs);
+
+    REQUIRE(loader->hashed_on.size() == 23);
+    REQUIRE(loader->hashed_on == loader->prefetched_on);
+  }
+
+  SECTION("Doesn't prefetch too far ahead of loading")
+  {
+    for (int i = 0; i < 100; i++)
+    {
+      manifest.add("d" + std::to_string(i), "name_d" + std::to_string(i));
+    }
+
+    REQUIRE(manager.prefetch(manifest, jobs) == 103);
+    REQUIRE(loader->lookahead <= jobs.worker_count() * 2);
+  }
 }
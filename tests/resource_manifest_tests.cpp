@@ -0,0 +1,77 @@
+//
+// resource_manifest_tests.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <sstream>
+#include "catch.hpp"
+#include "resource_manifest.h"
+
+using namespace BarelyEngine;
+
+/**
+ * Loader with a couple of options, read from manifests
+ */
+class ManifestLoader;
+template<> struct LoaderOptions<ManifestLoader> { int size = 0; bool smooth = false; };
+
+bool read_option(LoaderOptions<ManifestLoader>& options, const std::string& key,
+                 const std::string& value)
+{
+  if (key == "size")
+  {
+    options.size = std::stoi(value);
+    return true;
+  }
+  else if (key == "smooth")
+  {
+    options.smooth = value == "true";
+    return true;
+  }
+
+  return false;
+}
+
+TEST_CASE("ResourceManifest", "[resource_manifest]")
+{
+  SECTION("Reads a resource on each line, using the filename as the name by default")
+  {
+    std::istringstream stream("a.png\nb.png b\n");
+    const auto manifest = ResourceManifest<ManifestLoader>::read(stream);
+
+    REQUIRE(manifest.size() == 2);
+    REQUIRE(manifest.entries()[0].filename == "a.png");
+    REQUIRE(manifest.entries()[0].name == "a.png");
+    REQUIRE(manifest.entries()[1].filename == "b.png");
+    REQUIRE(manifest.entries()[1].name == "b");
+  }
+
+  SECTION("Reads options")
+  {
+    std::istringstream stream("a.ttf a size=12 smooth=true\n");
+    const auto manifest = ResourceManifest<ManifestLoader>::read(stream);
+
+    REQUIRE(manifest.entries()[0].options.size == 12);
+    REQUIRE(manifest.entries()[0].options.smooth);
+  }
+
+  SECTION("Skips blank lines and comments")
+  {
+    std::istringstream stream("# Title screen\n\n   \na.png\n");
+    const auto manifest = ResourceManifest<ManifestLoader>::read(stream);
+
+    REQUIRE(manifest.size() == 1);
+  }
+
+  SECTION("Throws for unknown options")
+  {
+    std::istringstream stream("a.png colour=red\n");
+
+    REQUIRE_THROWS(ResourceManifest<ManifestLoader>::read(stream));
+  }
+
+  SECTION("Throws for a missing file")
+  {
+    REQUIRE_THROWS(ResourceManifest<ManifestLoader>::load("missing_manifest.txt"));
+  }
+}
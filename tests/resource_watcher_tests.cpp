@@ -0,0 +1,91 @@
+//
+// resource_watcher_tests.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <cstdio>
+#include <fstream>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "catch.hpp"
+#include "resource_watcher.h"
+
+using namespace BarelyEngine;
+
+namespace {
+const std::string kDirectory = "resource_watcher_test";
+
+void write_file(const std::string& path, const std::string& contents)
+{
+  std::ofstream file(path, std::ios::trunc);
+  file << contents;
+}
+
+/// Waits (for up to a couple of seconds) for the watcher to report changes
+std::vector<std::string> wait_for_changes(ResourceWatcher& watcher)
+{
+  for (int i = 0; i < 200; i++)
+  {
+    auto changed = watcher.changed();
+
+    if (!changed.empty())
+    {
+      return changed;
+    }
+
+    usleep(10000);
+  }
+
+  return {};
+}
+} // end of anonymous namespace
+
+TEST_CASE("ResourceWatcher", "[resource_watcher]")
+{
+  mkdir(kDirectory.c_str(), 0755);
+  mkdir((kDirectory + "/sub").c_str(), 0755);
+  write_file(kDirectory + "/a.png", "a");
+  write_file(kDirectory + "/sub/b.png", "b");
+
+  SECTION("Throws for a missing directory")
+  {
+    REQUIRE_THROWS(ResourceWatcher{kDirectory + "/missing"});
+  }
+
+  SECTION("Reports nothing when nothing changes")
+  {
+    ResourceWatcher watcher{kDirectory, std::chrono::milliseconds(10)};
+
+    usleep(50000);
+
+    REQUIRE(watcher.changed().empty());
+  }
+
+  SECTION("Reports changed files relative to the directory")
+  {
+    ResourceWatcher watcher{kDirectory, std::chrono::milliseconds(10)};
+
+    // Make sure the polling fallback sees a different size
+    write_file(kDirectory + "/sub/b.png", "changed");
+
+    REQUIRE(wait_for_changes(watcher) == std::vector<std::string>{"sub/b.png"});
+  }
+
+  SECTION("Reports a file once when it's written several times in a row")
+  {
+    ResourceWatcher watcher{kDirectory, std::chrono::milliseconds(100)};
+
+    write_file(kDirectory + "/a.png", "ab");
+    write_file(kDirectory + "/a.png", "abc");
+    write_file(kDirectory + "/a.png", "abcd");
+
+    REQUIRE(wait_for_changes(watcher) == std::vector<std::string>{"a.png"});
+    usleep(200000);
+    REQUIRE(watcher.changed().empty());
+  }
+
+  std::remove((kDirectory + "/sub/b.png").c_str());
+  std::remove((kDirectory + "/a.png").c_str());
+  rmdir((kDirectory + "/sub").c_str());
+  rmdir(kDirectory.c_str());
+}
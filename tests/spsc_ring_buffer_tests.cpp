@@ -0,0 +1,132 @@
+//
+// spsc_ring_buffer_tests.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include "catch.hpp"
+#include "spsc_ring_buffer.h"
+
+using namespace BarelyEngine;
+
+TEST_CASE("SpscRingBuffer", "[spsc_ring_buffer]")
+{
+  SpscRingBuffer<int, 4> buffer;
+
+  SECTION("Buffer is correct capacity")
+  {
+    REQUIRE(buffer.capacity() == 4);
+  }
+
+  SECTION("Heap allocations are aligned to a cache line")
+  {
+    std::unique_ptr<SpscRingBuffer<int, 4>> allocated{new SpscRingBuffer<int, 4>};
+
+    REQUIRE(reinterpret_cast<uintptr_t>(allocated.get()) % 64 == 0);
+  }
+
+  SECTION("Buffer has size 0 on initialization")
+  {
+    REQUIRE(buffer.size() == 0);
+    REQUIRE(buffer.empty());
+  }
+
+  SECTION("Buffer has size 1 after insert")
+  {
+    buffer.push_back(1);
+
+    REQUIRE(buffer.size() == 1);
+  }
+
+  SECTION("Front is correct item after 1 insert")
+  {
+    buffer.push_back(1);
+
+    REQUIRE(buffer.front() == 1);
+  }
+
+  SECTION("Push fails when full, rather than overwriting")
+  {
+    REQUIRE(buffer.push_back(1));
+    REQUIRE(buffer.push_back(2));
+    REQUIRE(buffer.push_back(3));
+    REQUIRE(buffer.push_back(4));
+    REQUIRE_FALSE(buffer.push_back(5));
+
+    REQUIRE(buffer.size() == 4);
+    REQUIRE(buffer.front() == 1);
+  }
+
+  SECTION("Pop returns items in order")
+  {
+    buffer.push_back(1);
+    buffer.push_back(2);
+
+    int value = 0;
+
+    REQUIRE(buffer.pop_front(value));
+    REQUIRE(value == 1);
+    REQUIRE(buffer.pop_front(value));
+    REQUIRE(value == 2);
+    REQUIRE_FALSE(buffer.pop_front(value));
+  }
+
+  SECTION("Bulk push and pop wrap around the end")
+  {
+    const int first[] = {1, 2, 3};
+    const int second[] = {4, 5, 6};
+    int popped[4] = {};
+
+    REQUIRE(buffer.push_back(first, 3) == 3);
+    REQUIRE(buffer.pop_front(popped, 2) == 2);
+    // Only 3 free slots are left
+    REQUIRE(buffer.push_back(second, 3) == 3);
+    REQUIRE(buffer.pop_front(popped, 4) == 4);
+
+    REQUIRE(popped[0] == 3);
+    REQUIRE(popped[1] == 4);
+    REQUIRE(popped[2] == 5);
+    REQUIRE(popped[3] == 6);
+    REQUIRE(buffer.empty());
+  }
+
+  SECTION("Values arrive in order across threads")
+  {
+    SpscRingBuffer<int, 1024> shared;
+    const int count = 100000;
+    bool in_order = true;
+
+    std::thread consumer([&shared, &in_order]() {
+      int expected = 0;
+      int value = 0;
+
+      while (expected < count)
+      {
+        if (shared.pop_front(value))
+        {
+          in_order = in_order && value == expected;
+          expected++;
+        }
+        else
+        {
+          std::this_thread::yield();
+        }
+      }
+    });
+
+    for (int i = 0; i < count; i++)
+    {
+      while (!shared.push_back(i))
+      {
+        std::this_thread::yield();
+      }
+    }
+
+    consumer.join();
+
+    REQUIRE(in_order);
+    REQUIRE(shared.empty());
+  }
+}
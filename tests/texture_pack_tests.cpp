@@ -0,0 +1,89 @@
+//
+// texture_pack_tests.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+
+#include <cstdio>
+#include <fstream>
+#include <vector>
+#include <OpenGL/gl3.h>
+#include "catch.hpp"
+#include "texture_pack.h"
+
+using namespace BarelyEngine;
+
+static const char* kPackPath = "texture_pack_tests.pack";
+
+void write_file(const std::vector<uint8_t>& contents)
+{
+  std::ofstream stream(kPackPath, std::ios::binary);
+  stream.write(reinterpret_cast<const char*>(contents.data()), contents.size());
+}
+
+TEST_CASE("TexturePack", "[texture_pack]")
+{
+  SECTION("Round trips uncompressed and compressed textures")
+  {
+    const std::vector<uint8_t> pixels(4 * 2 * 4, 0xAB);
+    const std::vector<MipLevel> mip_levels = {{2, 1, std::vector<uint8_t>(2 * 4, 0xCD)},
+                                              {1, 1, std::vector<uint8_t>(4, 0xEF)}};
+    const std::vector<uint8_t> blocks(16 + 16, 0x12);
+    const CompressedImage image(CompressedFormat::BC3, blocks, {{4, 4, 0, 16}, {2, 2, 16, 16}});
+
+    TexturePackWriter writer;
+    writer.add("sprites/player.png", 4, 2, GL_RGBA, pixels.data(), mip_levels);
+    writer.add("tiles.dds", image);
+    writer.save(kPackPath);
+
+    {
+      TexturePack pack(kPackPath);
+
+      REQUIRE(pack.size() == 2);
+      REQUIRE(pack.find("missing.png") == nullptr);
+
+      const auto player = pack.find("sprites/player.png");
+      REQUIRE(player != nullptr);
+      REQUIRE_FALSE(player->compressed);
+      REQUIRE(player->format == GL_RGBA);
+      REQUIRE(player->width == 4);
+      REQUIRE(player->height == 2);
+      REQUIRE(player->levels.size() == 3);
+      REQUIRE(player->levels.front().offset % TexturePack::kAlignment == 0);
+      REQUIRE(pack.data()[player->levels[0].offset] == 0xAB);
+      REQUIRE(pack.data()[player->levels[1].offset] == 0xCD);
+      REQUIRE(pack.data()[player->levels[2].offset + 3] == 0xEF);
+
+      const auto tiles = pack.find("tiles.dds");
+      REQUIRE(tiles != nullptr);
+      REQUIRE(tiles->compressed);
+      REQUIRE(tiles->compressed_format == CompressedFormat::BC3);
+      REQUIRE(tiles->levels.size() == 2);
+      REQUIRE(tiles->levels.front().offset % TexturePack::kAlignment == 0);
+      REQUIRE(pack.data()[tiles->levels[1].offset + 15] == 0x12);
+
+      pack.prefetch(*tiles);
+    }
+
+    std::remove(kPackPath);
+  }
+
+  SECTION("Throws exception for missing or invalid packs")
+  {
+    REQUIRE_THROWS(TexturePack{"missing.pack"});
+
+    write_file(std::vector<uint8_t>(64, 0));
+    REQUIRE_THROWS(TexturePack{kPackPath});
+
+    // Cut off the last texture's data
+    const std::vector<uint8_t> pixels(4 * 4, 0);
+    TexturePackWriter writer;
+    writer.add("texture.png", 2, 2, GL_BGRA, pixels.data());
+
+    auto contents = writer.contents();
+    contents.pop_back();
+    write_file(contents);
+    REQUIRE_THROWS(TexturePack{kPackPath});
+
+    std::remove(kPackPath);
+  }
+}
@@ -0,0 +1,111 @@
+//
+// tools/compress_texture.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+// Offline tool which compresses an image (anything SDL_image can load) to BC1
+// or BC3, along with a full chain of mipmaps, and writes it as a DDS or KTX2
+// file, ready for the TextureLoader.
+//
+// Usage: compress_texture <input.png> <output.dds|output.ktx2> [bc1|bc3]
+//
+// BC3 is the default, since it keeps full alpha. BC7 and ETC2 files can be
+// loaded by the engine too, but need a dedicated encoder to produce them.
+//
+
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include <vector>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include "block_compressor.h"
+#include "compressed_image.h"
+#include "mip_chain.h"
+#include "exception.h"
+
+using namespace BarelyEngine;
+
+namespace {
+bool ends_with(const std::string& string, const std::string& suffix)
+{
+  return string.size() >= suffix.size() &&
+         string.compare(string.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+} // end of anonymous namespace
+
+int main(int argc, char* argv[])
+{
+  if (argc < 3)
+  {
+    std::fprintf(stderr, "Usage: %s <input> <output.dds|output.ktx2> [bc1|bc3]\n", argv[0]);
+    return 1;
+  }
+
+  const std::string input = argv[1];
+  const std::string output = argv[2];
+  const std::string format_name = argc > 3 ? argv[3] : "bc3";
+
+  if (format_name != "bc1" && format_name != "bc3")
+  {
+    std::fprintf(stderr, "Unknown format '%s' (expected bc1 or bc3)\n", format_name.c_str());
+    return 1;
+  }
+
+  const auto format = format_name == "bc1" ? CompressedFormat::BC1 : CompressedFormat::BC3;
+  const auto loaded = IMG_Load(input.c_str());
+
+  if (loaded == nullptr)
+  {
+    std::fprintf(stderr, "Couldn't load '%s' (%s)\n", input.c_str(), IMG_GetError());
+    return 1;
+  }
+
+  // ABGR8888 is stored as the bytes R, G, B, A on little-endian machines
+  const auto surface = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_ABGR8888, 0);
+  SDL_FreeSurface(loaded);
+
+  if (surface == nullptr)
+  {
+    std::fprintf(stderr, "Couldn't convert '%s' (%s)\n", input.c_str(), SDL_GetError());
+    return 1;
+  }
+
+  try
+  {
+    // 4-byte pixels never need padding, so the surface is tightly packed
+    const auto pixels = static_cast<const uint8_t*>(surface->pixels);
+    const auto mip_levels = MipChain::generate(pixels, surface->w, surface->h, MipFilter::KAISER);
+
+    auto blocks = BlockCompressor::compress(pixels, surface->w, surface->h, format);
+    std::vector<CompressedLevel> levels = {{surface->w, surface->h, 0, blocks.size()}};
+
+    for (const auto& level : mip_levels)
+    {
+      const auto level_blocks =
+        BlockCompressor::compress(level.pixels.data(), level.width, level.height, format);
+
+      levels.push_back({level.width, level.height, blocks.size(), level_blocks.size()});
+      blocks.insert(blocks.end(), level_blocks.begin(), level_blocks.end());
+    }
+
+    const CompressedImage image(format, std::move(blocks), std::move(levels));
+    const auto file = ends_with(output, ".ktx2") ? image.to_ktx2() : image.to_dds();
+    std::ofstream stream(output, std::ios::binary);
+    stream.write(reinterpret_cast<const char*>(file.data()), file.size());
+
+    if (!stream)
+    {
+      throw Exception("Couldn't write '" + output + "'");
+    }
+  }
+  catch (Exception& e)
+  {
+    std::fprintf(stderr, "%s\n", e.what());
+    SDL_FreeSurface(surface);
+    return 1;
+  }
+
+  SDL_FreeSurface(surface);
+
+  return 0;
+}
@@ -0,0 +1,116 @@
+//
+// tools/pack_textures.cpp
+// Copyright (c) 2015 Adam Ransom
+//
+// Offline tool which packs textures into a single TexturePack file. Images
+// are decoded to 4-byte pixels (with mipmaps, if asked for) and DDS/KTX2 files
+// are packed as they are, so every texture is ready to upload straight from
+// the pack.
+//
+// Usage: pack_textures [--mipmaps] <output.pack> <root> <files...>
+//
+// Files are given relative to the root and are packed under those names, so
+// with a root of `resources/textures` they match the names passed to the
+// TextureLoader.
+//
+
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <SDL2/SDL.h>
+#include <SDL2/SDL_image.h>
+#include <OpenGL/gl3.h>
+#include "compressed_image.h"
+#include "exception.h"
+#include "mip_chain.h"
+#include "texture_pack.h"
+
+using namespace BarelyEngine;
+
+namespace {
+bool ends_with(const std::string& string, const std::string& suffix)
+{
+  return string.size() >= suffix.size() &&
+         string.compare(string.size() - suffix.size(), suffix.size(), suffix) == 0;
+}
+
+/**
+ * @brief Decodes an image with SDL_image and adds its pixels to the pack
+ */
+void add_image(TexturePackWriter& writer, const std::string& name, const std::string& path,
+               const bool mipmaps)
+{
+  const auto loaded = IMG_Load(path.c_str());
+
+  if (loaded == nullptr)
+  {
+    throw Exception("Couldn't load '" + path + "' (" + IMG_GetError() + ")");
+  }
+
+  // ABGR8888 is stored as the bytes R, G, B, A on little-endian machines
+  const auto surface = SDL_ConvertSurfaceFormat(loaded, SDL_PIXELFORMAT_ABGR8888, 0);
+  SDL_FreeSurface(loaded);
+
+  if (surface == nullptr)
+  {
+    throw Exception("Couldn't convert '" + path + "' (" + SDL_GetError() + ")");
+  }
+
+  // 4-byte pixels never need padding, so the surface is tightly packed
+  const auto pixels = static_cast<const uint8_t*>(surface->pixels);
+  const auto mip_levels =
+    mipmaps ? MipChain::generate(pixels, surface->w, surface->h) : std::vector<MipLevel>();
+
+  writer.add(name, surface->w, surface->h, GL_RGBA, pixels, mip_levels);
+  SDL_FreeSurface(surface);
+}
+} // end of anonymous namespace
+
+int main(int argc, char* argv[])
+{
+  auto arg = 1;
+  const auto mipmaps = argc > 1 && std::strcmp(argv[1], "--mipmaps") == 0;
+
+  if (mipmaps)
+  {
+    arg++;
+  }
+
+  if (argc - arg < 3)
+  {
+    std::fprintf(stderr, "Usage: %s [--mipmaps] <output.pack> <root> <files...>\n", argv[0]);
+    return 1;
+  }
+
+  const std::string output = argv[arg++];
+  const std::string root = argv[arg++];
+
+  try
+  {
+    TexturePackWriter writer;
+
+    for (; arg < argc; arg++)
+    {
+      const std::string name = argv[arg];
+      const auto path = root + "/" + name;
+
+      if (ends_with(name, ".dds") || ends_with(name, ".ktx2"))
+      {
+        writer.add(name, *CompressedImage::load(path));
+      }
+      else
+      {
+        add_image(writer, name, path, mipmaps);
+      }
+    }
+
+    writer.save(output);
+  }
+  catch (Exception& e)
+  {
+    std::fprintf(stderr, "%s\n", e.what());
+    return 1;
+  }
+
+  return 0;
+}